@@ -29,7 +29,7 @@ namespace m3d {
 
     private:
         /* data */
-        m3d::Mutex m_mutex;
+        m3d::Mutex& m_mutex;
     };
 } /* m3d */
 
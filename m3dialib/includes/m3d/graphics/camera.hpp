@@ -10,6 +10,11 @@
 #include "vertex.hpp"
 
 namespace m3d {
+    /**
+     * @brief A camera, defining the view of a screen
+     *
+     * The view matrix and the projection matrices get cached and only get recalculated if the camera changed.
+     */
     class Camera {
     public:
         /**
@@ -158,15 +163,125 @@ namespace m3d {
         void moveZ(float t_delta);
 
         /**
-         * @brief Returns a reference to the view matrix of the camera and applies all calculations to it
+         * @brief Returns the position of the camera in the coordinate system of the model matrices
+         * @return The position of the eye
+         *
+         * Unlike getPositionX() etc., this is the actual point the scene gets viewed from, so it can be used to measure distances to the objects in the scene (e.g. by m3d::LodGroup).
+         */
+        m3d::Vector3f getEyePosition();
+
+        /**
+         * @brief Sets the orientation of the camera
+         * @param t_orientation The orientation, represented as a quaternion
+         *
+         * Unlike the euler angles, quaternions don't suffer from gimbal lock. The euler angles returned by getPitch(), getYaw() and getRoll() get derived from the orientation.
+         */
+        void setOrientation(C3D_FQuat t_orientation);
+
+        /**
+         * @brief Returns the orientation of the camera
+         * @return The orientation, represented as a quaternion
+         */
+        C3D_FQuat getOrientation();
+
+        /**
+         * @brief Rotates the camera around an axis
+         * @param t_axis    The axis to rotate around (in view space)
+         * @param t_angle   The amount to rotate
+         * @param t_radians Whether to use radians instead of degrees
+         */
+        void rotate(m3d::Vector3f t_axis, float t_angle, bool t_radians = false);
+
+        /**
+         * @brief Turns the camera towards a point
+         * @param t_target The point to look at (in the same coordinates as the positions of meshes)
+         * @param t_up     The direction that should be up
+         */
+        void lookAt(m3d::Vector3f t_target, m3d::Vector3f t_up = { 0.0f, 1.0f, 0.0f });
+
+        /**
+         * @brief Sets the vertical field of view
+         * @param t_fieldOfView The field of view
+         * @param t_radians     Whether to use radians instead of degrees
+         * @note The default field of view is 40 degrees
+         */
+        void setFieldOfView(float t_fieldOfView, bool t_radians = false);
+
+        /**
+         * @brief Returns the vertical field of view
+         * @param  t_radians Whether to use radians instead of degrees
+         * @return           The field of view
+         */
+        float getFieldOfView(bool t_radians = false);
+
+        /**
+         * @brief Sets the distances of the near and far clipping planes
+         * @param t_near The distance of the near plane
+         * @param t_far  The distance of the far plane
+         * @note The default planes are at 0.01 and 1000
+         */
+        void setClipPlanes(float t_near, float t_far);
+
+        /**
+         * @brief Returns the distance of the near clipping plane
+         * @return The distance
+         */
+        float getNearPlane();
+
+        /**
+         * @brief Returns the distance of the far clipping plane
+         * @return The distance
+         */
+        float getFarPlane();
+
+        /**
+         * @brief Returns a reference to the view matrix of the camera
          * @return The view matrix
+         * @note The matrix only gets recalculated if the camera moved or turned since the last call
          */
         C3D_Mtx& getViewMatrix();
 
+        /**
+         * @brief Returns a reference to the projection matrix of the camera
+         * @param  t_aspectRatio The aspect ratio of the screen
+         * @param  t_eyeOffset   The horizontal offset of the eye for stereoscopic 3D (0 for the center)
+         * @return               The projection matrix
+         * @note The matrices for the last two combinations of parameters (e.g. both eyes) get cached
+         */
+        C3D_Mtx& getProjectionMatrix(float t_aspectRatio, float t_eyeOffset = 0.0f);
+
+        /**
+         * @brief Returns a reference to the product of the projection and the view matrix of the camera
+         * @param  t_aspectRatio The aspect ratio of the screen
+         * @param  t_eyeOffset   The horizontal offset of the eye for stereoscopic 3D (0 for the center)
+         * @return               The view-projection matrix
+         *
+         * This is the matrix needed to build view frustums (see m3d::Frustum) and to project points onto the screen.
+         */
+        C3D_Mtx& getViewProjectionMatrix(float t_aspectRatio, float t_eyeOffset = 0.0f);
+
     private:
+        struct Projection {
+            float aspectRatio, eyeOffset;
+            bool valid, viewProjectionValid;
+            C3D_Mtx projection, viewProjection;
+        };
+
+        m3d::Camera::Projection& getProjection(float t_aspectRatio, float t_eyeOffset);
+        void updateOrientation();
+        void updateAngles();
+        void invalidateView();
+
         /* data */
         float m_posX, m_posY, m_posZ, m_rotationX, m_rotationY, m_rotationZ;
+        float m_fieldOfView, m_near, m_far;
+        C3D_FQuat m_orientation;
+        bool m_viewDirty;
         C3D_Mtx m_view;
+
+        // the projections of the last two combinations of parameters
+        m3d::Camera::Projection m_projections[2];
+        unsigned int m_nextProjection;
     };
 } /* m3d */
 
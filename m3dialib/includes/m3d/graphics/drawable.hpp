@@ -7,7 +7,9 @@
 
 #pragma once
 #include <citro3d.h>
+#include "frustum.hpp"
 #include "renderContext.hpp"
+#include "vertex.hpp"
 
 namespace m3d {
     /**
@@ -24,6 +26,36 @@ namespace m3d {
          * Implement this function in your own class to draw stuff on the screen using Citro3D/2D-functions.
          */
         virtual void draw(m3d::RenderContext t_context) = 0;
+
+        /**
+         * @brief Returns a key describing the GPU state (texture, material, ...) the drawable needs
+         * @return The state key
+         *
+         * Within a layer, opaque spatial drawables (whose key contains m3d::Drawable::OpaqueStateBit) get sorted by this key so objects sharing the same state get drawn one after another and redundant state changes can be skipped. As blending depends on the drawing order, all other drawables keep their position relative to the other objects. Return `0` (the default) if the drawable sets its own state.
+         */
+        virtual u64 getStateKey() { return 0; }
+
+        /**
+         * @brief The bit of a state key marking the drawable as fully opaque, which allows it to be drawn in any order (see getStateKey())
+         */
+        static const u64 OpaqueStateBit = 1ull << 61;
+
+        /**
+         * @brief Returns whether the drawable is (partially) inside of the given view frustum
+         * @param  t_frustum The view frustum
+         * @return           `false` if the drawable is entirely outside of the frustum and can be culled, `true` otherwise
+         *
+         * This gets called for spatial drawables before drawing them. By default, drawables are never culled.
+         */
+        virtual bool isVisible(m3d::Frustum& t_frustum) { return true; }
+
+        /**
+         * @brief Selects the level of detail to draw
+         * @param t_eyePosition The position of the camera (see m3d::Camera::getEyePosition())
+         *
+         * This gets called once per frame for spatial drawables, before they get sorted and culled, so drawables can adapt to their distance to the camera (see m3d::LodGroup). By default, drawables only have a single level of detail.
+         */
+        virtual void selectLevelOfDetail(const m3d::Vector3f& t_eyePosition) { /* do nothing */ }
     };
 } /* m3d */
 
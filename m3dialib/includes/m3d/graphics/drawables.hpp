@@ -8,10 +8,13 @@
 #pragma once
 
 #include "drawables/circle.hpp"
+#include "drawables/instanceGroup.hpp"
+#include "drawables/lodGroup.hpp"
 #include "drawables/mesh.hpp"
 #include "drawables/rectangle.hpp"
 #include "drawables/shape.hpp"
 #include "drawables/sprite.hpp"
+#include "drawables/spriteBatch.hpp"
 #include "drawables/triangle.hpp"
 #include "drawables/text.hpp"
 
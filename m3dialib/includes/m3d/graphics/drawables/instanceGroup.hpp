@@ -0,0 +1,139 @@
+/**
+ * @file instanceGroup.hpp
+ * @brief Defines the InstanceGroup class used to draw many copies of one mesh
+ */
+#ifndef INSTANCEGROUP_H
+#define INSTANCEGROUP_H
+
+#pragma once
+#include <citro3d.h>
+#include <vector>
+#include "m3d/graphics/color.hpp"
+#include "m3d/graphics/drawable.hpp"
+#include "m3d/graphics/drawables/mesh.hpp"
+#include "m3d/graphics/vertex.hpp"
+
+namespace m3d {
+    /**
+     * @brief Draws many copies (instances) of one mesh, each with its own transformation and tint
+     *
+     * All instances share the vertex buffer, material and texture of the mesh, which get bound only once. The transformations of the instances get uploaded in batches of up to m3d::RenderContext::MaxInstances matrices and the instances get drawn back-to-back without any state changes in between.
+     *
+     * @note The transformation of the instances replaces the transformation of the mesh itself
+     * @note The mesh has to outlive the instance group
+     */
+    class InstanceGroup: public m3d::Drawable {
+    public:
+        /**
+         * @brief Creates the instance group
+         * @param t_mesh The mesh to draw
+         */
+        InstanceGroup(m3d::Mesh& t_mesh);
+
+        /**
+         * @brief Sets the mesh to draw
+         * @param t_mesh The mesh
+         */
+        void setMesh(m3d::Mesh& t_mesh);
+
+        /**
+         * @brief Returns the mesh that gets drawn
+         * @return The mesh
+         */
+        m3d::Mesh& getMesh();
+
+        /**
+         * @brief Adds an instance
+         * @param  t_position The position of the instance
+         * @param  t_rotation The rotation of the instance (pitch, yaw and roll)
+         * @param  t_scale    The scale of the instance
+         * @param  t_radians  Whether to use radians instead of degrees
+         * @return            The id of the instance
+         */
+        unsigned int addInstance(m3d::Vector3f t_position, m3d::Vector3f t_rotation = { 0.0f, 0.0f, 0.0f }, m3d::Vector3f t_scale = { 1.0f, 1.0f, 1.0f }, bool t_radians = false);
+
+        /**
+         * @brief Adds an instance given its model matrix
+         * @param  t_transform The model matrix of the instance
+         * @return             The id of the instance
+         * @note The last row of the matrix gets ignored, it's always treated as (0, 0, 0, 1)
+         */
+        unsigned int addInstance(const C3D_Mtx& t_transform);
+
+        /**
+         * @brief Sets the transformation of an instance
+         * @param t_id       The id of the instance
+         * @param t_position The position of the instance
+         * @param t_rotation The rotation of the instance (pitch, yaw and roll)
+         * @param t_scale    The scale of the instance
+         * @param t_radians  Whether to use radians instead of degrees
+         */
+        void setInstance(unsigned int t_id, m3d::Vector3f t_position, m3d::Vector3f t_rotation = { 0.0f, 0.0f, 0.0f }, m3d::Vector3f t_scale = { 1.0f, 1.0f, 1.0f }, bool t_radians = false);
+
+        /**
+         * @brief Sets the model matrix of an instance
+         * @param t_id        The id of the instance
+         * @param t_transform The model matrix of the instance
+         */
+        void setInstance(unsigned int t_id, const C3D_Mtx& t_transform);
+
+        /**
+         * @brief Sets the tint of an instance
+         * @param t_id    The id of the instance
+         * @param t_color The color the instance gets multiplied with
+         * @note By default, instances aren't tinted (their tint is white)
+         */
+        void setInstanceTint(unsigned int t_id, m3d::Color t_color);
+
+        /**
+         * @brief Removes an instance
+         * @param t_id The id of the instance
+         * @note The ids of all instances added after the removed one decrease by one
+         */
+        void removeInstance(unsigned int t_id);
+
+        /**
+         * @brief Removes all instances
+         */
+        void clearInstances();
+
+        /**
+         * @brief Returns the number of instances
+         * @return The number of instances
+         */
+        unsigned int getInstanceCount();
+
+        /**
+         * @brief Draws all instances
+         * @param t_context The RenderContext
+         */
+        void draw(m3d::RenderContext t_context);
+
+        /**
+         * @brief Returns whether any of the instances is (partially) inside of the given frustum
+         * @param  t_frustum The frustum
+         * @return           `false` if all instances are entirely outside of the frustum, `true` otherwise
+         */
+        bool isVisible(m3d::Frustum& t_frustum);
+
+        /**
+         * @brief Returns the state key of the mesh
+         * @return The state key
+         */
+        u64 getStateKey();
+
+    private:
+        void setMatrix(unsigned int t_id, const C3D_Mtx& t_transform);
+
+        /* data */
+        m3d::Mesh* m_mesh;
+        bool m_tinted;
+
+        // three rows of the model matrix per instance, so batches can be uploaded at once
+        std::vector<C3D_FVec> m_matrices;
+        std::vector<C3D_FVec> m_tints;
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: INSTANCEGROUP_H */
@@ -0,0 +1,130 @@
+/**
+ * @file lodGroup.hpp
+ * @brief Defines the LodGroup class used to draw meshes with multiple levels of detail
+ */
+#ifndef LODGROUP_H
+#define LODGROUP_H
+
+#pragma once
+#include <citro3d.h>
+#include <vector>
+#include "m3d/graphics/drawable.hpp"
+#include "m3d/graphics/drawables/mesh.hpp"
+#include "m3d/graphics/vertex.hpp"
+
+namespace m3d {
+    /**
+     * @brief Draws one of several versions (levels of detail) of an object, depending on its distance to the camera
+     *
+     * Every level is a mesh that gets drawn starting at a given distance, so objects far away from the camera can be drawn with fewer triangles. The level gets selected once per frame by m3d::Screen, before the objects get sorted and culled.
+     *
+     * The distance gets measured from the camera to the center of the first level. All levels should therefore share the same transformation, e.g. by attaching them to the same m3d::SceneNode.
+     *
+     * @note The meshes have to outlive the group
+     */
+    class LodGroup: public m3d::Drawable {
+    public:
+        /**
+         * @brief Creates the group
+         */
+        LodGroup();
+
+        /**
+         * @brief Adds a level of detail
+         * @param t_mesh     The mesh to draw
+         * @param t_distance The distance from which on the mesh gets drawn (up to the distance of the next level)
+         *
+         * The levels get sorted by their distances, the level with the smallest distance should be the most detailed one. It also gets drawn when the object is closer than its distance.
+         */
+        void addLevel(m3d::Mesh& t_mesh, float t_distance);
+
+        /**
+         * @brief Removes all levels
+         */
+        void clearLevels();
+
+        /**
+         * @brief Returns the number of levels
+         * @return The number of levels
+         */
+        unsigned int getLevelCount();
+
+        /**
+         * @brief Returns the mesh of a level
+         * @param  t_level The index of the level (0 is the one with the smallest distance)
+         * @return         The mesh (or nullptr if the index is out of range)
+         */
+        m3d::Mesh* getLevel(unsigned int t_level);
+
+        /**
+         * @brief Returns the level that was selected for the current frame
+         * @return The index of the level (or -1 if the group is beyond its draw distance or doesn't have any levels)
+         */
+        int getCurrentLevel();
+
+        /**
+         * @brief Sets the hysteresis of the level switches
+         * @param t_hysteresis The hysteresis, relative to the switch distances (e.g. 0.1 for 10%)
+         *
+         * A switch to a coarser level only happens once the object is further away than the switch distance by this fraction, a switch back only once it's closer by this fraction. This prevents objects near a switch distance from flickering between two levels. The default hysteresis is 0.
+         */
+        void setHysteresis(float t_hysteresis);
+
+        /**
+         * @brief Returns the hysteresis of the level switches
+         * @return The hysteresis
+         */
+        float getHysteresis();
+
+        /**
+         * @brief Sets the distance from which on the group doesn't get drawn at all
+         * @param t_distance The distance (or 0 to draw the group at any distance)
+         */
+        void setDrawDistance(float t_distance);
+
+        /**
+         * @brief Returns the distance from which on the group doesn't get drawn at all
+         * @return The distance (0 if the group gets drawn at any distance)
+         */
+        float getDrawDistance();
+
+        /**
+         * @brief Draws the selected level
+         * @param t_context The RenderContext
+         */
+        void draw(m3d::RenderContext t_context);
+
+        /**
+         * @brief Returns whether the selected level is (partially) inside of the given frustum
+         * @param  t_frustum The frustum
+         * @return           `false` if the selected level is entirely outside of the frustum (or the group is beyond its draw distance), `true` otherwise
+         */
+        bool isVisible(m3d::Frustum& t_frustum);
+
+        /**
+         * @brief Returns the state key of the selected level
+         * @return The state key
+         */
+        u64 getStateKey();
+
+        /**
+         * @brief Selects the level to draw
+         * @param t_eyePosition The position of the camera
+         */
+        void selectLevelOfDetail(const m3d::Vector3f& t_eyePosition);
+
+    private:
+        struct Level {
+            m3d::Mesh* mesh;
+            float distance;
+        };
+
+        /* data */
+        std::vector<m3d::LodGroup::Level> m_levels;
+        int m_level;
+        float m_hysteresis, m_drawDistance;
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: LODGROUP_H */
@@ -6,19 +6,27 @@
 #define MESH_H
 
 #pragma once
+#include <memory>
 #include <tuple>
 #include <vector>
 #include "m3d/graphics/color.hpp"
 #include "m3d/graphics/drawable.hpp"
 #include "m3d/graphics/material.hpp"
+#include "m3d/graphics/sceneNode.hpp"
 #include "m3d/graphics/texture.hpp"
 #include "m3d/graphics/vertex.hpp"
 
 namespace m3d {
+    class InstanceGroup;
+    class LodGroup;
+
     /**
      * @brief The base class for all meshes
      */
     class Mesh: public m3d::Drawable {
+        friend class m3d::InstanceGroup;
+        friend class m3d::LodGroup;
+
     public:
         /**
          * @brief Defines a polygon used by meshes
@@ -62,15 +70,78 @@ namespace m3d {
             m3d::Mesh::Polygon::Vertex m_vertices[3];
         };
 
+        /**
+         * @brief Defines the formats vertices get stored in on the GPU
+         */
+        enum class VertexFormat {
+            Float,  ///< 32 bytes per vertex, floating point positions, texture coordinates and normals
+            Compact ///< 16 bytes per vertex, 16-bit positions and texture coordinates (quantized to the bounds of the mesh) and 8-bit normals
+        };
+
+        /**
+         * @brief The geometry of a mesh (its vertices and the GPU buffers holding them)
+         *
+         * Geometry can be shared between any number of meshes (see m3d::Mesh::setGeometry() and m3d::MeshCache), which then only store their own transformation, material and texture. Modifying the vertices of a mesh whose geometry is shared gives the mesh its own copy first, so shared geometry never changes.
+         */
+        struct Geometry {
+            std::vector<m3d::Mesh::Polygon::Vertex> vertices; ///< The (unique) vertices
+            std::vector<unsigned int> indices;                ///< The vertex indices of the triangles
+            void* vbo;                                        ///< The vertex buffer (in linear memory)
+            u16* ibo;                                         ///< The index buffer (in linear memory, nullptr if the vertex buffer isn't indexed)
+            unsigned int vboSize;                             ///< The number of vertices in the vertex buffer
+            unsigned int iboSize;                             ///< The number of indices in the index buffer
+            unsigned int vboCapacity;                         ///< The allocated size of the vertex buffer in bytes
+            unsigned int iboCapacity;                         ///< The allocated size of the index buffer in bytes
+            unsigned int dirtyBegin;                          ///< The first vertex that changed since the vertex buffer was updated
+            unsigned int dirtyEnd;                            ///< The vertex after the last one that changed since the vertex buffer was updated
+            m3d::Mesh::VertexFormat format;                   ///< The format of the vertex buffer
+            C3D_AttrInfo attributeInfo;                       ///< The attribute information matching the format
+            C3D_FVec quantization[3];                         ///< The quantization of the vertex buffer (see m3d::RenderContext::getQuantizationUniform())
+            m3d::Vector3f boundingMin;                        ///< The minimum corner of the bounding box
+            m3d::Vector3f boundingMax;                        ///< The maximum corner of the bounding box
+            float boundingRadius;                             ///< The radius of the bounding sphere
+            bool cached;                                      ///< Whether the geometry is in the m3d::MeshCache (meshes copy it before changing it then)
+
+            /**
+             * @brief Initializes empty geometry
+             */
+            Geometry();
+
+            /**
+             * @brief Frees the GPU buffers
+             */
+            ~Geometry();
+
+            Geometry(const m3d::Mesh::Geometry&) = delete;
+            m3d::Mesh::Geometry& operator=(const m3d::Mesh::Geometry&) = delete;
+        };
+
         /**
          * @brief Initializes the mesh
          */
         Mesh();
 
         /**
-         * @brief Destructor
+         * @brief Returns the geometry of the mesh
+         * @return A shared handle to the geometry
+         */
+        std::shared_ptr<m3d::Mesh::Geometry> getGeometry();
+
+        /**
+         * @brief Makes the mesh use the given geometry
+         * @param t_geometry The geometry to use (or nullptr to use empty geometry)
+         *
+         * The geometry gets shared instead of being copied, so any number of meshes can use the same vertex buffer. Copies of a mesh share its geometry as well.
+         */
+        void setGeometry(std::shared_ptr<m3d::Mesh::Geometry> t_geometry);
+
+        /**
+         * @brief Returns whether the geometry of the mesh is shared with other meshes or cached (see m3d::MeshCache)
+         * @return `true` if the geometry is shared, `false` otherwise
+         *
+         * Shared geometry never gets changed, changing the vertices (or the vertex format) of a mesh using it gives the mesh its own copy first.
          */
-        ~Mesh();
+        bool isGeometryShared();
 
         /**
          * @brief Adds a polygon to the mesh
@@ -78,11 +149,143 @@ namespace m3d {
          */
         void addPolygon(m3d::Mesh::Polygon t_polygon);
 
+        /**
+         * @brief Adds a single vertex to the mesh
+         * @param  t_vertex The vertex to add
+         * @return          The index of the vertex, used to reference it in m3d::Mesh::addTriangle()
+         */
+        unsigned int addVertex(const m3d::Mesh::Polygon::Vertex& t_vertex);
+
+        /**
+         * @brief Adds a triangle made up of three vertices added using m3d::Mesh::addVertex()
+         * @param t_index0 The index of the first vertex
+         * @param t_index1 The index of the second vertex
+         * @param t_index2 The index of the third vertex
+         */
+        void addTriangle(unsigned int t_index0, unsigned int t_index1, unsigned int t_index2);
+
+        /**
+         * @brief Replaces all vertices and triangles of the mesh at once
+         * @param t_vertices The vertices
+         * @param t_indices  The vertex indices of the triangles (three per triangle)
+         *
+         * The vectors get moved into the mesh, so the vertices don't get copied. This is much faster than adding the vertices one by one using m3d::Mesh::addVertex().
+         *
+         * @note All indices have to be smaller than the number of vertices
+         */
+        void setVertices(std::vector<m3d::Mesh::Polygon::Vertex>&& t_vertices, std::vector<unsigned int>&& t_indices);
+
+        /**
+         * @brief Replaces all vertices and triangles of the mesh at once
+         * @param t_vertices    The vertices
+         * @param t_vertexCount The number of vertices
+         * @param t_indices     The vertex indices of the triangles (three per triangle)
+         * @param t_indexCount  The number of indices
+         * @note All indices have to be smaller than the number of vertices
+         */
+        void setVertices(const m3d::Mesh::Polygon::Vertex* t_vertices, unsigned int t_vertexCount, const unsigned int* t_indices, unsigned int t_indexCount);
+
+        /**
+         * @brief Returns a vertex of the mesh
+         * @param  t_index The index of the vertex
+         * @return         The vertex
+         */
+        m3d::Mesh::Polygon::Vertex getVertex(unsigned int t_index);
+
+        /**
+         * @brief Changes a single vertex of the mesh
+         * @param t_index  The index of the vertex
+         * @param t_vertex The new vertex
+         * @see m3d::Mesh::updateVertices()
+         */
+        void setVertex(unsigned int t_index, const m3d::Mesh::Polygon::Vertex& t_vertex);
+
+        /**
+         * @brief Changes a range of vertices of the mesh
+         * @param t_first    The index of the first vertex to change
+         * @param t_vertices The new vertices
+         * @param t_count    The number of vertices to change
+         *
+         * Only the changed vertices get written to the vertex buffer (the next time the mesh gets drawn), without reallocating it, so meshes can be animated on the CPU every frame.
+         *
+         * @note The indices refer to the vertices after identical vertices got merged (see m3d::Mesh::getVertexCount())
+         * @note Moving vertices of compact meshes outside of their bounds makes all vertices get written again, as they need to be quantized to the new bounds
+         */
+        void updateVertices(unsigned int t_first, const m3d::Mesh::Polygon::Vertex* t_vertices, unsigned int t_count);
+
+        /**
+         * @brief Returns the number of (unique) vertices of the mesh
+         * @return The number of vertices
+         * @note Identical vertices get merged when the vertex buffer gets updated
+         */
+        unsigned int getVertexCount();
+
+        /**
+         * @brief Returns the number of triangles of the mesh
+         * @return The number of triangles
+         */
+        unsigned int getTriangleCount();
+
         /**
          * @brief Removes all vertices
          */
         void clearVertices();
 
+        /**
+         * @brief Reduces the number of triangles of the mesh
+         * @param  t_ratio    The share of triangles to keep (e.g. 0.5 for half of them)
+         * @param  t_maxError The maximum deviation from the original shape, relative to the size of the mesh
+         * @return            The deviation of the result, relative to the size of the mesh
+         *
+         * Edges get collapsed in the order of the error they introduce (using quadric error metrics) until the ratio is reached. The remaining vertices keep their texture coordinates and normals and UV seams, hard edges and open borders get preserved. If reaching the ratio would exceed the maximum error, more triangles are kept.
+         *
+         * Copies of a mesh share its geometry until one of them changes, so levels of detail (see m3d::LodGroup) can be created by copying a mesh and simplifying the copies.
+         *
+         * @note Meshes whose vertices only exist on the GPU (models loaded from binary files) can't be simplified, simplify them before converting them instead
+         */
+        float simplify(float t_ratio, float t_maxError = 0.05f);
+
+        /**
+         * @brief Reorders the triangles and vertices of the mesh for the post-transform vertex cache of the GPU
+         *
+         * Triangles sharing vertices get drawn close to each other, so the GPU can reuse the transformed vertices instead of running the vertex shader for them again, and vertices get stored in the order they're used in. This doesn't change the look of the mesh, only how fast it gets drawn.
+         *
+         * @note Models loaded from .obj-files and simplified meshes are optimized automatically
+         * @note This does nothing for meshes whose vertices only exist on the GPU (models loaded from binary files are optimized by the converter already)
+         */
+        void optimizeVertexCache();
+
+        /**
+         * @brief Returns the average cache miss ratio (ACMR) of the index buffer
+         * @return The number of vertices that get transformed per triangle (between 0.5 and 3, lower is better)
+         *
+         * The ratio gets simulated for a FIFO cache of 16 vertices, it's meant for comparing triangle orders (e.g. before and after calling m3d::Mesh::optimizeVertexCache()).
+         */
+        float getCacheMissRatio();
+
+        /**
+         * @brief Sets the format the vertices get stored in on the GPU
+         * @param t_format The vertex format
+         *
+         * The compact format halves the memory used by the vertex buffer. Positions and texture coordinates get quantized to 16 bits within the bounds of the mesh, so the precision depends on the size of the mesh (a mesh spanning 100 units gets a precision of about 0.0015 units).
+         *
+         * @note By default, meshes use m3d::Mesh::VertexFormat::Float
+         * @note The format of meshes whose vertices only exist on the GPU (models loaded from binary files) can't be changed
+         */
+        void setVertexFormat(m3d::Mesh::VertexFormat t_format);
+
+        /**
+         * @brief Returns the format the vertices get stored in on the GPU
+         * @return The vertex format
+         */
+        m3d::Mesh::VertexFormat getVertexFormat();
+
+        /**
+         * @brief Returns the size of the vertex and index buffers of the mesh in linear memory
+         * @return The size in bytes
+         */
+        unsigned int getBufferSize();
+
         /**
          * @brief Sets the rotation on the X-axis
          * @param t_radians  Whether to use radians instead of degrees
@@ -285,6 +488,22 @@ namespace m3d {
          */
         void scaleZ(float t_delta);
 
+        /**
+         * @brief Attaches the mesh to a scene node
+         * @param t_parent The node (or nullptr to detach the mesh)
+         *
+         * The transformation of the mesh becomes relative to the node, so the mesh follows the node and all of its ancestors.
+         *
+         * @note The node has to outlive the mesh (or the mesh has to be detached first)
+         */
+        void setParent(m3d::SceneNode* t_parent);
+
+        /**
+         * @brief Returns the scene node the mesh is attached to
+         * @return The node (or nullptr if the mesh isn't attached to one)
+         */
+        m3d::SceneNode* getParent();
+
         /**
          * @brief Sets the material of the mesh
          * @param t_material The material
@@ -299,7 +518,7 @@ namespace m3d {
 
         /**
          * @brief Binds a texture to the mesh
-         * @param t_texture       The texture to bind
+         * @param t_texture       The texture to bind (the mesh shares its data instead of copying it)
          * @param t_resetMaterial Whether or not to reset the material so that it won't interfere with the texture
          */
         void bindTexture(m3d::Texture& t_texture, bool t_resetMaterial = true);
@@ -328,20 +547,85 @@ namespace m3d {
          */
         void draw(m3d::RenderContext t_context);
 
+        /**
+         * @brief Returns whether the mesh is (partially) inside of the given frustum
+         * @param  t_frustum The frustum
+         * @return           `false` if the mesh is entirely outside of the frustum, `true` otherwise
+         */
+        bool isVisible(m3d::Frustum& t_frustum);
+
+        /**
+         * @brief Returns the minimum corner of the axis-aligned bounding box of the mesh (in model space)
+         * @return The minimum corner
+         */
+        m3d::Vector3f getBoundingBoxMin();
+
+        /**
+         * @brief Returns the maximum corner of the axis-aligned bounding box of the mesh (in model space)
+         * @return The maximum corner
+         */
+        m3d::Vector3f getBoundingBoxMax();
+
+        /**
+         * @brief Returns the radius of the bounding sphere of the mesh (in model space)
+         * @return The radius
+         * @note The bounding sphere is centered on the bounding box
+         */
+        float getBoundingRadius();
+
+        /**
+         * @brief Returns the state key of the mesh, made up of its texture and material
+         * @return The state key
+         * @note Meshes count as opaque unless their texture has an alpha channel
+         */
+        u64 getStateKey();
+
     protected:
         /**
-         * @brief Updates the vertex buffer
+         * @brief Merges identical vertices and updates the vertex and index buffers as well as the bounding volumes
          */
         void updateVBO();
 
     private:
+        struct CompactVertex {
+            s16 position[4]; // the fourth component is padding
+            s16 texcoord[2];
+            s8 normal[4];    // the fourth component is padding
+        };
+
+        struct VertexHash {
+            size_t operator()(const m3d::Mesh::Polygon::Vertex& t_vertex) const;
+        };
+
+        struct VertexEqual {
+            bool operator()(const m3d::Mesh::Polygon::Vertex& t_lhs, const m3d::Mesh::Polygon::Vertex& t_rhs) const;
+        };
+
+        static unsigned int getStride(m3d::Mesh::VertexFormat t_format);
+        static void* reserveBuffer(void* t_buffer, unsigned int& t_capacity, unsigned int t_size);
+        void detachGeometry(bool t_copyBuffers = true, bool t_copyVertices = true);
+        bool isBufferOnly();
+        void weldVertices();
+        void uploadBuffers();
+        void updateDirtyVertices();
+        void updateQuantization();
+        void writeVertices(unsigned int t_first, unsigned int t_count);
+        void writeVertex(unsigned int t_slot, const m3d::Mesh::Polygon::Vertex& t_vertex);
+        void updateAttributeInfo();
+        void updateModelMatrix();
+        void updateBounds();
+
         /* data */
         float m_rotationX, m_rotationY, m_rotationZ, m_posX, m_posY, m_posZ, m_scaleX, m_scaleY, m_scaleZ;
-        bool m_useTexture;
+        bool m_useTexture, m_transformDirty;
+        C3D_Mtx m_localMatrix, m_modelMatrix;
+
+        // hierarchy
+        m3d::SceneNode* m_parent;
+        unsigned int m_parentVersion;
 
-        // polygons
-        std::vector<m3d::Mesh::Polygon::Vertex> m_vertices;
-        m3d::Mesh::Polygon::Vertex* m_vbo;
+        // geometry (shared between copies)
+        std::shared_ptr<m3d::Mesh::Geometry> m_geometry;
 
         // display properties
         m3d::Texture m_texture;
@@ -6,7 +6,10 @@
 #define MODEL_H
 
 #pragma once
+#include <cstdio>
 #include "m3d/graphics/drawables/mesh.hpp"
+#include "m3d/private/meshFile.hpp"
+#include "m3d/private/objParser.hpp"
 
 namespace m3d {
     /**
@@ -15,12 +18,21 @@ namespace m3d {
     class Model: public m3d::Mesh {
     public:
         /**
-         * @brief Loads a model from a file (currently .obj-only)
+         * @brief Loads a model from a file (.obj or the binary .m3dm-format)
          * @param  t_filename The path to the file
+         * @param  t_useCache Whether to share the geometry with other models loaded from the same file (see m3d::MeshCache)
          * @return            `true` if loading was successful, `false` otherwise
-         * @warning Keep in mind, that your model needs to be triangulated in order to load correctly. An option to automatically triangulate will be added in the future however it will still be faster to triangulate them before-hand.
+         * @note Polygons with more than three vertices get triangulated (as a fan) while loading, so they have to be convex
+         * @note The material of the model gets loaded from its material library (the first material the model uses)
+         * @note .obj-files get cached per vertex format, so the vertex format has to be set before loading (binary files always use the format they were converted to)
+         *
+         * Binary files get created from .obj-files using the `meshconv` tool (see tools/meshconv) and load much faster, as their vertices get read straight into GPU memory. As they don't keep a copy of the vertices in RAM, modifying the vertices of models loaded from binary files starts out with an empty mesh.
          */
-        bool loadFromFile(const std::string& t_filename);
+        bool loadFromFile(const std::string& t_filename, bool t_useCache = true);
+
+    private:
+        bool loadBinary(FILE* t_file, const m3d::priv::meshFile::Header& t_header, const std::string& t_filename, bool t_useCache);
+        void applyMaterial(m3d::priv::obj::Parser& t_parser);
     };
 } /* m3d */
 
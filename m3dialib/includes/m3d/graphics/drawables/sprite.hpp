@@ -10,6 +10,7 @@
 #include "m3d/graphics/boundingBox.hpp"
 #include "m3d/graphics/color.hpp"
 #include "m3d/graphics/drawable.hpp"
+#include "m3d/graphics/spriteSheet.hpp"
 #include "m3d/graphics/texture.hpp"
 #include "m3d/graphics/vertex.hpp"
 
@@ -239,14 +240,48 @@ namespace m3d {
 
         /**
          * @brief Sets the spritesheet of the sprite
-         * @param t_spriteSheet The path to the spritesheet
+         * @param t_spriteSheet The path to the spritesheet (sprites using the same path share the loaded sheet, see m3d::SpriteSheetCache)
          * @param t_imageId The index of the image from the spritesheet to use
          */
         void setSpriteSheet(const std::string& t_spriteSheet, int t_imageId = 0);
 
+        /**
+         * @brief Sets the spritesheet of the sprite
+         * @param t_spriteSheet The spritesheet (the sprite shares it)
+         * @param t_imageId The index of the image from the spritesheet to use
+         */
+        void setSpriteSheet(const m3d::SpriteSheet& t_spriteSheet, int t_imageId = 0);
+
+        /**
+         * @brief Sets the spritesheet of the sprite
+         * @param t_spriteSheet The spritesheet (the sprite shares it)
+         * @param t_imageName The name of the image from the spritesheet to use (see m3d::SpriteSheet::loadNames())
+         */
+        void setSpriteSheet(const m3d::SpriteSheet& t_spriteSheet, const std::string& t_imageName);
+
+        /**
+         * @brief Sets the image of the spritesheet to use
+         * @param t_imageId The index of the image
+         * @note The position, center, scale and rotation of the sprite are kept, so this can be used to animate it
+         */
+        void setImage(int t_imageId);
+
+        /**
+         * @brief Sets the image of the spritesheet to use
+         * @param t_imageName The name of the image (see m3d::SpriteSheet::loadNames())
+         * @note The position, center, scale and rotation of the sprite are kept, so this can be used to animate it
+         */
+        void setImage(const std::string& t_imageName);
+
+        /**
+         * @brief Returns the index of the image of the spritesheet the sprite uses
+         * @return The index of the image
+         */
+        int getImageId();
+
         /**
          * @brief Sets the texture of the sprite
-         * @param t_texture The m3d::Texture to use
+         * @param t_texture The m3d::Texture (or region of a texture, see m3d::Texture::getRegion()) to use, the sprite keeps a copy of it
          */
         void setTexture(m3d::Texture& t_texture);
 
@@ -256,6 +291,12 @@ namespace m3d {
          */
         const std::string& getSpriteSheet();
 
+        /**
+         * @brief Returns the spritesheet of the sprite
+         * @return The spritesheet (empty if the sprite doesn't use one)
+         */
+        m3d::SpriteSheet& getSpriteSheetData();
+
         /**
          * @brief Draws the shape
          * @param t_context the RenderContext
@@ -264,15 +305,18 @@ namespace m3d {
 
     private:
         void updateTint();
+        void updateImage(C2D_Image t_image);
 
         /* data */
         int m_posX, m_posY, m_centerX, m_centerY, m_opacity, m_index;
         float m_scaleX, m_scaleY, m_rotation, m_blendStrength;
+        bool m_textureLoading;
         std::string m_spriteSheetPath;
         m3d::Color m_tintColor;
         C2D_Sprite m_sprite;
         C2D_ImageTint m_imageTint;
-        C2D_SpriteSheet m_spriteSheet;
+        m3d::SpriteSheet m_spriteSheet;
+        m3d::Texture m_texture;
     };
 } /* m3d */
 
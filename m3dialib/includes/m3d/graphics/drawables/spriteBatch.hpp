@@ -0,0 +1,227 @@
+/**
+ * @file spriteBatch.hpp
+ * @brief Defines the SpriteBatch class which draws many sprites at once
+ */
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#pragma once
+#include <citro2d.h>
+#include <vector>
+#include "m3d/graphics/color.hpp"
+#include "m3d/graphics/drawable.hpp"
+#include "m3d/graphics/spriteSheet.hpp"
+#include "m3d/graphics/texture.hpp"
+
+namespace m3d {
+    /**
+     * @brief Draws many sprites with one draw call per texture
+     *
+     * A sprite batch stores its sprites as arrays of their properties (positions, rotations, scales, tints and images) instead of one object per sprite, so moving thousands of sprites only writes a few floats each. When the batch gets drawn after it changed, the quads of all sprites get written into one vertex buffer, grouped by their texture (keeping the order of the sprites within a texture), and every texture gets drawn with a single call, bypassing citro2d.
+     *
+     * Sprites are positioned by their center, which they get rotated and scaled around. Sprites using different textures get drawn texture by texture, so sprites which have to overlap in a certain order should share a texture (e.g. by using a m3d::TextureAtlas or a sprite sheet).
+     *
+     * Indices of sprites stay valid until a sprite gets removed (see remove()). Batches only get drawn in flat mode.
+     */
+    class SpriteBatch: public m3d::Drawable {
+    public:
+        /**
+         * @brief Creates the sprite batch
+         * @param t_capacity The number of sprites to reserve memory for
+         */
+        SpriteBatch(unsigned int t_capacity = 0);
+
+        /**
+         * @brief Destructs the sprite batch
+         */
+        virtual ~SpriteBatch();
+
+        SpriteBatch(const m3d::SpriteBatch&) = delete;
+        m3d::SpriteBatch& operator=(const m3d::SpriteBatch&) = delete;
+
+        /**
+         * @brief Adds an image sprites can use
+         * @param  t_texture The texture (or region of a texture, see m3d::Texture::getRegion()), the batch keeps it
+         * @return           The index of the image
+         * @note Textures which are still loading in the background get added with the size of their placeholder
+         */
+        int addImage(m3d::Texture& t_texture);
+
+        /**
+         * @brief Adds an image of a sprite sheet sprites can use
+         * @param  t_spriteSheet The sprite sheet, the batch keeps it
+         * @param  t_index       The index of the image in the sheet
+         * @return               The index of the image (-1 if the sheet doesn't contain the image)
+         */
+        int addImage(m3d::SpriteSheet& t_spriteSheet, int t_index);
+
+        /**
+         * @brief Returns the number of images
+         * @return The number of images
+         */
+        int getImageCount();
+
+        /**
+         * @brief Adds a sprite
+         * @param  t_image The index of the image to use
+         * @param  t_x     The x-position of the center of the sprite
+         * @param  t_y     The y-position of the center of the sprite
+         * @return         The index of the sprite (-1 if the image doesn't exist)
+         */
+        int add(int t_image, float t_x, float t_y);
+
+        /**
+         * @brief Removes a sprite
+         * @param t_sprite The index of the sprite
+         * @note The last sprite takes the index of the removed one
+         */
+        void remove(int t_sprite);
+
+        /**
+         * @brief Removes all sprites (the images are kept)
+         */
+        void clear();
+
+        /**
+         * @brief Returns the number of sprites
+         * @return The number of sprites
+         */
+        int getCount();
+
+        /**
+         * @brief Sets the position of a sprite
+         * @param t_sprite The index of the sprite
+         * @param t_x      The x-position of the center of the sprite
+         * @param t_y      The y-position of the center of the sprite
+         */
+        void setPosition(int t_sprite, float t_x, float t_y);
+
+        /**
+         * @brief Moves a sprite
+         * @param t_sprite  The index of the sprite
+         * @param t_offsetX The x-offset
+         * @param t_offsetY The y-offset
+         */
+        void move(int t_sprite, float t_offsetX, float t_offsetY);
+
+        /**
+         * @brief Returns the x-position of a sprite
+         * @param  t_sprite The index of the sprite
+         * @return          The x-position of the center of the sprite
+         */
+        float getXPosition(int t_sprite);
+
+        /**
+         * @brief Returns the y-position of a sprite
+         * @param  t_sprite The index of the sprite
+         * @return          The y-position of the center of the sprite
+         */
+        float getYPosition(int t_sprite);
+
+        /**
+         * @brief Returns the x-positions of all sprites, which can be changed directly
+         * @return The x-positions, indexed by the sprites (valid until sprites get added or removed)
+         */
+        float* getXPositions();
+
+        /**
+         * @brief Returns the y-positions of all sprites, which can be changed directly
+         * @return The y-positions, indexed by the sprites (valid until sprites get added or removed)
+         */
+        float* getYPositions();
+
+        /**
+         * @brief Sets the rotation of a sprite
+         * @param t_sprite   The index of the sprite
+         * @param t_rotation The rotation
+         * @param t_radians  Whether the rotation is given in radians or degrees
+         */
+        void setRotation(int t_sprite, float t_rotation, bool t_radians = false);
+
+        /**
+         * @brief Returns the rotation of a sprite
+         * @param  t_sprite  The index of the sprite
+         * @param  t_radians Whether to return the rotation in radians or degrees
+         * @return           The rotation
+         */
+        float getRotation(int t_sprite, bool t_radians = false);
+
+        /**
+         * @brief Sets the scale of a sprite
+         * @param t_sprite The index of the sprite
+         * @param t_xScale The x-scale
+         * @param t_yScale The y-scale
+         */
+        void setScale(int t_sprite, float t_xScale, float t_yScale);
+
+        /**
+         * @brief Sets the tint of a sprite, which gets multiplied with its image
+         * @param t_sprite The index of the sprite
+         * @param t_color  The tint (its alpha sets the opacity)
+         */
+        void setTint(int t_sprite, m3d::Color t_color);
+
+        /**
+         * @brief Sets the image of a sprite
+         * @param t_sprite The index of the sprite
+         * @param t_image  The index of the image
+         */
+        void setImage(int t_sprite, int t_image);
+
+        /**
+         * @brief Returns the image of a sprite
+         * @param  t_sprite The index of the sprite
+         * @return          The index of the image
+         */
+        int getImage(int t_sprite);
+
+        /**
+         * @brief Returns the number of draw calls the last draw of the batch needed
+         * @return The number of draw calls
+         */
+        unsigned int getDrawCalls();
+
+        /**
+         * @brief Draws the sprite batch
+         * @param t_context the RenderContext
+         */
+        void draw(m3d::RenderContext t_context);
+
+    private:
+        struct Image {
+            C3D_Tex* texture;
+            int slot;
+            float width, height;
+            float u[4], v[4]; // top left, top right, bottom left, bottom right
+        };
+
+        struct Vertex {
+            float x, y;
+            float u, v;
+            u32 color;
+        };
+
+        int addImage(C2D_Image t_image);
+        void updateVertices();
+        inline bool isValid(int t_sprite);
+
+        /* data */
+        std::vector<float> m_x, m_y, m_rotation, m_xScale, m_yScale;
+        std::vector<u32> m_tint;
+        std::vector<u16> m_image;
+
+        std::vector<m3d::SpriteBatch::Image> m_images;
+        std::vector<C3D_Tex*> m_slots;
+        std::vector<unsigned int> m_slotOffsets, m_slotCursors;
+        std::vector<m3d::Texture> m_textures;
+        std::vector<m3d::SpriteSheet> m_spriteSheets;
+
+        m3d::SpriteBatch::Vertex* m_vbo;
+        u16* m_ibo;
+        unsigned int m_vboCapacity, m_iboQuads, m_drawCalls;
+        bool m_dirty;
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: SPRITEBATCH_H */
@@ -0,0 +1,52 @@
+/**
+ * @file frustum.hpp
+ * @brief Defines the Frustum class used for culling
+ */
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#pragma once
+#include <citro3d.h>
+#include "vertex.hpp"
+
+namespace m3d {
+    /**
+     * @brief A view frustum, made up of six planes
+     */
+    class Frustum {
+    public:
+        /**
+         * @brief Initializes the frustum so that it contains everything
+         */
+        Frustum();
+
+        /**
+         * @brief Extracts the planes of the frustum from a view-projection matrix
+         * @param t_viewProjection The view-projection matrix (projection * view)
+         */
+        void update(const C3D_Mtx& t_viewProjection);
+
+        /**
+         * @brief Checks whether a sphere intersects with the frustum
+         * @param  t_center The center of the sphere
+         * @param  t_radius The radius of the sphere
+         * @return          `false` if the sphere is entirely outside of the frustum, `true` otherwise
+         */
+        bool intersects(m3d::Vector3f t_center, float t_radius);
+
+        /**
+         * @brief Checks whether an axis-aligned box intersects with the frustum
+         * @param  t_center  The center of the box
+         * @param  t_extents The half-size of the box along each axis
+         * @return           `false` if the box is entirely outside of the frustum, `true` otherwise
+         */
+        bool intersects(m3d::Vector3f t_center, m3d::Vector3f t_extents);
+
+    private:
+        /* data */
+        C3D_FVec m_planes[6];
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: FRUSTUM_H */
@@ -11,10 +11,18 @@
 #include "color.hpp"
 #include "boundingBox.hpp"
 #include "drawable.hpp"
+#include "frustum.hpp"
 #include "material.hpp"
+#include "meshCache.hpp"
 #include "renderTarget.hpp"
+#include "sceneNode.hpp"
 #include "screen.hpp"
+#include "spriteSheet.hpp"
+#include "spriteSheetCache.hpp"
 #include "texture.hpp"
+#include "textureAtlas.hpp"
+#include "textureCache.hpp"
+#include "textureLoader.hpp"
 
 // all pre-coded drawables and meshes
 #include "drawables.hpp"
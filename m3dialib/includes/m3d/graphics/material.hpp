@@ -149,6 +149,13 @@ namespace m3d {
          */
         m3d::Color getEmission();
 
+        /**
+         * @brief Returns a hash of the material's colors
+         * @return The hash
+         * @note Materials with the same colors have the same hash
+         */
+        u32 getHash() const;
+
         /**
          * @brief Overloads the assignment operator
          * @param  rhs The material to copy
@@ -162,6 +169,7 @@ namespace m3d {
         /* data */
         m3d::Color m_ambient, m_diffuse, m_specular0, m_specular1, m_emission;
         C3D_Material* m_material;
+        u32 m_hash;
     };
 } /* m3d */
 
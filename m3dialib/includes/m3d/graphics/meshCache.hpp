@@ -0,0 +1,69 @@
+/**
+ * @file meshCache.hpp
+ * @brief Defines the MeshCache which shares loaded geometry between meshes
+ */
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#pragma once
+#include <memory>
+#include <string>
+#include "m3d/graphics/drawables/mesh.hpp"
+#include "m3d/private/weakCache.hpp"
+
+namespace m3d {
+    /**
+     * @brief Caches the geometry of loaded models by their path
+     *
+     * Models loading a file which was loaded before share the already uploaded geometry instead of parsing the file and allocating a new vertex buffer again (see m3d::Model::loadFromFile()). Each model still has its own transformation, material and texture.
+     *
+     * Geometry is cached per vertex format, so models using the compact format don't get geometry of models using floats and vice versa. Cached geometry never changes, models changing their vertices get their own copy first (see m3d::Mesh::isGeometryShared()).
+     *
+     * The cache only holds weak references, geometry gets freed as soon as the last mesh using it gets destroyed. To keep geometry cached while no mesh uses it, keep a handle returned by m3d::MeshCache::get() or m3d::Mesh::getGeometry().
+     */
+    class MeshCache {
+    public:
+        /**
+         * @brief Returns the cached geometry of the given path
+         * @param  t_path   The path the geometry was loaded from
+         * @param  t_format The vertex format of the geometry
+         * @return          The geometry (always in the given format) or nullptr if it isn't cached
+         */
+        static std::shared_ptr<m3d::Mesh::Geometry> get(const std::string& t_path, m3d::Mesh::VertexFormat t_format = m3d::Mesh::VertexFormat::Float);
+
+        /**
+         * @brief Adds geometry to the cache
+         * @param t_path     The path the geometry was loaded from
+         * @param t_geometry The geometry (cached by its vertex format)
+         * @note Meshes using the geometry copy it before changing it from now on
+         */
+        static void add(const std::string& t_path, std::shared_ptr<m3d::Mesh::Geometry> t_geometry);
+
+        /**
+         * @brief Removes the geometry of the given path (in all vertex formats) from the cache
+         * @param t_path The path the geometry was loaded from
+         * @note Meshes using the geometry keep using it
+         */
+        static void remove(const std::string& t_path);
+
+        /**
+         * @brief Removes all geometry from the cache
+         * @note Meshes using the geometry keep using it
+         */
+        static void clear();
+
+        /**
+         * @brief Returns the number of cached geometries which are still in use
+         * @return The number of geometries
+         */
+        static unsigned int getSize();
+
+    private:
+        static std::string getKey(const std::string& t_path, m3d::Mesh::VertexFormat t_format);
+        static void uncache(m3d::Mesh::Geometry& t_geometry);
+        static m3d::priv::WeakCache<m3d::Mesh::Geometry>& getCache();
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: MESHCACHE_H */
@@ -38,6 +38,36 @@ namespace m3d {
             Spatial ///< 3D
         };
 
+        /**
+         * @brief The maximum number of instances whose matrices can be uploaded at once
+         */
+        static const int MaxInstances = 16;
+
+        /**
+         * @brief Caches the GPU state set by the last drawn object, so identical state changes can be skipped
+         */
+        struct State {
+            bool materialValid;    ///< Whether the cached material reflects the current GPU state
+            bool textureValid;     ///< Whether the cached texture state reflects the current GPU state
+            bool attributesValid;  ///< Whether the cached attribute information reflects the current GPU state
+            bool texturesEnabled;  ///< Whether textures are enabled
+            C3D_Tex* texture;      ///< The bound texture
+            C3D_Material material; ///< The bound material
+            C3D_AttrInfo attributeInfo; ///< The bound attribute information (vertex format)
+
+            /**
+             * @brief Initializes the state as invalid
+             */
+            State();
+
+            /**
+             * @brief Invalidates the cached state
+             *
+             * Call this whenever the GPU state got changed without going through a m3d::RenderContext (e.g. in a shading function).
+             */
+            void invalidate();
+        };
+
         /**
          * @brief Default constructor
          * @param t_modelUniform  The location of the model uniform
@@ -49,6 +79,12 @@ namespace m3d {
          * @param t_lightEnv      The light environment
          * @param t_light         The light
          * @param t_lightLut      The light LUT
+         * @param t_replay        Whether this pass replays the work recorded in the previous pass (see m3d::RenderContext::isReplay())
+         * @param t_state         The state cache used to skip redundant state changes (or nullptr to always apply them)
+         * @param t_quantizationUniform The location of the quantization uniform (or -1 if the shader doesn't support quantized vertices)
+         * @param t_instanceUniform     The location of the instance matrix uniform (or -1 if the shader doesn't support instancing)
+         * @param t_tintUniform         The location of the instance tint uniform (or -1 if the shader doesn't support instancing)
+         * @param t_instancedUniform    The location of the boolean uniform enabling instancing (or -1 if the shader doesn't support instancing)
          */
         RenderContext(
             int t_modelUniform,
@@ -59,7 +95,13 @@ namespace m3d {
             C3D_Mtx& t_model,
             C3D_LightEnv& t_lightEnv,
             C3D_Light& t_light,
-            C3D_LightLut& t_lightLut
+            C3D_LightLut& t_lightLut,
+            bool t_replay = false,
+            m3d::RenderContext::State* t_state = nullptr,
+            int t_quantizationUniform = -1,
+            int t_instanceUniform = -1,
+            int t_tintUniform = -1,
+            int t_instancedUniform = -1
         );
 
         /**
@@ -68,6 +110,34 @@ namespace m3d {
          */
         int getModelUniform();
 
+        /**
+         * @brief Returns the location of the quantization uniform
+         * @return The location of the uniform (or -1 if the shader doesn't support quantized vertices)
+         *
+         * The uniform consists of three vectors: the scale and the offset of the positions and the scale (xy) and offset (zw) of the texture coordinates.
+         */
+        int getQuantizationUniform();
+
+        /**
+         * @brief Returns the location of the instance matrix uniform
+         * @return The location of the uniform (or -1 if the shader doesn't support instancing)
+         *
+         * The uniform holds the first three rows of up to m3d::RenderContext::MaxInstances model matrices. The vertex attribute 3 selects the matrix (x) and the tint (y) used for the current draw call.
+         */
+        int getInstanceUniform();
+
+        /**
+         * @brief Returns the location of the instance tint uniform
+         * @return The location of the uniform (or -1 if the shader doesn't support instancing)
+         */
+        int getTintUniform();
+
+        /**
+         * @brief Returns the location of the boolean uniform enabling instancing
+         * @return The location of the uniform (or -1 if the shader doesn't support instancing)
+         */
+        int getInstancedUniform();
+
         /**
          * @brief Returns whether or not stereoscopic 3D is enabled
          * @return Whether or not stereoscopic 3D is enabled
@@ -92,6 +162,14 @@ namespace m3d {
          */
         m3d::RenderContext::ScreenTarget getScreenTarget();
 
+        /**
+         * @brief Returns whether the current pass is a replay of the previous pass
+         * @return `true` if this is a replay, `false` otherwise
+         *
+         * When stereoscopic replay is enabled on the screen, the right eye of the top screen replays the left eye. Drawables get drawn in the exact same order and state as in the previous pass, so per-object work (like calculating matrices) done in the previous pass can be reused instead of being recalculated.
+         */
+        bool isReplay();
+
         /**
          * @brief Returns the model matrix
          * @return The model matrix
@@ -122,10 +200,28 @@ namespace m3d {
          */
         void enableTextures(bool t_enable);
 
+        /**
+         * @brief Sets the material of the light environment, unless it's already set
+         * @param t_material The material
+         */
+        void bindMaterial(const C3D_Material* t_material);
+
+        /**
+         * @brief Binds a texture to the first texture unit and enables textures, unless it's already bound
+         * @param t_texture The texture to bind (or nullptr to disable textures)
+         */
+        void bindTexture(C3D_Tex* t_texture);
+
+        /**
+         * @brief Sets the attribute information (the vertex format), unless it's already set
+         * @param t_attributeInfo The attribute information
+         */
+        void bindAttributeInfo(const C3D_AttrInfo* t_attributeInfo);
+
     private:
         /* data */
-        int m_modelUniformLocation;
-        bool m_3dEnabled;
+        int m_modelUniformLocation, m_quantizationUniformLocation, m_instanceUniformLocation, m_tintUniformLocation, m_instancedUniformLocation;
+        bool m_3dEnabled, m_replay;
         m3d::RenderContext::Mode m_mode;
         m3d::RenderContext::Stereo3dSide m_side;
         m3d::RenderContext::ScreenTarget m_target;
@@ -133,6 +229,7 @@ namespace m3d {
         C3D_LightEnv& m_lightEnv;
         C3D_Light& m_light;
         C3D_LightLut& m_lightLut;
+        m3d::RenderContext::State* m_state;
     };
 } /* m3d */
 
@@ -0,0 +1,171 @@
+/**
+ * @file sceneNode.hpp
+ * @brief Defines the SceneNode class used to build transformation hierarchies
+ */
+#ifndef SCENENODE_H
+#define SCENENODE_H
+
+#pragma once
+#include <citro3d.h>
+#include <vector>
+#include "vertex.hpp"
+
+namespace m3d {
+    class Mesh;
+
+    /**
+     * @brief A node in a transformation hierarchy (scene graph)
+     *
+     * Every node has a transformation relative to its parent. Meshes attached to a node (see m3d::Mesh::setParent()) get transformed by the node and all of its ancestors, so objects attached to other objects (like a weapon held by a character) follow them automatically.
+     *
+     * The world matrices of the nodes get cached and only get recalculated if the node or one of its ancestors changed, so static parts of a scene don't cost any matrix math.
+     *
+     * @note Nodes without a parent are relative to the same origin as meshes without a parent
+     * @note A node has to outlive its children and all meshes attached to it
+     */
+    class SceneNode {
+        friend class m3d::Mesh;
+
+    public:
+        /**
+         * @brief Creates the node
+         */
+        SceneNode();
+
+        /**
+         * @brief Detaches the node from its parent and its children
+         */
+        ~SceneNode();
+
+        SceneNode(const m3d::SceneNode&) = delete;
+        m3d::SceneNode& operator=(const m3d::SceneNode&) = delete;
+
+        /**
+         * @brief Adds a child node
+         * @param t_child The child node
+         * @note The child gets removed from its previous parent
+         * @note Nothing happens if the child is the node itself or one of its ancestors, as that would create a cycle
+         */
+        void addChild(m3d::SceneNode& t_child);
+
+        /**
+         * @brief Removes a child node
+         * @param t_child The child node
+         */
+        void removeChild(m3d::SceneNode& t_child);
+
+        /**
+         * @brief Returns the parent of the node
+         * @return The parent (or nullptr if the node doesn't have one)
+         */
+        m3d::SceneNode* getParent();
+
+        /**
+         * @brief Returns the number of children of the node
+         * @return The number of children
+         */
+        unsigned int getChildCount();
+
+        /**
+         * @brief Returns a child given its index
+         * @param  t_index The index of the child
+         * @return         The child (or nullptr if the index is out of range)
+         */
+        m3d::SceneNode* getChild(unsigned int t_index);
+
+        /**
+         * @brief Sets the position of the node relative to its parent
+         * @param t_positionX The position on the X-axis
+         * @param t_positionY The position on the Y-axis
+         * @param t_positionZ The position on the Z-axis
+         */
+        void setPosition(float t_positionX, float t_positionY, float t_positionZ);
+
+        /**
+         * @brief Sets the position of the node relative to its parent
+         * @param t_position The position, represented as a vector
+         */
+        void setPosition(m3d::Vector3f t_position);
+
+        /**
+         * @brief Returns the position of the node relative to its parent
+         * @return The position
+         */
+        m3d::Vector3f getPosition();
+
+        /**
+         * @brief Moves the node
+         * @param t_deltaX The amount to move along the X-axis
+         * @param t_deltaY The amount to move along the Y-axis
+         * @param t_deltaZ The amount to move along the Z-axis
+         */
+        void move(float t_deltaX, float t_deltaY, float t_deltaZ);
+
+        /**
+         * @brief Sets the rotation of the node relative to its parent
+         * @param t_pitch    The rotation on the X-axis
+         * @param t_yaw      The rotation on the Y-axis
+         * @param t_roll     The rotation on the Z-axis
+         * @param t_radians  Whether to use radians instead of degrees
+         */
+        void setRotation(float t_pitch, float t_yaw, float t_roll, bool t_radians = false);
+
+        /**
+         * @brief Returns the rotation of the node relative to its parent
+         * @param  t_radians Whether to use radians instead of degrees
+         * @return           The rotation (pitch, yaw and roll)
+         */
+        m3d::Vector3f getRotation(bool t_radians = false);
+
+        /**
+         * @brief Rotates the node
+         * @param t_deltaPitch The amount to rotate on the X-axis
+         * @param t_deltaYaw   The amount to rotate on the Y-axis
+         * @param t_deltaRoll  The amount to rotate on the Z-axis
+         * @param t_radians    Whether to use radians instead of degrees
+         */
+        void rotate(float t_deltaPitch, float t_deltaYaw, float t_deltaRoll, bool t_radians = false);
+
+        /**
+         * @brief Sets the scale of the node
+         * @param t_scaleX The scale along its X-axis
+         * @param t_scaleY The scale along its Y-axis
+         * @param t_scaleZ The scale along its Z-axis
+         */
+        void setScale(float t_scaleX, float t_scaleY, float t_scaleZ);
+
+        /**
+         * @brief Returns the scale of the node
+         * @return The scale
+         */
+        m3d::Vector3f getScale();
+
+        /**
+         * @brief Returns the transformation of the node relative to its parent
+         * @return The local matrix
+         */
+        const C3D_Mtx& getLocalMatrix();
+
+        /**
+         * @brief Returns the transformation of the node including the ones of all of its ancestors
+         * @return The world matrix
+         */
+        const C3D_Mtx& getWorldMatrix();
+
+    private:
+        void invalidate();
+
+        /* data */
+        float m_posX, m_posY, m_posZ, m_rotationX, m_rotationY, m_rotationZ, m_scaleX, m_scaleY, m_scaleZ;
+        bool m_localDirty, m_worldDirty;
+        unsigned int m_version; // increases every time the world matrix changes
+        C3D_Mtx m_localMatrix, m_worldMatrix;
+
+        // hierarchy
+        m3d::SceneNode* m_parent;
+        std::vector<m3d::SceneNode*> m_children;
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: SCENENODE_H */
@@ -9,11 +9,11 @@
 #include <citro2d.h>
 #include <cstring>
 #include <functional>
-#include <map>
 #include <vector>
 #include "camera.hpp"
 #include "color.hpp"
 #include "drawable.hpp"
+#include "frustum.hpp"
 #include "renderTarget.hpp"
 /**
  * @brief The general m3d-namespace
@@ -54,6 +54,68 @@ namespace m3d {
          */
         bool isUsingCulling();
 
+        /**
+         * @brief Sets whether the right eye of the top screen replays the left eye
+         * @param t_useStereoReplay Whether to use stereoscopic replay or not
+         *
+         * When enabled, the per-object work of the top screen (evaluating shading functions, calculating model matrices, resolving materials and textures) is only done once for the left eye. The right eye then resubmits the recorded draws with only the projection changed.
+         *
+         * @note In this mode, shading functions get called only once per frame (before the left eye gets drawn). Their return value decides whether the object is drawn on both eyes.
+         * @note By default, stereoscopic replay is disabled
+         */
+        void useStereoReplay(bool t_useStereoReplay);
+
+        /**
+         * @brief Returns whether stereoscopic replay is being used or not
+         * @return `true` if stereoscopic replay is being used, `false` otherwise
+         */
+        bool isUsingStereoReplay();
+
+        /**
+         * @brief Sets whether spatial objects should be sorted by their GPU state
+         * @param t_useStateSorting Whether to use state sorting or not
+         *
+         * When enabled, opaque spatial objects within the same layer get sorted by their state key (shader, texture and material, see m3d::Drawable::getStateKey()), so objects sharing the same state get drawn one after another and identical state changes get skipped. Translucent objects and objects setting their own state are never reordered, opaque objects only get sorted among the ones drawn between them.
+         *
+         * @note By default, state sorting is enabled
+         */
+        void useStateSorting(bool t_useStateSorting);
+
+        /**
+         * @brief Returns whether state sorting is being used or not
+         * @return `true` if state sorting is being used, `false` otherwise
+         */
+        bool isUsingStateSorting();
+
+        /**
+         * @brief Sets whether spatial objects outside of the view frustum should be culled
+         * @param t_useFrustumCulling Whether to use frustum culling or not
+         *
+         * When enabled, spatial objects entirely outside of the camera's view (see m3d::Drawable::isVisible()) don't get drawn. With stereoscopic 3D enabled, objects only get culled if they are outside of the view of both eyes.
+         *
+         * @note By default, frustum culling is enabled
+         */
+        void useFrustumCulling(bool t_useFrustumCulling);
+
+        /**
+         * @brief Returns whether frustum culling is being used or not
+         * @return `true` if frustum culling is being used, `false` otherwise
+         */
+        bool isUsingFrustumCulling();
+
+        /**
+         * @brief Returns the number of spatial objects drawn in the last frame
+         * @return The number of drawn objects
+         * @note Objects drawn for both eyes only get counted once
+         */
+        unsigned int getDrawnObjects();
+
+        /**
+         * @brief Returns the number of spatial objects culled in the last frame
+         * @return The number of culled objects
+         */
+        unsigned int getCulledObjects();
+
         /**
          * @brief Sets the clear color for both screens
          * @param t_color The color to clear the screen with
@@ -178,13 +240,34 @@ namespace m3d {
          */
         float getFogDensity(m3d::RenderContext::ScreenTarget t_target);
     private:
+        /**
+         * @brief A single queued draw call
+         */
+        struct DrawCommand {
+            int layer;                             ///< The layer to draw the object at
+            unsigned int index;                    ///< The position in the draw stack (keeps the drawing order stable within a layer)
+            u64 key;                               ///< The state key (only used for spatial objects)
+            unsigned int group;                    ///< The run of opaque objects the object belongs to (objects only get sorted by state within their run)
+            m3d::Drawable* drawable;               ///< The object to draw
+            std::function<bool()> shadingFunction; ///< The shading function (empty if none was given)
+            bool visible;                          ///< The result of the shading function in the last pass (used when replaying)
+            bool culled;                           ///< Whether the object is outside of the view frustum
+        };
+
+        void enqueue(std::vector<m3d::Screen::DrawCommand>& t_stack, m3d::Drawable& t_object, std::function<bool()> t_shadingFunction, int t_layer);
+        void sortDrawStack(std::vector<m3d::Screen::DrawCommand>& t_stack, bool t_spatial = false);
+        void selectLevelsOfDetail(std::vector<m3d::Screen::DrawCommand>& t_stack, m3d::Camera& t_camera);
+        void cullDrawStack(std::vector<m3d::Screen::DrawCommand>& t_stack, const C3D_Mtx& t_viewProjection, const C3D_Mtx* t_viewProjectionRight = nullptr);
+        void renderDrawStack(std::vector<m3d::Screen::DrawCommand>& t_stack, m3d::RenderContext::Mode t_mode, m3d::RenderContext::Stereo3dSide t_side, m3d::RenderContext::ScreenTarget t_target, bool t_replay = false);
         void prepare();
         void prepareFog(m3d::RenderContext::ScreenTarget t_target);
         void prepareLights(m3d::RenderContext::ScreenTarget t_target);
+        void prepareVertexFormat();
 
         /* data */
-        int m_projectionUniform, m_modelUniform, m_viewUniform;
-        bool m_3dEnabled, m_useCulling;
+        int m_projectionUniform, m_modelUniform, m_viewUniform, m_quantizationUniform, m_instanceUniform, m_tintUniform, m_instancedUniform;
+        bool m_3dEnabled, m_useCulling, m_useStereoReplay, m_useStateSorting, m_useFrustumCulling;
+        unsigned int m_drawnObjects, m_culledObjects;
         m3d::Color m_clearColorTop, m_clearColorBottom;
         m3d::Camera &m_cameraTop, &m_cameraBottom;
 
@@ -193,11 +276,17 @@ namespace m3d {
                           *m_targetTopRight,
                           *m_targetBottom;
 
-        // draw stacks
-        std::map<int, std::vector<std::pair<m3d::Drawable*, std::function<bool()>>>, std::less<int>> m_drawStackTop2d,
-                                                                   m_drawStackTop3d,
-                                                                   m_drawStackBottom2d,
-                                                                   m_drawStackBottom3d;
+        // draw stacks (cleared every frame, their capacity persists between frames)
+        std::vector<m3d::Screen::DrawCommand> m_drawStackTop2d,
+                                              m_drawStackTop3d,
+                                              m_drawStackBottom2d,
+                                              m_drawStackBottom3d;
+
+        // frustum culling
+        m3d::Frustum m_frustumLeft, m_frustumRight;
+
+        // state cache for spatial objects
+        m3d::RenderContext::State m_renderState;
 
         // shader
         DVLB_s* m_dvlb;
@@ -207,7 +296,7 @@ namespace m3d {
         C3D_AttrInfo m_attributeInfo;
 
         // matrices
-        C3D_Mtx m_projection, m_model, m_view;
+        C3D_Mtx m_model, m_view;
 
         // light
         C3D_LightEnv m_lightEnvTop, m_lightEnvBottom;
@@ -0,0 +1,160 @@
+/**
+ * @file spriteSheet.hpp
+ * @brief Defines the SpriteSheet class
+ */
+#ifndef SPRITESHEET_H
+#define SPRITESHEET_H
+
+#pragma once
+#include <citro2d.h>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace m3d {
+    /**
+     * @brief The SpriteSheet class
+     *
+     * A sprite sheet is a cheap handle to a loaded .t3x-file (created by tex3ds). Copying a sprite sheet (e.g. when setting it on a sprite) shares the loaded file instead of loading it again, it gets freed as soon as the last sprite sheet using it gets destroyed or loads something else. Sprite sheets loaded from the same file share it as well (see m3d::SpriteSheetCache).
+     *
+     * Images can be looked up by their index or, after their names got set (see loadNames() and setName()), by their name.
+     */
+    class SpriteSheet {
+    public:
+        /**
+         * @brief The loaded sprite sheet, shared by all sprite sheets (and sprites) using it
+         */
+        struct Data {
+            C2D_SpriteSheet sheet;            ///< The C2D sprite sheet
+            std::string path;                 ///< The path the sheet was loaded from (empty if it wasn't loaded from a file)
+            std::map<std::string, int> names; ///< The indices of the images by their name
+
+            /**
+             * @brief Initializes the data
+             */
+            Data();
+
+            /**
+             * @brief Frees the sprite sheet
+             */
+            ~Data();
+
+            Data(const m3d::SpriteSheet::Data&) = delete;
+            m3d::SpriteSheet::Data& operator=(const m3d::SpriteSheet::Data&) = delete;
+        };
+
+        /**
+         * @brief Creates an empty sprite sheet
+         */
+        SpriteSheet();
+
+        /**
+         * @brief Creates a sprite sheet and loads a file
+         * @param t_filename The path to the .t3x-file
+         * @param t_useCache Whether to share the file with other sprite sheets which loaded it (see m3d::SpriteSheetCache)
+         */
+        SpriteSheet(const std::string& t_filename, bool t_useCache = true);
+
+        /**
+         * @brief Loads a .t3x-file
+         * @param  t_filename The path to the .t3x-file
+         * @param  t_useCache Whether to share the file with other sprite sheets which loaded it (see m3d::SpriteSheetCache)
+         * @return            Whether the load was successful or not
+         */
+        bool loadFromFile(const std::string& t_filename, bool t_useCache = true);
+
+        /**
+         * @brief Loads a .t3x-file from a buffer
+         * @param  t_buffer The buffer containing the whole file
+         * @param  t_size   The size of the buffer
+         * @return          Whether the load was successful or not
+         */
+        bool loadFromBuffer(const void* t_buffer, size_t t_size);
+
+        /**
+         * @brief Loads the names of the images from a file
+         * @param  t_filename The path to the file, containing the name of one image per line, in the order of the images
+         * @return            Whether the file could be read
+         *
+         * Empty lines and lines starting with `-` get skipped, and directories and extensions get removed from the names, so the .t3s-script the sheet was created from can be used as is (an image `gfx/ship.png` gets the name `ship`).
+         */
+        bool loadNames(const std::string& t_filename);
+
+        /**
+         * @brief Sets the name of an image
+         * @param t_name  The name
+         * @param t_index The index of the image
+         */
+        void setName(const std::string& t_name, int t_index);
+
+        /**
+         * @brief Returns the index of an image
+         * @param  t_name The name of the image
+         * @return        The index (-1 if no image has the name)
+         */
+        int getIndex(const std::string& t_name);
+
+        /**
+         * @brief Returns the number of images in the sheet
+         * @return The number of images
+         */
+        int getImageCount();
+
+        /**
+         * @brief Returns an image of the sheet
+         * @param  t_index The index of the image
+         * @return         The image (its texture is nullptr if the index is out of range)
+         */
+        C2D_Image getImage(int t_index);
+
+        /**
+         * @brief Returns an image of the sheet
+         * @param  t_name The name of the image
+         * @return        The image (its texture is nullptr if no image has the name)
+         */
+        C2D_Image getImage(const std::string& t_name);
+
+        /**
+         * @brief Returns whether a sheet was loaded
+         * @return Whether the sheet is loaded
+         */
+        bool isLoaded();
+
+        /**
+         * @brief Returns the path of the loaded file
+         * @return The path of the file
+         */
+        std::string getPath();
+
+        /**
+         * @brief Returns the C2D sprite sheet
+         * @return The C2D sprite sheet (nullptr if nothing was loaded)
+         */
+        C2D_SpriteSheet getSpriteSheet();
+
+        /**
+         * @brief Returns the data of the sprite sheet
+         * @return The data (nullptr if nothing was loaded)
+         */
+        std::shared_ptr<m3d::SpriteSheet::Data> getData();
+
+        /**
+         * @brief Sets the data of the sprite sheet, sharing it with all other sprite sheets using it
+         * @param t_data The data (nullptr to unload the sprite sheet)
+         */
+        void setData(std::shared_ptr<m3d::SpriteSheet::Data> t_data);
+
+        /**
+         * @brief Returns whether the data of the sprite sheet is shared with other sprite sheets
+         * @return Whether the data is shared
+         */
+        bool isShared();
+
+    private:
+        /* data */
+        std::shared_ptr<m3d::SpriteSheet::Data> m_data;
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: SPRITESHEET_H */
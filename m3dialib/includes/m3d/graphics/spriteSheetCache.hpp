@@ -0,0 +1,63 @@
+/**
+ * @file spriteSheetCache.hpp
+ * @brief Defines the SpriteSheetCache which shares loaded sprite sheets between sprites
+ */
+#ifndef SPRITESHEETCACHE_H
+#define SPRITESHEETCACHE_H
+
+#pragma once
+#include <memory>
+#include <string>
+#include "m3d/graphics/spriteSheet.hpp"
+#include "m3d/private/weakCache.hpp"
+
+namespace m3d {
+    /**
+     * @brief Caches loaded sprite sheets by their path
+     *
+     * Sprite sheets loading a file which was loaded before share the already loaded sheet instead of loading the file again (see m3d::SpriteSheet::loadFromFile()), so any number of sprites using the same sheet only keep it in memory once.
+     *
+     * The cache only holds weak references, a sheet gets freed as soon as the last sprite sheet (or sprite) using it gets destroyed. To keep a sheet cached while nothing uses it, keep a handle returned by m3d::SpriteSheetCache::get() or m3d::SpriteSheet::getData().
+     */
+    class SpriteSheetCache {
+    public:
+        /**
+         * @brief Returns the cached data of the given path
+         * @param  t_path The path the sheet was loaded from
+         * @return        The data or nullptr if it isn't cached
+         */
+        static std::shared_ptr<m3d::SpriteSheet::Data> get(const std::string& t_path);
+
+        /**
+         * @brief Adds the data of a sprite sheet to the cache
+         * @param t_path The path the sheet was loaded from
+         * @param t_data The data
+         */
+        static void add(const std::string& t_path, std::shared_ptr<m3d::SpriteSheet::Data> t_data);
+
+        /**
+         * @brief Removes the data of the given path from the cache
+         * @param t_path The path the sheet was loaded from
+         * @note Sprite sheets using the data keep using it
+         */
+        static void remove(const std::string& t_path);
+
+        /**
+         * @brief Removes all data from the cache
+         * @note Sprite sheets using the data keep using it
+         */
+        static void clear();
+
+        /**
+         * @brief Returns the number of cached sprite sheets which are still in use
+         * @return The number of sprite sheets
+         */
+        static unsigned int getSize();
+
+    private:
+        static m3d::priv::WeakCache<m3d::SpriteSheet::Data>& getCache();
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: SPRITESHEETCACHE_H */
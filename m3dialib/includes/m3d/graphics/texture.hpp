@@ -7,16 +7,92 @@
 
 #pragma once
 #include <citro2d.h>
+#include <memory>
 #include <string>
 #include "vertex.hpp"
 
 namespace m3d {
+    namespace priv {
+        namespace image {
+            class PngReader;
+        } /* image */
+
+        namespace textureFile {
+            struct Header;
+        } /* textureFile */
+    } /* priv */
+
+    class TextureAtlas;
+    class TextureLoader;
+
     /**
      * @brief The Texture class
-     * @todo Implement loading texture from memory
+     *
+     * A texture is a cheap handle to texture data on the GPU. Copying a texture (e.g. when binding it to a mesh) shares the data instead of duplicating it, the data gets freed as soon as the last texture using it gets destroyed or loads something else. Textures loaded from the same file share their data as well (see m3d::TextureCache).
      */
     class Texture {
     public:
+        /**
+         * @brief Defines the formats textures get stored in on the GPU
+         */
+        enum class Format {
+            RGBA8 = GPU_RGBA8,       ///< 32 bits per texel, 8 bits per channel
+            RGBA5551 = GPU_RGBA5551, ///< 16 bits per texel, 5 bits per color channel and 1-bit alpha
+            RGB565 = GPU_RGB565,     ///< 16 bits per texel, 5 bits for red and blue and 6 bits for green, without alpha
+            RGBA4 = GPU_RGBA4,       ///< 16 bits per texel, 4 bits per channel
+            LA8 = GPU_LA8,           ///< 16 bits per texel, 8-bit luminance (greyscale) and alpha
+            ETC1 = GPU_ETC1,         ///< 4 bits per texel, compressed in 4x4 blocks, without alpha (only from .m3dt-files)
+            ETC1A4 = GPU_ETC1A4      ///< 8 bits per texel, compressed in 4x4 blocks with 4-bit alpha (only from .m3dt-files)
+        };
+
+        /**
+         * @brief Defines the filters used when sampling textures
+         */
+        enum class Filter {
+            Nearest = GPU_NEAREST, ///< Uses the nearest texel (or mipmap level)
+            Linear = GPU_LINEAR    ///< Interpolates between the nearest texels (or mipmap levels)
+        };
+
+        /**
+         * @brief Defines the loading status of a texture
+         */
+        enum class Status {
+            Empty,   ///< Nothing was loaded
+            Loading, ///< The texture is being loaded in the background and shows the placeholder (see m3d::Texture::loadFromFileAsync())
+            Loaded,  ///< The texture is loaded
+            Failed   ///< Loading the texture in the background failed, it keeps showing the placeholder
+        };
+
+        /**
+         * @brief The data of a texture on the GPU
+         *
+         * The data can be shared between any number of textures (see m3d::Texture::setData() and m3d::TextureCache). Loading a texture always creates new data, so shared data never changes (apart from its filters, see m3d::Texture::setFilter()).
+         */
+        struct Data {
+            C3D_Tex texture;                      ///< The C3D texture (only valid if initialized is `true`)
+            bool initialized;                     ///< Whether the texture was allocated
+            int width;                            ///< The width of the image (the texture itself is rounded to a power of 2)
+            int height;                           ///< The height of the image (the texture itself is rounded to a power of 2)
+            std::string path;                     ///< The path the texture was loaded from (empty if it wasn't loaded from a file)
+            m3d::Texture::Format format;          ///< The format of the texture
+            m3d::Texture::Format requestedFormat; ///< The format the texture was requested in (.m3dt-files keep their own format, so it can differ from format)
+            bool mipmaps;                         ///< Whether mipmaps were requested
+            m3d::Texture::Status status;          ///< The loading status (textures loaded in the background hold a placeholder until they are loaded)
+
+            /**
+             * @brief Initializes the data
+             */
+            Data();
+
+            /**
+             * @brief Frees the texture
+             */
+            ~Data();
+
+            Data(const m3d::Texture::Data&) = delete;
+            m3d::Texture::Data& operator=(const m3d::Texture::Data&) = delete;
+        };
+
         /**
          * @brief Initializes the texture
          */
@@ -24,28 +100,67 @@ namespace m3d {
 
         /**
          * @brief Copy constructor
-         * @param t_texture The texture to copy
+         * @param t_texture The texture to copy (the copy shares its data)
+         */
+        Texture(const m3d::Texture& t_texture);
+
+        /**
+         * @brief Loads a texture from a file (png or the binary .m3dt-format)
+         * @param t_filename The name of the file you want to load
+         * @param t_format   The format to convert .png-files into (.m3dt-files keep the format they were converted to using tools/texconv)
+         * @param t_mipmaps  Whether to generate mipmaps (.m3dt-files converted with mipmaps already contain them, compressed ones can't get them at runtime)
+         * @param t_useCache Whether to share the data with other textures loaded from the same file with the same options (see m3d::TextureCache)
+         * @return           Whether the load was successful or not (.png-files can't be converted into the ETC1-formats at runtime)
+         *
+         * The 16-bit formats need half of the memory of RGBA8 and get sampled faster, which can be worth their lower precision. Mipmaps need a third more memory, but textures drawn smaller than their size get sampled from the smaller levels, which is faster and doesn't shimmer.
          */
-        Texture(m3d::Texture& t_texture);
+        bool loadFromFile(const std::string& t_filename, m3d::Texture::Format t_format = m3d::Texture::Format::RGBA8, bool t_mipmaps = false, bool t_useCache = true);
 
         /**
-         * @brief Destroys the texture
+         * @brief Loads a texture from a buffer (png or the binary .m3dt-format)
+         * @param t_buffer The buffer to load the texture from
+         * @param t_format  The format to convert .png-files into (.m3dt-files keep the format they were converted to using tools/texconv)
+         * @param t_mipmaps Whether to generate mipmaps (.m3dt-files converted with mipmaps already contain them, compressed ones can't get them at runtime)
+         * @return          Whether the load was successful or not (.png-files can't be converted into the ETC1-formats at runtime)
          */
-        ~Texture();
+        bool loadFromBuffer(const void* t_buffer, m3d::Texture::Format t_format = m3d::Texture::Format::RGBA8, bool t_mipmaps = false);
 
         /**
-         * @brief Loads a texture from a file (png)
+         * @brief Loads a texture from a file in the background (png or the binary .m3dt-format)
          * @param t_filename The name of the file you want to load
-         * @return           Whether the load was successful or not
+         * @param t_format   The format to convert .png-files into (.m3dt-files keep the format they were converted to using tools/texconv)
+         * @param t_mipmaps  Whether to generate mipmaps (.m3dt-files converted with mipmaps already contain them, compressed ones can't get them at runtime)
+         * @param t_useCache Whether to share the data with other textures loaded from the same file with the same options (see m3d::TextureCache)
+         * @return           Whether the placeholder could be allocated
+         *
+         * This returns immediately. The texture holds a placeholder of a single color (see m3d::TextureLoader::setPlaceholderColor()) with a size of 0 until the file was decoded on the worker thread of m3d::TextureLoader, after which the texture gets uploaded at the start of the next frame. All textures sharing the data (e.g. the ones bound to meshes in the meantime) show the loaded texture from then on.
+         *
+         * Use getStatus() to check whether the texture was loaded. Sprites using the texture (see m3d::Sprite::setTexture()) take its size once it is loaded.
          */
-        bool loadFromFile(const std::string& t_filename);
+        bool loadFromFileAsync(const std::string& t_filename, m3d::Texture::Format t_format = m3d::Texture::Format::RGBA8, bool t_mipmaps = false, bool t_useCache = true);
 
         /**
-         * @brief Loads a texture from a buffer (png)
-         * @param t_buffer The buffer to load the texture from
-         * @return         Whether the load was successful or not
+         * @brief Returns the loading status of the texture
+         * @return The status
+         */
+        m3d::Texture::Status getStatus();
+
+        /**
+         * @brief Returns a texture covering a region of this texture
+         * @param  t_x      The x-position of the region in pixels
+         * @param  t_y      The y-position of the region in pixels (from the top)
+         * @param  t_width  The width of the region in pixels
+         * @param  t_height The height of the region in pixels
+         * @return          The texture sharing the data of this one, whose size, subtexture and image only cover the region
+         * @note Regions only apply to 2D drawing (sprites), meshes use the whole texture
          */
-        bool loadFromBuffer(const void* t_buffer);
+        m3d::Texture getRegion(int t_x, int t_y, int t_width, int t_height);
+
+        /**
+         * @brief Returns whether the texture only covers a region of its data (see getRegion())
+         * @return Whether the texture is a region
+         */
+        bool isRegion();
 
         /**
          * @brief Returns the width of the texture
@@ -71,6 +186,38 @@ namespace m3d {
          */
         int getCalculatedHeight();
 
+        /**
+         * @brief Returns the format of the texture on the GPU
+         * @return The format
+         */
+        m3d::Texture::Format getFormat();
+
+        /**
+         * @brief Returns the number of mipmap levels of the texture
+         * @return The number of levels (including the full-sized one, 1 without mipmaps)
+         */
+        int getMipmapLevels();
+
+        /**
+         * @brief Sets the filters used when sampling the texture
+         * @param t_magnification The filter used when the texture gets drawn bigger than its size
+         * @param t_minification  The filter used when the texture gets drawn smaller than its size
+         * @note The filters are part of the data, so they apply to all textures sharing it
+         */
+        void setFilter(m3d::Texture::Filter t_magnification, m3d::Texture::Filter t_minification);
+
+        /**
+         * @brief Sets the filter used between mipmap levels
+         * @param t_filter The filter (m3d::Texture::Filter::Linear together with a linear minification filter is trilinear filtering)
+         */
+        void setMipmapFilter(m3d::Texture::Filter t_filter);
+
+        /**
+         * @brief Sets the bias added to the mipmap level the GPU selects
+         * @param t_bias The bias (positive values select smaller, blurrier levels)
+         */
+        void setLodBias(float t_bias);
+
         /**
          * @brief Returns the path of the loaded file
          * @return The path of the file
@@ -79,41 +226,82 @@ namespace m3d {
 
         /**
          * @brief Returns a reference to the C3D texture
-         * @return The C3D texture
+         * @return The C3D texture (nullptr if nothing was loaded)
          */
         C3D_Tex* getTexture();
 
+        /**
+         * @brief Returns the data of the texture
+         * @return The data (nullptr if nothing was loaded)
+         */
+        std::shared_ptr<m3d::Texture::Data> getData();
+
+        /**
+         * @brief Sets the data of the texture, sharing it with all other textures using it
+         * @param t_data The data (nullptr to unload the texture)
+         */
+        void setData(std::shared_ptr<m3d::Texture::Data> t_data);
+
+        /**
+         * @brief Returns whether the data of the texture is shared with other textures
+         * @return Whether the data is shared
+         */
+        bool isShared();
+
+        /**
+         * @brief Returns the memory used by the texture on the GPU
+         * @return The size in bytes (including all mipmap levels)
+         */
+        unsigned int getMemoryUsage();
+
+        /**
+         * @brief Returns the memory used by all loaded textures on the GPU
+         * @return The size in bytes (data shared between textures only counts once)
+         */
+        static unsigned int getResidentMemory();
+
         /**
          * @brief Returns the Tex3DS-Subtexture of the texture
-         * @return The subtexture
+         * @return The subtexture (updated if the texture was loaded in the background in the meantime)
          */
         Tex3DS_SubTexture& getSubtexture();
 
         /**
          * @brief Returns a C2D_Image of the texture
-         * @return The C2D_Image
+         * @return The C2D_Image (updated if the texture was loaded in the background in the meantime)
          */
         C2D_Image& getImage();
 
         /**
-         * @brief Overloads the assignment operator
+         * @brief Overloads the assignment operator (the texture shares the data of rhs)
          */
-        m3d::Texture& operator=(m3d::Texture& rhs);
+        m3d::Texture& operator=(const m3d::Texture& rhs);
 
     private:
+        friend class m3d::TextureAtlas;
+        friend class m3d::TextureLoader;
+
         enum class FileType {
             Png,
             Jpg
         };
 
-        bool loadPng(const void* t_fp, bool t_buffer = false);
-        inline void unloadImage(C2D_Image t_image);
-        static inline u32 getNextPow2(u32 v);
+        bool loadPng(m3d::priv::image::PngReader& t_reader, m3d::Texture::Format t_format, bool t_mipmaps);
+        bool createTexture(int t_width, int t_height, u32 t_textureWidth, u32 t_textureHeight, m3d::Texture::Format t_format, u32 t_levels);
+        bool createTexture(const m3d::priv::textureFile::Header& t_header, bool t_mipmaps);
+        bool allocateTexture(int t_width, int t_height, u32 t_textureWidth, u32 t_textureHeight, m3d::Texture::Format t_format, u32 t_levels);
+        void finishTexture(bool t_generateMipmaps);
+        void applyFilters();
+        void destroyTexture();
+        void updateImage();
+        static u32 getNextPow2(u32 v);
 
         /* data */
-        int m_width, m_height;
-        std::string m_path;
-        C3D_Tex* m_texture;
+        m3d::Texture::Filter m_magnificationFilter, m_minificationFilter, m_mipmapFilter;
+        float m_lodBias;
+        bool m_useRegion;
+        int m_regionX, m_regionY, m_regionWidth, m_regionHeight;
+        std::shared_ptr<m3d::Texture::Data> m_data;
         C2D_Image m_image;
         Tex3DS_SubTexture m_subtexture;
     };
@@ -0,0 +1,130 @@
+/**
+ * @file textureAtlas.hpp
+ * @brief Defines the TextureAtlas which packs many images into shared textures
+ */
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "m3d/graphics/texture.hpp"
+#include "m3d/private/skyline.hpp"
+
+namespace m3d {
+    /**
+     * @brief Packs many small images (like icons or UI elements) into a few shared textures
+     *
+     * Every texture gets padded to a power of 2 (of at least 64 pixels), so small images loaded into textures of their own waste most of their memory, and every sprite draws from a different texture, which splits the draws into separate batches. An atlas decodes the images straight into the pages it allocates (textures of the size of the atlas) using a skyline packer and hands out regions of the pages (see m3d::Texture::getRegion()), which can be used by sprites like any other texture. Sprites using regions of the same page get drawn in one batch.
+     *
+     * The images get surrounded by a border of padding, which repeats their outermost pixels, so filtering doesn't sample their neighbours.
+     */
+    class TextureAtlas {
+    public:
+        /**
+         * @brief Creates the atlas
+         * @param t_size    The width and height of the pages (rounded to a power of 2 between 64 and 1024)
+         * @param t_format  The format of the pages (RGBA8 or one of the 16-bit formats)
+         * @param t_padding The padding around each image in pixels
+         */
+        TextureAtlas(int t_size = 512, m3d::Texture::Format t_format = m3d::Texture::Format::RGBA8, int t_padding = 1);
+
+        /**
+         * @brief Adds a .png-file to the atlas
+         * @param  t_name     The name to get the image by (an image added with the same name before gets replaced)
+         * @param  t_filename The name of the file
+         * @return            Whether the image was added (it fails if the image doesn't fit into a page)
+         */
+        bool add(const std::string& t_name, const std::string& t_filename);
+
+        /**
+         * @brief Adds a .png-file in memory to the atlas
+         * @param  t_name   The name to get the image by (an image added with the same name before gets replaced)
+         * @param  t_buffer The buffer containing the whole file
+         * @return          Whether the image was added (it fails if the image doesn't fit into a page)
+         */
+        bool addFromBuffer(const std::string& t_name, const void* t_buffer);
+
+        /**
+         * @brief Returns the texture of an image
+         * @param  t_name The name of the image
+         * @return        The texture covering the region of the image (an empty texture if no image with the name was added)
+         */
+        m3d::Texture get(const std::string& t_name);
+
+        /**
+         * @brief Returns whether an image with the given name was added
+         * @param  t_name The name of the image
+         * @return        Whether the image exists
+         */
+        bool contains(const std::string& t_name);
+
+        /**
+         * @brief Returns the number of images in the atlas
+         * @return The number of images
+         */
+        int getCount();
+
+        /**
+         * @brief Returns the number of allocated pages
+         * @return The number of pages
+         */
+        int getPageCount();
+
+        /**
+         * @brief Returns a page of the atlas
+         * @param  t_index The index of the page
+         * @return         The texture of the page (an empty texture if the index is out of range)
+         */
+        m3d::Texture getPage(int t_index);
+
+        /**
+         * @brief Returns how much of the pages is covered by images
+         * @return The ratio of the packed area (including the padding) to the area of all pages
+         */
+        float getOccupancy();
+
+        /**
+         * @brief Returns the memory used by the pages
+         * @return The size in bytes
+         */
+        unsigned int getMemoryUsage();
+
+        /**
+         * @brief Returns the size of the pages
+         * @return The width and height in pixels
+         */
+        int getSize();
+
+        /**
+         * @brief Returns the format of the pages
+         * @return The format
+         */
+        m3d::Texture::Format getFormat();
+
+        /**
+         * @brief Removes all images and frees the pages
+         * @note Textures of the images keep their page until they get destroyed
+         */
+        void clear();
+
+    private:
+        struct Page {
+            m3d::Texture texture;
+            m3d::priv::skyline::Packer packer;
+        };
+
+        bool add(const std::string& t_name, m3d::priv::image::PngReader& t_reader);
+        bool addPage();
+
+        /* data */
+        int m_size, m_padding;
+        m3d::Texture::Format m_format;
+        std::vector<m3d::TextureAtlas::Page> m_pages;
+        std::map<std::string, m3d::Texture> m_images;
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: TEXTUREATLAS_H */
@@ -0,0 +1,69 @@
+/**
+ * @file textureCache.hpp
+ * @brief Defines the TextureCache which shares loaded textures between textures
+ */
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#pragma once
+#include <memory>
+#include <string>
+#include "m3d/graphics/texture.hpp"
+#include "m3d/private/weakCache.hpp"
+
+namespace m3d {
+    /**
+     * @brief Caches the data of loaded textures by their path
+     *
+     * Textures loading a file which was loaded before (with the same format and mipmap options) share the already uploaded data instead of decoding the file and allocating another texture again (see m3d::Texture::loadFromFile()), so binding the same texture to many meshes only keeps it in memory once.
+     *
+     * The cache only holds weak references, data gets freed as soon as the last texture using it gets destroyed. To keep a texture cached while no texture uses it, keep a handle returned by m3d::TextureCache::get() or m3d::Texture::getData().
+     */
+    class TextureCache {
+    public:
+        /**
+         * @brief Returns the cached data of the given path
+         * @param  t_path The path the texture was loaded from
+         * @return        The data or nullptr if it isn't cached
+         */
+        static std::shared_ptr<m3d::Texture::Data> get(const std::string& t_path);
+
+        /**
+         * @brief Adds the data of a texture to the cache
+         * @param t_path The path the texture was loaded from
+         * @param t_data The data
+         */
+        static void add(const std::string& t_path, std::shared_ptr<m3d::Texture::Data> t_data);
+
+        /**
+         * @brief Removes the data of the given path from the cache
+         * @param t_path The path the texture was loaded from
+         * @note Textures using the data keep using it
+         */
+        static void remove(const std::string& t_path);
+
+        /**
+         * @brief Removes all data from the cache
+         * @note Textures using the data keep using it
+         */
+        static void clear();
+
+        /**
+         * @brief Returns the number of cached textures which are still in use
+         * @return The number of textures
+         */
+        static unsigned int getSize();
+
+        /**
+         * @brief Returns the memory used by the cached textures which are still in use
+         * @return The size in bytes (see m3d::Texture::getResidentMemory() for the memory used by all textures)
+         */
+        static unsigned int getMemoryUsage();
+
+    private:
+        static m3d::priv::WeakCache<m3d::Texture::Data>& getCache();
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: TEXTURECACHE_H */
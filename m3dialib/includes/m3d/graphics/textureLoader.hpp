@@ -0,0 +1,117 @@
+/**
+ * @file textureLoader.hpp
+ * @brief Defines the TextureLoader which loads textures in the background
+ */
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#pragma once
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "m3d/core/mutex.hpp"
+#include "m3d/core/thread.hpp"
+#include "m3d/graphics/color.hpp"
+#include "m3d/graphics/texture.hpp"
+
+namespace m3d {
+    /**
+     * @brief Loads textures in the background (see m3d::Texture::loadFromFileAsync())
+     *
+     * The files get read, decoded, tiled and mipmapped on a worker thread (which runs with a lower priority than the thread loading the textures, so it works while the main thread waits for the next frame). The finished textures get uploaded on the main thread at the start of the next frame (see m3d::Screen::render()), when the GPU doesn't use the placeholders anymore. To keep frames from stalling if many textures finish at once, only as many bytes as the upload budget allows get uploaded per frame (but always at least one texture).
+     *
+     * Textures whose data isn't used by any texture anymore when they finish get discarded instead of uploaded.
+     */
+    class TextureLoader {
+    public:
+        /**
+         * @brief Uploads textures which were decoded in the background
+         * @return The number of uploaded textures
+         * @note This gets called by m3d::Screen::render() at the start of each frame, it only needs to be called manually if nothing gets rendered
+         */
+        static unsigned int publish();
+
+        /**
+         * @brief Blocks until all textures loading in the background are decoded
+         * @note The textures get uploaded at the start of the next frame
+         */
+        static void wait();
+
+        /**
+         * @brief Returns the number of textures which are loading in the background
+         * @return The number of textures which weren't uploaded yet
+         */
+        static unsigned int getPendingCount();
+
+        /**
+         * @brief Sets the number of bytes which get uploaded per frame at most
+         * @param t_bytes The budget in bytes (0 for no limit)
+         */
+        static void setUploadBudget(unsigned int t_bytes);
+
+        /**
+         * @brief Returns the number of bytes which get uploaded per frame at most
+         * @return The budget in bytes (0 for no limit)
+         */
+        static unsigned int getUploadBudget();
+
+        /**
+         * @brief Sets the color of the placeholder textures show while they are loading
+         * @param t_color The color (only applies to textures loaded afterwards)
+         */
+        static void setPlaceholderColor(m3d::Color t_color);
+
+        /**
+         * @brief Returns the color of the placeholder textures show while they are loading
+         * @return The color
+         */
+        static m3d::Color getPlaceholderColor();
+
+    private:
+        friend class m3d::Texture;
+
+        struct Job {
+            // only used on the main thread
+            std::shared_ptr<m3d::Texture::Data> data;
+            m3d::Texture::Filter magnificationFilter, minificationFilter, mipmapFilter;
+            float lodBias;
+
+            // the request, read by the worker
+            std::string path;
+            m3d::Texture::Format format;
+            bool mipmaps;
+
+            // the result, written by the worker
+            bool success;
+            int width, height;
+            u32 textureWidth, textureHeight, levels;
+            u8 textureFormat;
+            u8* texels;
+            u32 size;
+        };
+
+        struct State {
+            m3d::Mutex mutex;
+            m3d::Thread thread;
+            std::deque<m3d::TextureLoader::Job*> queued;
+            std::vector<m3d::TextureLoader::Job*> decoded;
+            bool working;
+            unsigned int pending, uploadBudget;
+            m3d::Color placeholderColor;
+
+            State();
+        };
+
+        static void enqueue(m3d::Texture& t_texture);
+        static unsigned int publish(unsigned int t_budget);
+        static void work(m3d::Parameter);
+        static void decode(m3d::TextureLoader::Job& t_job);
+        static bool decodeFile(m3d::TextureLoader::Job& t_job, FILE* t_file);
+        static m3d::TextureLoader::State& getState();
+    };
+} /* m3d */
+
+
+#endif /* end of include guard: TEXTURELOADER_H */
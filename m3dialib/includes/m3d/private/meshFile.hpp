@@ -0,0 +1,73 @@
+#ifndef MESHFILE_PRIVATE_H
+#define MESHFILE_PRIVATE_H
+
+#pragma once
+#include <cstdint>
+
+/*
+ * The binary mesh format (.m3dm), written by tools/meshconv and read by m3d::Model::loadFromFile().
+ *
+ * A file consists of the header, followed by the vertex blob and the index blob. Both blobs are laid out
+ * exactly like the vertex and index buffers on the GPU, so they can be read straight into linear memory.
+ * All values are little endian.
+ */
+namespace m3d {
+    namespace priv {
+        namespace meshFile {
+            const char magic[4] = { 'M', '3', 'D', 'M' };
+            const uint16_t version = 1;
+
+            // attribute types (the same values as GPU_FORMATS)
+            enum AttributeType : uint8_t {
+                Byte = 0,
+                UnsignedByte = 1,
+                Short = 2,
+                Float = 3
+            };
+
+            // vertex formats (the same values as m3d::Mesh::VertexFormat)
+            enum VertexFormat : uint8_t {
+                FloatFormat = 0,  // 32 bytes: float position[3], texcoord[2], normal[3]
+                CompactFormat = 1 // 16 bytes: s16 position[4], texcoord[2], s8 normal[4]
+            };
+
+            // the size of a single vertex in each format
+            const uint16_t floatStride = 32;
+            const uint16_t compactStride = 16;
+
+            // flags
+            const uint8_t hasMaterial = 1 << 0;
+
+            struct Attribute {
+                uint8_t type;  // the AttributeType of the components
+                uint8_t count; // the number of components
+            };
+
+            struct Header {
+                char magic[4];              // "M3DM"
+                uint16_t version;           // the version of the format
+                uint8_t format;             // the VertexFormat
+                uint8_t flags;              // the flags
+                Attribute attributes[3];    // the layout of v0 (position), v1 (texcoord) and v2 (normal)
+                uint16_t stride;            // the size of a single vertex in bytes
+                uint32_t vertexCount;       // the number of vertices in the vertex blob
+                uint32_t indexCount;        // the number of 16-bit indices in the index blob (0 if the vertices aren't indexed)
+                uint32_t vertexOffset;      // the offset of the vertex blob from the start of the file
+                uint32_t indexOffset;       // the offset of the index blob from the start of the file
+                float quantization[3][4];   // the quantization of the vertices (position scale, position offset, texcoord scale and offset)
+                float boundingMin[3];       // the minimum corner of the bounding box
+                float boundingMax[3];       // the maximum corner of the bounding box
+                float boundingRadius;       // the radius of the bounding sphere (centered on the bounding box)
+                uint8_t ambient[3];         // the ambient color of the material
+                uint8_t diffuse[3];         // the diffuse color of the material
+                uint8_t specular[3];        // the specular color of the material
+                uint8_t padding[3];
+            };
+
+            static_assert(sizeof(Header) == 120, "the mesh file header must be 120 bytes");
+        } /* meshFile */
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: MESHFILE_PRIVATE_H */
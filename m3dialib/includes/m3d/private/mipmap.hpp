@@ -0,0 +1,37 @@
+#ifndef MIPMAP_PRIVATE_H
+#define MIPMAP_PRIVATE_H
+
+#pragma once
+#include <cstdint>
+
+/*
+ * Mipmap generation, used by m3d::Texture and the host tools.
+ *
+ * Every level gets box-filtered from the one before it. In the tiled layout (see tiling.hpp) the 2x2 pixels
+ * averaged into a pixel of the next level are always four consecutive texels, so the levels get generated
+ * straight from the tiled texture, without untiling it. The channels of a texel get averaged in two groups of
+ * non-adjacent channels (so their sums don't overflow into each other), which works for RGBA8 and every 16-bit
+ * format. The levels of a texture are stored one after another, each half the size of the one before, down to
+ * 8x8 pixels (the size of a tile). It doesn't depend on anything 3DS-specific, so it can be compiled for the
+ * host as well.
+ */
+namespace m3d {
+    namespace priv {
+        namespace mipmap {
+            // the number of levels of a t_width x t_height texture (including the full-sized one)
+            uint32_t getLevelCount(uint32_t t_width, uint32_t t_height);
+
+            // the size of all t_levels levels of a texture in bytes
+            uint32_t getTotalSize(uint32_t t_width, uint32_t t_height, uint32_t t_levels, uint32_t t_bitsPerTexel);
+
+            // fills levels 1 to t_levels - 1 of a tiled texture from its first level, returns false for compressed formats
+            bool generateTiled(void* t_texels, uint32_t t_width, uint32_t t_height, uint8_t t_format, uint32_t t_levels);
+
+            // halves a t_width x t_height image of 32-bit pixels (row by row)
+            void downsample(uint32_t* t_destination, const uint32_t* t_source, uint32_t t_width, uint32_t t_height);
+        } /* mipmap */
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: MIPMAP_PRIVATE_H */
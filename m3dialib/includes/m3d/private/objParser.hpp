@@ -0,0 +1,104 @@
+#ifndef OBJPARSER_PRIVATE_H
+#define OBJPARSER_PRIVATE_H
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * A streaming .obj-parser used by m3d::Model and the host tools.
+ *
+ * Files get read in chunks into a single buffer and tokenized in place. Numbers get parsed without allocating
+ * and faces get resolved into an indexed vertex list while parsing (vertices sharing the same position,
+ * texture coordinate and normal get the same index). Apart from the output and the attribute pools (which
+ * grow geometrically), parsing doesn't allocate memory. It doesn't depend on anything 3DS-specific, so it can
+ * be compiled for the host as well.
+ */
+namespace m3d {
+    namespace priv {
+        namespace obj {
+            // the same layout as m3d::Mesh::Polygon::Vertex
+            struct Vertex {
+                float position[3];
+                float texcoord[2];
+                float normal[3];
+            };
+
+            struct Material {
+                std::string name;
+                float ambient[3];
+                float diffuse[3];
+                float specular[3];
+            };
+
+            class Parser {
+            public:
+                Parser();
+                ~Parser();
+
+                // parses the given file (and its material library), the output of previously parsed files gets discarded
+                bool parseFile(const std::string& t_path);
+
+                // only parses the material of the given file (and its material library), skipping the geometry
+                bool parseMaterial(const std::string& t_path);
+
+                // the parsed vertices and the indices of the triangles (polygons get triangulated as a fan)
+                std::vector<m3d::priv::obj::Vertex>& getVertices();
+                std::vector<unsigned int>& getIndices();
+
+                // the first material used by the model
+                bool hasMaterial();
+                const m3d::priv::obj::Material& getMaterial();
+
+                // frees all memory
+                void clear();
+
+            private:
+                struct Corner {
+                    int32_t position, texcoord, normal;
+                };
+
+                struct Slot {
+                    int32_t position, texcoord, normal;
+                    uint32_t index;
+                };
+
+                typedef bool (Parser::*LineHandler)(const char*, const char*);
+
+                bool begin(const std::string& t_path);
+                void resolveMaterial();
+                bool readLines(const std::string& t_path, LineHandler t_handler);
+                bool parseObjLine(const char* t_begin, const char* t_end);
+                bool parseMaterialLine(const char* t_begin, const char* t_end);
+                bool parseMtlLine(const char* t_begin, const char* t_end);
+                bool parseFace(const char* t_begin, const char* t_end);
+                uint32_t getVertex(const m3d::priv::obj::Parser::Corner& t_corner, const float* t_faceNormal);
+                void growLookup();
+
+                /* data */
+                char* m_buffer;
+                std::string m_directory, m_usedMaterial;
+                bool m_materialUsed;
+
+                // attribute pools
+                std::vector<float> m_positions, m_texcoords, m_normals;
+
+                // output
+                std::vector<m3d::priv::obj::Vertex> m_vertices;
+                std::vector<unsigned int> m_indices;
+                std::vector<m3d::priv::obj::Material> m_materials;
+                int m_material;
+
+                // scratch space and vertex lookup (open addressing)
+                std::vector<m3d::priv::obj::Parser::Corner> m_corners;
+                std::vector<m3d::priv::obj::Parser::Slot> m_lookup;
+                size_t m_lookupCount;
+            };
+        } /* obj */
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: OBJPARSER_PRIVATE_H */
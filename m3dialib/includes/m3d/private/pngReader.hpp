@@ -0,0 +1,62 @@
+#ifndef PNGREADER_PRIVATE_H
+#define PNGREADER_PRIVATE_H
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <png.h>
+#include "texelFormat.hpp"
+
+/*
+ * A streaming .png-decoder used by m3d::Texture and the host tools.
+ *
+ * Images get decoded row by row into a single scratch row, which gets written straight into the tiled layout of
+ * the texture (see tiling.hpp), so decoding needs one allocation for the row and the column offsets instead of a
+ * copy of the whole image (only interlaced images, whose rows get completed over several passes, need the whole
+ * image). Any format gets converted to 32-bit ABGR pixels (RGBA8 on the PICA200), which can be converted into one
+ * of the 16-bit formats row by row (see texelFormat.hpp).
+ */
+namespace m3d {
+    namespace priv {
+        namespace image {
+            class PngReader {
+            public:
+                PngReader();
+                ~PngReader();
+
+                // reads the header of the image, the file has to stay open until the image got read
+                bool open(FILE* t_file);
+
+                // reads the header of an image in memory, the buffer has to contain the whole file
+                bool open(const void* t_buffer);
+
+                uint32_t getWidth();
+                uint32_t getHeight();
+
+                // decodes the image into a tiled texture in RGBA8 or one of the 16-bit formats, t_textureWidth has to be a multiple of 8 (at least the width of the image)
+                // the image gets placed at (t_x, t_y) of the texture (e.g. in an atlas), which has to be large enough to hold it there
+                bool readTiled(void* t_texels, uint32_t t_textureWidth, m3d::priv::texel::Format t_format = m3d::priv::texel::RGBA8, uint32_t t_x = 0, uint32_t t_y = 0);
+
+                // decodes the image into 32-bit pixels, row by row
+                bool read(uint32_t* t_pixels);
+
+                // frees all memory
+                void close();
+
+            private:
+                bool readHeader();
+
+                /* data */
+                png_structp m_png;
+                png_infop m_info;
+                uint32_t m_width, m_height;
+                int m_passes;
+                unsigned char* m_scratch;
+                const unsigned char* m_position;
+            };
+        } /* image */
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: PNGREADER_PRIVATE_H */
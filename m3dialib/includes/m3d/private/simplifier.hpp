@@ -0,0 +1,35 @@
+#ifndef SIMPLIFIER_PRIVATE_H
+#define SIMPLIFIER_PRIVATE_H
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/*
+ * Mesh simplification using quadric error metrics (Garland and Heckbert), used by m3d::Mesh::simplify() and
+ * the host tools.
+ *
+ * Edges get collapsed onto one of their vertices (half-edge collapses), so no new vertices get created and the
+ * texture coordinates and normals of the remaining vertices stay untouched. Vertices sharing a position but not
+ * their other attributes (UV seams and hard edges) only get collapsed if every one of them has a matching
+ * partner at the target position, so seams don't tear. Open borders get preserved by additional planes
+ * perpendicular to them, and collapses flipping a triangle get rejected. Vertices no triangle refers to anymore
+ * can be removed using m3d::priv::vertexCache::optimizeVertexFetch(). It doesn't depend on anything
+ * 3DS-specific, so it can be compiled for the host as well.
+ */
+namespace m3d {
+    namespace priv {
+        namespace simplify {
+            /*
+             * Reduces the triangles given by t_indices (in place) to at most t_targetIndexCount indices, unless
+             * that would exceed t_maxError (the allowed deviation, relative to the size of the mesh). The
+             * positions are the first three floats of each vertex, t_stride is the size of a vertex in bytes.
+             * Returns the relative error of the result.
+             */
+            float simplify(std::vector<unsigned int>& t_indices, const float* t_positions, size_t t_vertexCount, size_t t_stride, size_t t_targetIndexCount, float t_maxError);
+        } /* simplify */
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: SIMPLIFIER_PRIVATE_H */
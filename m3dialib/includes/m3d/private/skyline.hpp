@@ -0,0 +1,55 @@
+#ifndef SKYLINE_PRIVATE_H
+#define SKYLINE_PRIVATE_H
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * A skyline rectangle packer, used by m3d::TextureAtlas.
+ *
+ * The packed area is described by its skyline, the top edge of the rectangles packed so far as a list of
+ * horizontal segments. A rectangle gets placed on top of the skyline where its top ends up lowest (bottom-left
+ * rule), ties go to the narrowest segment, so rectangles of similar heights end up next to each other. The space
+ * below a rectangle spanning several segments is lost, which for images of similar sizes (like icons and glyphs)
+ * is little, while a placement only has to look at the segments instead of a list of free rectangles. It doesn't
+ * depend on anything 3DS-specific, so it can be compiled for the host as well.
+ */
+namespace m3d {
+    namespace priv {
+        namespace skyline {
+            class Packer {
+            public:
+                Packer(uint32_t t_width, uint32_t t_height);
+
+                // finds a place for a rectangle and adds it, returns false if it doesn't fit anymore
+                bool insert(uint32_t t_width, uint32_t t_height, uint32_t& t_x, uint32_t& t_y);
+
+                // removes all rectangles
+                void clear();
+
+                // the area of all packed rectangles
+                uint32_t getUsedArea();
+
+                // the ratio of the packed area to the whole area
+                float getOccupancy();
+
+            private:
+                struct Segment {
+                    uint32_t x, y, width;
+                };
+
+                // the y a rectangle placed at the segment would end up at, false if it doesn't fit there
+                bool fits(size_t t_index, uint32_t t_width, uint32_t t_height, uint32_t& t_y);
+
+                /* data */
+                uint32_t m_width, m_height, m_usedArea;
+                std::vector<Segment> m_segments;
+            };
+        } /* skyline */
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: SKYLINE_PRIVATE_H */
@@ -0,0 +1,103 @@
+#ifndef TEXELFORMAT_PRIVATE_H
+#define TEXELFORMAT_PRIVATE_H
+
+#pragma once
+#include <cstdint>
+
+/*
+ * The texel formats of the PICA200, used by m3d::Texture and the host tools.
+ *
+ * Images get decoded into 32-bit pixels (0xRRGGBBAA as a little-endian word, which is RGBA8), the 16-bit formats
+ * get converted from those one row at a time and can be tiled like any other row (see tiling.hpp). ETC1 packs
+ * 4x4 blocks into 64 bits (plus 64 bits of 4-bit alpha for ETC1A4), four blocks per 8x8 tile in Z-order, so it
+ * gets encoded from the whole image instead. It doesn't depend on anything 3DS-specific, so it can be compiled
+ * for the host as well.
+ */
+namespace m3d {
+    namespace priv {
+        namespace texel {
+            // the texel formats (the same values as GPU_TEXCOLOR)
+            enum Format : uint8_t {
+                RGBA8 = 0x0,
+                RGBA5551 = 0x2,
+                RGB565 = 0x3,
+                RGBA4 = 0x4,
+                LA8 = 0x5,
+                ETC1 = 0xC,
+                ETC1A4 = 0xD
+            };
+
+            // the size of a texel in bits, 0 for unsupported formats
+            inline uint32_t getBitsPerTexel(uint8_t t_format) {
+                switch (t_format) {
+                    case RGBA8:
+                        return 32;
+                    case RGBA5551:
+                    case RGB565:
+                    case RGBA4:
+                    case LA8:
+                        return 16;
+                    case ETC1:
+                        return 4;
+                    case ETC1A4:
+                        return 8;
+                    default:
+                        return 0;
+                }
+            }
+
+            inline bool isCompressed(uint8_t t_format) {
+                return t_format == ETC1 || t_format == ETC1A4;
+            }
+
+            inline uint16_t toRgba5551(uint32_t t_pixel) {
+                return ((t_pixel >> 16) & 0xF800) | ((t_pixel >> 13) & 0x07C0) | ((t_pixel >> 10) & 0x003E) | ((t_pixel >> 7) & 0x0001);
+            }
+
+            inline uint16_t toRgb565(uint32_t t_pixel) {
+                return ((t_pixel >> 16) & 0xF800) | ((t_pixel >> 13) & 0x07E0) | ((t_pixel >> 11) & 0x001F);
+            }
+
+            inline uint16_t toRgba4(uint32_t t_pixel) {
+                return ((t_pixel >> 16) & 0xF000) | ((t_pixel >> 12) & 0x0F00) | ((t_pixel >> 8) & 0x00F0) | ((t_pixel >> 4) & 0x000F);
+            }
+
+            inline uint16_t toLa8(uint32_t t_pixel) {
+                // the luminance uses the Rec. 601 weights (77, 150 and 29 out of 256)
+                uint32_t luminance = ((t_pixel >> 24) * 77 + ((t_pixel >> 16) & 0xFF) * 150 + ((t_pixel >> 8) & 0xFF) * 29) >> 8;
+                return (luminance << 8) | (t_pixel & 0xFF);
+            }
+
+            // converts a row of 32-bit pixels into one of the 16-bit formats, returns false for any other format
+            inline bool convertRow(uint16_t* t_output, const uint32_t* t_row, uint32_t t_width, uint8_t t_format) {
+                switch (t_format) {
+                    case RGBA5551:
+                        for (uint32_t x = 0; x < t_width; x++) t_output[x] = toRgba5551(t_row[x]);
+                        return true;
+                    case RGB565:
+                        for (uint32_t x = 0; x < t_width; x++) t_output[x] = toRgb565(t_row[x]);
+                        return true;
+                    case RGBA4:
+                        for (uint32_t x = 0; x < t_width; x++) t_output[x] = toRgba4(t_row[x]);
+                        return true;
+                    case LA8:
+                        for (uint32_t x = 0; x < t_width; x++) t_output[x] = toLa8(t_row[x]);
+                        return true;
+                    default:
+                        return false;
+                }
+            }
+
+            /*
+             * Encodes the t_width x t_height 32-bit pixels of an image (row by row) into a t_textureWidth x
+             * t_textureHeight texture in ETC1 (or ETC1A4 if t_alpha is true), the padding around the image is
+             * transparent black. t_output has to hold t_textureWidth * t_textureHeight / 2 bytes (twice as many
+             * for ETC1A4), the texture size has to be a multiple of 8.
+             */
+            void encodeEtc1(void* t_output, const uint32_t* t_pixels, uint32_t t_width, uint32_t t_height, uint32_t t_textureWidth, uint32_t t_textureHeight, bool t_alpha);
+        } /* texel */
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: TEXELFORMAT_PRIVATE_H */
@@ -0,0 +1,54 @@
+#ifndef TEXTUREFILE_PRIVATE_H
+#define TEXTUREFILE_PRIVATE_H
+
+#pragma once
+#include <cstdint>
+#include "m3d/private/mipmap.hpp"
+#include "m3d/private/texelFormat.hpp"
+
+/*
+ * The binary texture format (.m3dt), written by tools/texconv and read by m3d::Texture::loadFromFile().
+ *
+ * A file consists of the header, followed by the texel blob. The blob is laid out exactly like the texture on
+ * the GPU (tiled, or in ETC1 blocks, followed by the smaller mipmap levels), so it can be read straight into the
+ * texture. All values are little endian.
+ */
+namespace m3d {
+    namespace priv {
+        namespace textureFile {
+            const char magic[4] = { 'M', '3', 'D', 'T' };
+            const uint16_t version = 2;
+
+            struct Header {
+                char magic[4];              // "M3DT"
+                uint16_t version;           // the version of the format
+                uint8_t format;             // the m3d::priv::texel::Format (the same values as GPU_TEXCOLOR)
+                uint8_t levels;             // the number of mipmap levels (1 without mipmaps)
+                uint16_t width;             // the width of the image
+                uint16_t height;            // the height of the image
+                uint16_t textureWidth;      // the width of the texture (a power of 2)
+                uint16_t textureHeight;     // the height of the texture (a power of 2)
+                uint32_t dataOffset;        // the offset of the texel blob from the start of the file
+                uint32_t dataSize;          // the size of the texel blob in bytes (all levels)
+            };
+
+            static_assert(sizeof(Header) == 24, "the texture file header must be 24 bytes");
+
+            // checks whether the header describes a texture the GPU can use (and the size of its blob matches)
+            inline bool isValid(const Header& t_header) {
+                uint32_t bits = m3d::priv::texel::getBitsPerTexel(t_header.format);
+
+                return t_header.version == version &&
+                       bits != 0 &&
+                       t_header.levels >= 1 &&
+                       t_header.levels <= m3d::priv::mipmap::getLevelCount(t_header.textureWidth, t_header.textureHeight) &&
+                       t_header.width <= t_header.textureWidth &&
+                       t_header.height <= t_header.textureHeight &&
+                       t_header.dataSize == m3d::priv::mipmap::getTotalSize(t_header.textureWidth, t_header.textureHeight, t_header.levels, bits);
+            }
+        } /* textureFile */
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: TEXTUREFILE_PRIVATE_H */
@@ -0,0 +1,53 @@
+#ifndef TILING_PRIVATE_H
+#define TILING_PRIVATE_H
+
+#pragma once
+#include <cstdint>
+
+/*
+ * The tiled texture layout of the PICA200, used by m3d::Texture and the host tools.
+ *
+ * Textures are stored in 8x8 tiles, the tiles row by row and the pixels within a tile in Morton (Z-)order. The
+ * offset of a pixel is the sum of an offset depending only on its column and one depending only on its row, so
+ * rows can be written using a table of column offsets built once per image, instead of interleaving the bits
+ * of every pixel. It doesn't depend on anything 3DS-specific, so it can be compiled for the host as well.
+ */
+namespace m3d {
+    namespace priv {
+        namespace tiling {
+            // the offset (in pixels) of a column from the start of its row of tiles
+            inline uint32_t getColumnOffset(uint32_t t_x) {
+                return ((t_x >> 3) << 6) | (t_x & 1) | ((t_x & 2) << 1) | ((t_x & 4) << 2);
+            }
+
+            // the offset (in pixels) of a row from the start of the texture, t_textureWidth is a multiple of 8
+            inline uint32_t getRowOffset(uint32_t t_y, uint32_t t_textureWidth) {
+                return (t_y >> 3) * (t_textureWidth << 3) + (((t_y & 1) << 1) | ((t_y & 2) << 2) | ((t_y & 4) << 3));
+            }
+
+            // fills t_offsets with the offsets of t_width columns, starting at column t_x
+            inline void buildColumnOffsets(uint32_t* t_offsets, uint32_t t_width, uint32_t t_x = 0) {
+                for (uint32_t x = 0; x < t_width; x++) t_offsets[x] = getColumnOffset(t_x + x);
+            }
+
+            // writes a row of pixels into the tiled texture, one store per pixel
+            template <typename T>
+            inline void writeRow(T* t_texels, const uint32_t* t_columnOffsets, const T* t_row, uint32_t t_width, uint32_t t_y, uint32_t t_textureWidth) {
+                T* destination = t_texels + getRowOffset(t_y, t_textureWidth);
+                uint32_t x = 0;
+
+                for (; x + 4 <= t_width; x += 4) {
+                    destination[t_columnOffsets[x]]     = t_row[x];
+                    destination[t_columnOffsets[x + 1]] = t_row[x + 1];
+                    destination[t_columnOffsets[x + 2]] = t_row[x + 2];
+                    destination[t_columnOffsets[x + 3]] = t_row[x + 3];
+                }
+
+                for (; x < t_width; x++) destination[t_columnOffsets[x]] = t_row[x];
+            }
+        } /* tiling */
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: TILING_PRIVATE_H */
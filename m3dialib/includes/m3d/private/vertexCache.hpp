@@ -0,0 +1,69 @@
+#ifndef VERTEXCACHE_PRIVATE_H
+#define VERTEXCACHE_PRIVATE_H
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/*
+ * Reordering of indexed meshes for the post-transform vertex cache, used by m3d::Mesh and the host tools.
+ *
+ * Triangles get reordered using Tom Forsyth's linear-speed vertex cache optimisation, so triangles sharing
+ * vertices get drawn close to each other and the vertices get transformed (run through the vertex shader)
+ * fewer times. Vertices then get reordered in the order of their first use, so they get fetched from memory
+ * sequentially. It doesn't depend on anything 3DS-specific, so it can be compiled for the host as well.
+ */
+namespace m3d {
+    namespace priv {
+        namespace vertexCache {
+            // the size of the FIFO cache the ACMR gets simulated for
+            const unsigned int SimulatedCacheSize = 16;
+
+            // reorders the triangles given by t_indices (in place)
+            void optimizeTriangles(std::vector<unsigned int>& t_indices, size_t t_vertexCount);
+
+            // reorders the vertices in the order of their first use and removes the ones no triangle refers to
+            template <typename T>
+            void optimizeVertexFetch(std::vector<T>& t_vertices, std::vector<unsigned int>& t_indices) {
+                std::vector<unsigned int> remap(t_vertices.size(), ~0u);
+                std::vector<T> vertices;
+                vertices.reserve(t_vertices.size());
+
+                for (auto& index : t_indices) {
+                    if (remap[index] == ~0u) {
+                        remap[index] = vertices.size();
+                        vertices.push_back(t_vertices[index]);
+                    }
+
+                    index = remap[index];
+                }
+
+                t_vertices.swap(vertices);
+            }
+
+            // the average cache miss ratio (transformed vertices per triangle, between 0.5 and 3, lower is better)
+            template <typename T>
+            float getAcmr(const T* t_indices, size_t t_indexCount, size_t t_vertexCount, unsigned int t_cacheSize = SimulatedCacheSize) {
+                if (t_indexCount < 3) return 0.0f;
+
+                // the time each vertex entered the cache, a vertex is cached if it entered within the last t_cacheSize misses
+                std::vector<size_t> entered(t_vertexCount, 0);
+                size_t misses = 0;
+
+                for (size_t i = 0; i < t_indexCount; i++) {
+                    size_t& time = entered[t_indices[i]];
+
+                    if (time == 0 || misses - time >= t_cacheSize) {
+                        misses++;
+                        time = misses;
+                    }
+                }
+
+                return static_cast<float>(misses) / (t_indexCount / 3);
+            }
+        } /* vertexCache */
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: VERTEXCACHE_PRIVATE_H */
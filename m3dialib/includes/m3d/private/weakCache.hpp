@@ -0,0 +1,102 @@
+#ifndef WEAKCACHE_PRIVATE_H
+#define WEAKCACHE_PRIVATE_H
+
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+
+/*
+ * A cache of shared resources by their key, used by m3d::MeshCache, m3d::SpriteSheetCache and m3d::TextureCache.
+ *
+ * The cache only holds weak references, so it never keeps a resource alive on its own. Entries whose resource
+ * was freed get dropped when they're looked up and whenever a resource gets added. Resources which are still
+ * alive when their entry gets removed or replaced are handed to the release function (if any), so the owners
+ * can undo whatever they did when adding them.
+ */
+namespace m3d {
+    namespace priv {
+        template <typename T>
+        class WeakCache {
+        public:
+            typedef void (*ReleaseFunction)(T&);
+
+            WeakCache(ReleaseFunction t_release = nullptr) :
+                m_release(t_release) { /* do nothing */ }
+
+            // the resource of the given key, nullptr if it isn't cached (anymore)
+            std::shared_ptr<T> get(const std::string& t_key) {
+                auto entry = m_entries.find(t_key);
+
+                if (entry == m_entries.end()) return nullptr;
+
+                std::shared_ptr<T> value = entry->second.lock();
+
+                // the resource was freed since nothing used it anymore
+                if (!value) m_entries.erase(entry);
+
+                return value;
+            }
+
+            // adds a resource, replacing the one cached under the same key
+            void add(const std::string& t_key, std::shared_ptr<T> t_value) {
+                // drop entries whose resource was freed
+                for (auto it = m_entries.begin(); it != m_entries.end();) {
+                    if (it->second.expired()) {
+                        it = m_entries.erase(it);
+                    } else {
+                        it++;
+                    }
+                }
+
+                std::shared_ptr<T> previous = get(t_key);
+                if (previous && previous != t_value) release(previous);
+
+                m_entries[t_key] = t_value;
+            }
+
+            // removes a resource from the cache, the ones using it keep it
+            void remove(const std::string& t_key) {
+                release(get(t_key));
+                m_entries.erase(t_key);
+            }
+
+            void clear() {
+                for (auto& entry : m_entries) release(entry.second.lock());
+                m_entries.clear();
+            }
+
+            // the number of cached resources which are still alive
+            unsigned int getSize() {
+                unsigned int size = 0;
+
+                for (const auto& entry : m_entries) {
+                    if (!entry.second.expired()) size++;
+                }
+
+                return size;
+            }
+
+            // calls the function with each cached resource which is still alive
+            template <typename F>
+            void forEach(F t_function) {
+                for (const auto& entry : m_entries) {
+                    std::shared_ptr<T> value = entry.second.lock();
+                    if (value) t_function(*value);
+                }
+            }
+
+        private:
+            void release(const std::shared_ptr<T>& t_value) {
+                if (m_release && t_value) m_release(*t_value);
+            }
+
+            /* data */
+            ReleaseFunction m_release;
+            std::map<std::string, std::weak_ptr<T>> m_entries;
+        };
+    } /* priv */
+} /* m3d */
+
+
+#endif /* end of include guard: WEAKCACHE_PRIVATE_H */
@@ -34,7 +34,11 @@ namespace m3d {
 
     void Thread::start(bool t_detached) {
         if (!m_running) {
-            m_started = true;
+            // free the thread which ran before
+            join();
+
+            // detached threads free themselves
+            m_started = !t_detached;
             m_running = true;
             s32 prio;
             svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
@@ -49,7 +53,8 @@ namespace m3d {
     }
 
     void Thread::join(long long unsigned int t_timeout) {
-        if (m_running) {
+        // threads which already returned have to be freed as well
+        if (m_started) {
             threadJoin(m_thread, t_timeout);
             threadFree(m_thread);
             m_running = false;
@@ -1,6 +1,23 @@
 #include <cmath>
 #include "m3d/graphics/camera.hpp"
 
+namespace {
+    // the Hamilton product, so the result rotates by t_rhs first and by t_lhs second
+    C3D_FQuat multiply(C3D_FQuat t_lhs, C3D_FQuat t_rhs) {
+        return Quat_New(
+            t_lhs.r * t_rhs.i + t_lhs.i * t_rhs.r + t_lhs.j * t_rhs.k - t_lhs.k * t_rhs.j,
+            t_lhs.r * t_rhs.j - t_lhs.i * t_rhs.k + t_lhs.j * t_rhs.r + t_lhs.k * t_rhs.i,
+            t_lhs.r * t_rhs.k + t_lhs.i * t_rhs.j - t_lhs.j * t_rhs.i + t_lhs.k * t_rhs.r,
+            t_lhs.r * t_rhs.r - t_lhs.i * t_rhs.i - t_lhs.j * t_rhs.j - t_lhs.k * t_rhs.k
+        );
+    }
+
+    C3D_FQuat fromAxisAngle(float t_x, float t_y, float t_z, float t_angle) {
+        float s = sinf(t_angle / 2);
+        return Quat_New(t_x * s, t_y * s, t_z * s, cosf(t_angle / 2));
+    }
+}
+
 namespace m3d {
     Camera::Camera() :
         m_posX(0.0f),
@@ -8,30 +25,41 @@ namespace m3d {
         m_posZ(0.0f),
         m_rotationX(0.0f),
         m_rotationY(0.0f),
-        m_rotationZ(0.0f) { /* do nothing */ }
+        m_rotationZ(0.0f),
+        m_fieldOfView(C3D_AngleFromDegrees(40.0f)),
+        m_near(0.01f),
+        m_far(1000.0f),
+        m_orientation(Quat_Identity()),
+        m_viewDirty(true),
+        m_nextProjection(0) {
+            m_projections[0].valid = m_projections[1].valid = false;
+        }
 
     void Camera::setPitch(float t_rotation, bool t_radians) {
         m_rotationX = (t_radians ? t_rotation : C3D_AngleFromDegrees(t_rotation));
+        updateOrientation();
     }
 
     float Camera::getPitch(bool t_radians) {
-        return (t_radians ? m_rotationX : C3D_AngleFromDegrees(m_rotationX));
+        return (t_radians ? m_rotationX : m_rotationX * 180.0f / M_PI);
     }
 
     void Camera::setYaw(float t_rotation, bool t_radians) {
         m_rotationY = (t_radians ? t_rotation : C3D_AngleFromDegrees(t_rotation));
+        updateOrientation();
     }
 
     float Camera::getYaw(bool t_radians) {
-        return (t_radians ? m_rotationY : C3D_AngleFromDegrees(m_rotationY));
+        return (t_radians ? m_rotationY : m_rotationY * 180.0f / M_PI);
     }
 
     void Camera::setRoll(float t_rotation, bool t_radians) {
         m_rotationZ = (t_radians ? t_rotation : C3D_AngleFromDegrees(t_rotation));
+        updateOrientation();
     }
 
     float Camera::getRoll(bool t_radians) {
-        return (t_radians ? m_rotationZ : C3D_AngleFromDegrees(m_rotationZ));
+        return (t_radians ? m_rotationZ : m_rotationZ * 180.0f / M_PI);
     }
 
     void Camera::setRotation(float t_pitch, float t_yaw, float t_roll, bool t_radians) {
@@ -44,22 +72,28 @@ namespace m3d {
             m_rotationY = C3D_AngleFromDegrees(t_yaw);
             m_rotationZ = C3D_AngleFromDegrees(t_roll);
         }
+
+        updateOrientation();
     }
 
     void Camera::rotatePitch(float t_delta, bool t_radians) {
         m_rotationX += (t_radians ? t_delta : C3D_AngleFromDegrees(t_delta));
+        updateOrientation();
     }
 
     void Camera::rotateYaw(float t_delta, bool t_radians) {
         m_rotationY += (t_radians ? t_delta : C3D_AngleFromDegrees(t_delta));
+        updateOrientation();
     }
 
     void Camera::rotateRoll(float t_delta, bool t_radians) {
         m_rotationZ += (t_radians ? t_delta : C3D_AngleFromDegrees(t_delta));
+        updateOrientation();
     }
 
     void Camera::setPositionX(float t_position) {
         m_posX = t_position;
+        invalidateView();
     }
 
     float Camera::getPositionX() {
@@ -68,6 +102,7 @@ namespace m3d {
 
     void Camera::setPositionY(float t_position) {
         m_posY = t_position;
+        invalidateView();
     }
 
     float Camera::getPositionY() {
@@ -76,6 +111,7 @@ namespace m3d {
 
     void Camera::setPositionZ(float t_position) {
         m_posZ = t_position;
+        invalidateView();
     }
 
     float Camera::getPositionZ() {
@@ -86,33 +122,208 @@ namespace m3d {
         m_posX = t_positionX;
         m_posY = t_positionY;
         m_posZ = t_positionZ;
+        invalidateView();
     }
 
     void Camera::setPosition(m3d::Vector3f t_position) {
-        m_posX = t_position.x;
-        m_posY = t_position.y;
-        m_posZ = t_position.z;
+        setPosition(t_position.x, t_position.y, t_position.z);
     }
 
     void Camera::moveX(float t_delta) {
         m_posX += t_delta;
+        invalidateView();
     }
 
     void Camera::moveY(float t_delta) {
         m_posY += t_delta;
+        invalidateView();
     }
 
     void Camera::moveZ(float t_delta) {
         m_posZ += t_delta;
+        invalidateView();
+    }
+
+    void Camera::setOrientation(C3D_FQuat t_orientation) {
+        m_orientation = Quat_Normalize(t_orientation);
+        updateAngles();
+        invalidateView();
+    }
+
+    C3D_FQuat Camera::getOrientation() {
+        return m_orientation;
+    }
+
+    void Camera::rotate(m3d::Vector3f t_axis, float t_angle, bool t_radians) {
+        float length = sqrtf(t_axis.x * t_axis.x + t_axis.y * t_axis.y + t_axis.z * t_axis.z);
+        if (length <= 0.0f) return;
+
+        // rotating the view around an axis in view space, the same way rotatePitch() does for the X-axis
+        m_orientation = Quat_Normalize(multiply(fromAxisAngle(t_axis.x / length, t_axis.y / length, t_axis.z / length, (t_radians ? t_angle : C3D_AngleFromDegrees(t_angle))), m_orientation));
+        updateAngles();
+        invalidateView();
+    }
+
+    m3d::Vector3f Camera::getEyePosition() {
+        // the view matrix translates by (x, -y, z) before rotating (see getViewMatrix())
+        return { -m_posX, m_posY, -m_posZ };
+    }
+
+    void Camera::lookAt(m3d::Vector3f t_target, m3d::Vector3f t_up) {
+        // the eye and the target in view-independent coordinates (see getViewMatrix() and m3d::Mesh)
+        m3d::Vector3f eyePosition = getEyePosition();
+        C3D_FVec eye = FVec3_New(eyePosition.x, eyePosition.y, eyePosition.z),
+                 target = FVec3_New(t_target.x, t_target.y, -1.87f - t_target.z),
+                 direction = FVec3_Subtract(target, eye);
+
+        if (FVec3_Dot(direction, direction) <= 0.0f) return;
+
+        C3D_FVec forward = FVec3_Normalize(direction),
+                 side = FVec3_Cross(forward, FVec3_New(t_up.x, t_up.y, t_up.z));
+
+        // looking straight along the up-vector, any side is fine
+        if (FVec3_Dot(side, side) <= 1e-12f) side = FVec3_Cross(forward, fabsf(forward.x) < 0.9f ? FVec3_New(1.0f, 0.0f, 0.0f) : FVec3_New(0.0f, 0.0f, 1.0f));
+
+        side = FVec3_Normalize(side);
+        C3D_FVec up = FVec3_Cross(side, forward);
+
+        // the rows of the rotation matrix are side, up and -forward
+        float m[3][3] = {
+            { side.x, side.y, side.z },
+            { up.x, up.y, up.z },
+            { -forward.x, -forward.y, -forward.z }
+        };
+
+        float trace = m[0][0] + m[1][1] + m[2][2], x, y, z, w;
+
+        if (trace > 0.0f) {
+            float s = sqrtf(trace + 1.0f) * 2.0f;
+            w = 0.25f * s;
+            x = (m[2][1] - m[1][2]) / s;
+            y = (m[0][2] - m[2][0]) / s;
+            z = (m[1][0] - m[0][1]) / s;
+        } else if (m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+            float s = sqrtf(1.0f + m[0][0] - m[1][1] - m[2][2]) * 2.0f;
+            w = (m[2][1] - m[1][2]) / s;
+            x = 0.25f * s;
+            y = (m[0][1] + m[1][0]) / s;
+            z = (m[0][2] + m[2][0]) / s;
+        } else if (m[1][1] > m[2][2]) {
+            float s = sqrtf(1.0f + m[1][1] - m[0][0] - m[2][2]) * 2.0f;
+            w = (m[0][2] - m[2][0]) / s;
+            x = (m[0][1] + m[1][0]) / s;
+            y = 0.25f * s;
+            z = (m[1][2] + m[2][1]) / s;
+        } else {
+            float s = sqrtf(1.0f + m[2][2] - m[0][0] - m[1][1]) * 2.0f;
+            w = (m[1][0] - m[0][1]) / s;
+            x = (m[0][2] + m[2][0]) / s;
+            y = (m[1][2] + m[2][1]) / s;
+            z = 0.25f * s;
+        }
+
+        setOrientation(Quat_New(x, y, z, w));
+    }
+
+    void Camera::setFieldOfView(float t_fieldOfView, bool t_radians) {
+        m_fieldOfView = (t_radians ? t_fieldOfView : C3D_AngleFromDegrees(t_fieldOfView));
+        m_projections[0].valid = m_projections[1].valid = false;
+    }
+
+    float Camera::getFieldOfView(bool t_radians) {
+        return (t_radians ? m_fieldOfView : m_fieldOfView * 180.0f / M_PI);
+    }
+
+    void Camera::setClipPlanes(float t_near, float t_far) {
+        m_near = t_near;
+        m_far = t_far;
+        m_projections[0].valid = m_projections[1].valid = false;
+    }
+
+    float Camera::getNearPlane() {
+        return m_near;
+    }
+
+    float Camera::getFarPlane() {
+        return m_far;
     }
 
     C3D_Mtx& Camera::getViewMatrix() {
-        Mtx_Identity(&m_view);
-        Mtx_RotateX(&m_view, m_rotationX, true);
-        Mtx_RotateY(&m_view, m_rotationY, true);
-        Mtx_RotateZ(&m_view, m_rotationZ, true);
-        Mtx_Translate(&m_view, m_posX, -m_posY, m_posZ, true);
+        if (m_viewDirty) {
+            Mtx_FromQuat(&m_view, m_orientation);
+            Mtx_Translate(&m_view, m_posX, -m_posY, m_posZ, true);
+
+            m_viewDirty = false;
+        }
 
         return m_view;
     }
+
+    C3D_Mtx& Camera::getProjectionMatrix(float t_aspectRatio, float t_eyeOffset) {
+        return getProjection(t_aspectRatio, t_eyeOffset).projection;
+    }
+
+    C3D_Mtx& Camera::getViewProjectionMatrix(float t_aspectRatio, float t_eyeOffset) {
+        m3d::Camera::Projection& projection = getProjection(t_aspectRatio, t_eyeOffset);
+
+        if (m_viewDirty || !projection.viewProjectionValid) {
+            Mtx_Multiply(&projection.viewProjection, &projection.projection, &getViewMatrix());
+            projection.viewProjectionValid = true;
+        }
+
+        return projection.viewProjection;
+    }
+
+    // private methods
+    m3d::Camera::Projection& Camera::getProjection(float t_aspectRatio, float t_eyeOffset) {
+        for (unsigned int i = 0; i < 2; i++) {
+            m3d::Camera::Projection& projection = m_projections[i];
+
+            if (projection.valid && projection.aspectRatio == t_aspectRatio && projection.eyeOffset == t_eyeOffset) {
+                // the other one is the least recently used one now
+                m_nextProjection = i ^ 1;
+                return projection;
+            }
+        }
+
+        // replace the least recently used one
+        m3d::Camera::Projection& projection = m_projections[m_nextProjection];
+        m_nextProjection ^= 1;
+
+        Mtx_PerspStereoTilt(&projection.projection, m_fieldOfView, t_aspectRatio, m_near, m_far, t_eyeOffset, 2.0f, false);
+        projection.aspectRatio = t_aspectRatio;
+        projection.eyeOffset = t_eyeOffset;
+        projection.valid = true;
+        projection.viewProjectionValid = false;
+
+        return projection;
+    }
+
+    void Camera::updateOrientation() {
+        // the same order of rotations as a view matrix rotated around X, Y and Z
+        m_orientation = multiply(multiply(fromAxisAngle(1.0f, 0.0f, 0.0f, m_rotationX), fromAxisAngle(0.0f, 1.0f, 0.0f, m_rotationY)), fromAxisAngle(0.0f, 0.0f, 1.0f, m_rotationZ));
+        invalidateView();
+    }
+
+    void Camera::updateAngles() {
+        C3D_Mtx rotation;
+        Mtx_FromQuat(&rotation, m_orientation);
+
+        // decompose R = Rx * Ry * Rz
+        m_rotationY = asinf(fmaxf(-1.0f, fminf(1.0f, rotation.r[0].z)));
+
+        if (fabsf(rotation.r[0].z) < 0.9999f) {
+            m_rotationX = atan2f(-rotation.r[1].z, rotation.r[2].z);
+            m_rotationZ = atan2f(-rotation.r[0].y, rotation.r[0].x);
+        } else {
+            // gimbal lock, the roll can be expressed as pitch
+            m_rotationX = atan2f(rotation.r[2].y, rotation.r[1].y);
+            m_rotationZ = 0.0f;
+        }
+    }
+
+    void Camera::invalidateView() {
+        m_viewDirty = true;
+        m_projections[0].viewProjectionValid = m_projections[1].viewProjectionValid = false;
+    }
 } /* m3d */
@@ -36,83 +36,68 @@ namespace m3d {
     void Cuboid::update() {
         clearVertices();
 
+        float x = m_width / 2,
+              y = m_height / 2,
+              z = m_length / 2;
+
+        // every face consists of four vertices shared by two triangles
+        auto addFace = [this](m3d::Mesh::Polygon::Vertex t_vertex0, m3d::Mesh::Polygon::Vertex t_vertex1, m3d::Mesh::Polygon::Vertex t_vertex2, m3d::Mesh::Polygon::Vertex t_vertex3) {
+            unsigned int index0 = addVertex(t_vertex0),
+                         index1 = addVertex(t_vertex1),
+                         index2 = addVertex(t_vertex2),
+                         index3 = addVertex(t_vertex3);
+
+            addTriangle(index0, index1, index2);
+            addTriangle(index2, index3, index0);
+        };
+
         // first face (PZ)
-        addPolygon(m3d::Mesh::Polygon(
-            { {-(m_width / 2), -(m_height / 2), (m_length / 2)}, {0.0f, 0.0f}, {0.0f, 0.0f, +1.0f} },
-            { {(m_width / 2), -(m_height / 2), (m_length / 2)}, {1.0f, 0.0f}, {0.0f, 0.0f, +1.0f} },
-            { {(m_width / 2), (m_height / 2), (m_length / 2)}, {1.0f, 1.0f}, {0.0f, 0.0f, +1.0f} }
-        ));
-
-        addPolygon(m3d::Mesh::Polygon(
-            { {(m_width / 2), (m_height / 2), (m_length / 2)}, {1.0f, 1.0f}, {0.0f, 0.0f, +1.0f} },
-            { {-(m_width / 2), (m_height / 2), (m_length / 2)}, {0.0f, 1.0f}, {0.0f, 0.0f, +1.0f} },
-            { {-(m_width / 2), -(m_height / 2), (m_length / 2)}, {0.0f, 0.0f}, {0.0f, 0.0f, +1.0f} }
-        ));
+        addFace(
+            { {-x, -y, z}, {0.0f, 0.0f}, {0.0f, 0.0f, +1.0f} },
+            { {x, -y, z}, {1.0f, 0.0f}, {0.0f, 0.0f, +1.0f} },
+            { {x, y, z}, {1.0f, 1.0f}, {0.0f, 0.0f, +1.0f} },
+            { {-x, y, z}, {0.0f, 1.0f}, {0.0f, 0.0f, +1.0f} }
+        );
 
         // second face (MZ)
-        addPolygon(m3d::Mesh::Polygon(
-            { {-(m_width / 2), -(m_height / 2), -(m_length / 2)}, {0.0f, 0.0f}, {0.0f, 0.0f, -1.0f} },
-            { {-(m_width / 2), (m_height / 2), -(m_length / 2)}, {1.0f, 0.0f}, {0.0f, 0.0f, -1.0f} },
-            { {(m_width / 2), (m_height / 2), -(m_length / 2)}, {1.0f, 1.0f}, {0.0f, 0.0f, -1.0f} }
-        ));
-
-        addPolygon(m3d::Mesh::Polygon(
-            { {(m_width / 2), (m_height / 2), -(m_length / 2)}, {1.0f, 1.0f}, {0.0f, 0.0f, -1.0f} },
-            { {(m_width / 2), -(m_height / 2), -(m_length / 2)}, {0.0f, 1.0f}, {0.0f, 0.0f, -1.0f} },
-            { {-(m_width / 2), -(m_height / 2), -(m_length / 2)}, {0.0f, 0.0f}, {0.0f, 0.0f, -1.0f} }
-        ));
+        addFace(
+            { {-x, -y, -z}, {0.0f, 0.0f}, {0.0f, 0.0f, -1.0f} },
+            { {-x, y, -z}, {1.0f, 0.0f}, {0.0f, 0.0f, -1.0f} },
+            { {x, y, -z}, {1.0f, 1.0f}, {0.0f, 0.0f, -1.0f} },
+            { {x, -y, -z}, {0.0f, 1.0f}, {0.0f, 0.0f, -1.0f} }
+        );
 
         // third face (PX)
-        addPolygon(m3d::Mesh::Polygon(
-            { {(m_width / 2), -(m_height / 2), -(m_length / 2)}, {0.0f, 0.0f}, {+1.0f, 0.0f, 0.0f} },
-            { {(m_width / 2), (m_height / 2), -(m_length / 2)}, {1.0f, 0.0f}, {+1.0f, 0.0f, 0.0f} },
-            { {(m_width / 2), (m_height / 2), (m_length / 2)}, {1.0f, 1.0f}, {+1.0f, 0.0f, 0.0f} }
-        ));
-
-        addPolygon(m3d::Mesh::Polygon(
-            { {(m_width / 2), (m_height / 2), (m_length / 2)}, {1.0f, 1.0f}, {+1.0f, 0.0f, 0.0f} },
-            { {(m_width / 2), -(m_height / 2), (m_length / 2)}, {0.0f, 1.0f}, {+1.0f, 0.0f, 0.0f} },
-            { {(m_width / 2), -(m_height / 2), -(m_length / 2)}, {0.0f, 0.0f}, {+1.0f, 0.0f, 0.0f} }
-        ));
+        addFace(
+            { {x, -y, -z}, {0.0f, 0.0f}, {+1.0f, 0.0f, 0.0f} },
+            { {x, y, -z}, {1.0f, 0.0f}, {+1.0f, 0.0f, 0.0f} },
+            { {x, y, z}, {1.0f, 1.0f}, {+1.0f, 0.0f, 0.0f} },
+            { {x, -y, z}, {0.0f, 1.0f}, {+1.0f, 0.0f, 0.0f} }
+        );
 
         // fourth face (MX)
-        addPolygon(m3d::Mesh::Polygon(
-            { {-(m_width / 2), -(m_height / 2), -(m_length / 2)}, {0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f} },
-            { {-(m_width / 2), -(m_height / 2), (m_length / 2)}, {1.0f, 0.0f}, {-1.0f, 0.0f, 0.0f} },
-            { {-(m_width / 2), (m_height / 2), (m_length / 2)}, {1.0f, 1.0f}, {-1.0f, 0.0f, 0.0f} }
-        ));
-
-        addPolygon(m3d::Mesh::Polygon(
-            { {-(m_width / 2), (m_height / 2), (m_length / 2)}, {1.0f, 1.0f}, {-1.0f, 0.0f, 0.0f} },
-            { {-(m_width / 2), (m_height / 2), -(m_length / 2)}, {0.0f, 1.0f}, {-1.0f, 0.0f, 0.0f} },
-            { {-(m_width / 2), -(m_height / 2), -(m_length / 2)}, {0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f} }
-        ));
+        addFace(
+            { {-x, -y, -z}, {0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f} },
+            { {-x, -y, z}, {1.0f, 0.0f}, {-1.0f, 0.0f, 0.0f} },
+            { {-x, y, z}, {1.0f, 1.0f}, {-1.0f, 0.0f, 0.0f} },
+            { {-x, y, -z}, {0.0f, 1.0f}, {-1.0f, 0.0f, 0.0f} }
+        );
 
         // fifth face (PY)
-        addPolygon(m3d::Mesh::Polygon(
-            { {-(m_width / 2), (m_height / 2), -(m_length / 2)}, {0.0f, 0.0f}, {0.0f, +1.0f, 0.0f} },
-            { {-(m_width / 2), (m_height / 2), (m_length / 2)}, {1.0f, 0.0f}, {0.0f, +1.0f, 0.0f} },
-            { {(m_width / 2), (m_height / 2), (m_length / 2)}, {1.0f, 1.0f}, {0.0f, +1.0f, 0.0f} }
-        ));
-
-        addPolygon(m3d::Mesh::Polygon(
-            { {(m_width / 2), (m_height / 2), (m_length / 2)}, {1.0f, 1.0f}, {0.0f, +1.0f, 0.0f} },
-            { {(m_width / 2), (m_height / 2), -(m_length / 2)}, {0.0f, 1.0f}, {0.0f, +1.0f, 0.0f} },
-            { {-(m_width / 2), (m_height / 2), -(m_length / 2)}, {0.0f, 0.0f}, {0.0f, +1.0f, 0.0f} }
-        ));
+        addFace(
+            { {-x, y, -z}, {0.0f, 0.0f}, {0.0f, +1.0f, 0.0f} },
+            { {-x, y, z}, {1.0f, 0.0f}, {0.0f, +1.0f, 0.0f} },
+            { {x, y, z}, {1.0f, 1.0f}, {0.0f, +1.0f, 0.0f} },
+            { {x, y, -z}, {0.0f, 1.0f}, {0.0f, +1.0f, 0.0f} }
+        );
 
         // sixth face (MY)
-        addPolygon(m3d::Mesh::Polygon(
-            { {-(m_width / 2), -(m_height / 2), -(m_length / 2)}, {0.0f, 0.0f}, {0.0f, -1.0f, 0.0f} },
-            { {(m_width / 2), -(m_height / 2), -(m_length / 2)}, {1.0f, 0.0f}, {0.0f, -1.0f, 0.0f} },
-            { {(m_width / 2), -(m_height / 2), (m_length / 2)}, {1.0f, 1.0f}, {0.0f, -1.0f, 0.0f} }
-        ));
-
-        addPolygon(m3d::Mesh::Polygon(
-            { {(m_width / 2), -(m_height / 2), (m_length / 2)}, {1.0f, 1.0f}, {0.0f, -1.0f, 0.0f} },
-            { {-(m_width / 2), -(m_height / 2), (m_length / 2)}, {0.0f, 1.0f}, {0.0f, -1.0f, 0.0f} },
-            { {-(m_width / 2), -(m_height / 2), -(m_length / 2)}, {0.0f, 0.0f}, {0.0f, -1.0f, 0.0f} }
-        ));
+        addFace(
+            { {-x, -y, -z}, {0.0f, 0.0f}, {0.0f, -1.0f, 0.0f} },
+            { {x, -y, -z}, {1.0f, 0.0f}, {0.0f, -1.0f, 0.0f} },
+            { {x, -y, z}, {1.0f, 1.0f}, {0.0f, -1.0f, 0.0f} },
+            { {-x, -y, z}, {0.0f, 1.0f}, {0.0f, -1.0f, 0.0f} }
+        );
 
         updateVBO();
     }
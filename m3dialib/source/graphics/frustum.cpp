@@ -0,0 +1,53 @@
+#include <cmath>
+#include "m3d/graphics/frustum.hpp"
+
+namespace m3d {
+    Frustum::Frustum() {
+        for (int i = 0; i < 6; i++) {
+            m_planes[i] = FVec4_New(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+    }
+
+    void Frustum::update(const C3D_Mtx& t_viewProjection) {
+        const C3D_FVec* row = t_viewProjection.r;
+
+        // PICA200 clip space: -w <= x <= w, -w <= y <= w, -w <= z <= 0
+        m_planes[0] = FVec4_New(row[3].x + row[0].x, row[3].y + row[0].y, row[3].z + row[0].z, row[3].w + row[0].w);
+        m_planes[1] = FVec4_New(row[3].x - row[0].x, row[3].y - row[0].y, row[3].z - row[0].z, row[3].w - row[0].w);
+        m_planes[2] = FVec4_New(row[3].x + row[1].x, row[3].y + row[1].y, row[3].z + row[1].z, row[3].w + row[1].w);
+        m_planes[3] = FVec4_New(row[3].x - row[1].x, row[3].y - row[1].y, row[3].z - row[1].z, row[3].w - row[1].w);
+        m_planes[4] = FVec4_New(row[3].x + row[2].x, row[3].y + row[2].y, row[3].z + row[2].z, row[3].w + row[2].w);
+        m_planes[5] = FVec4_New(-row[2].x, -row[2].y, -row[2].z, -row[2].w);
+
+        // normalize the planes so the distances are in world units
+        for (int i = 0; i < 6; i++) {
+            float length = sqrtf(m_planes[i].x * m_planes[i].x + m_planes[i].y * m_planes[i].y + m_planes[i].z * m_planes[i].z);
+
+            if (length > 0.0f) {
+                m_planes[i] = FVec4_New(m_planes[i].x / length, m_planes[i].y / length, m_planes[i].z / length, m_planes[i].w / length);
+            }
+        }
+    }
+
+    bool Frustum::intersects(m3d::Vector3f t_center, float t_radius) {
+        for (int i = 0; i < 6; i++) {
+            if (m_planes[i].x * t_center.x + m_planes[i].y * t_center.y + m_planes[i].z * t_center.z + m_planes[i].w < -t_radius) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool Frustum::intersects(m3d::Vector3f t_center, m3d::Vector3f t_extents) {
+        for (int i = 0; i < 6; i++) {
+            float radius = fabsf(m_planes[i].x) * t_extents.x + fabsf(m_planes[i].y) * t_extents.y + fabsf(m_planes[i].z) * t_extents.z;
+
+            if (m_planes[i].x * t_center.x + m_planes[i].y * t_center.y + m_planes[i].z * t_center.z + m_planes[i].w < -radius) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+} /* m3d */
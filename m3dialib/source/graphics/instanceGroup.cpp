@@ -0,0 +1,193 @@
+#include <cmath>
+#include <cstring>
+#include "m3d/graphics/drawables/instanceGroup.hpp"
+
+namespace m3d {
+    InstanceGroup::InstanceGroup(m3d::Mesh& t_mesh) :
+        m_mesh(&t_mesh),
+        m_tinted(false) { /* do nothing */ }
+
+    void InstanceGroup::setMesh(m3d::Mesh& t_mesh) {
+        m_mesh = &t_mesh;
+    }
+
+    m3d::Mesh& InstanceGroup::getMesh() {
+        return *m_mesh;
+    }
+
+    unsigned int InstanceGroup::addInstance(m3d::Vector3f t_position, m3d::Vector3f t_rotation, m3d::Vector3f t_scale, bool t_radians) {
+        m_matrices.resize(m_matrices.size() + 3);
+        m_tints.push_back(FVec4_New(1.0f, 1.0f, 1.0f, 1.0f));
+
+        setInstance(m_tints.size() - 1, t_position, t_rotation, t_scale, t_radians);
+        return m_tints.size() - 1;
+    }
+
+    unsigned int InstanceGroup::addInstance(const C3D_Mtx& t_transform) {
+        m_matrices.resize(m_matrices.size() + 3);
+        m_tints.push_back(FVec4_New(1.0f, 1.0f, 1.0f, 1.0f));
+
+        setMatrix(m_tints.size() - 1, t_transform);
+        return m_tints.size() - 1;
+    }
+
+    void InstanceGroup::setInstance(unsigned int t_id, m3d::Vector3f t_position, m3d::Vector3f t_rotation, m3d::Vector3f t_scale, bool t_radians) {
+        if (t_id >= m_tints.size()) return;
+
+        C3D_Mtx transform;
+
+        // the same transformation as the one of m3d::Mesh
+        Mtx_Identity(&transform);
+        Mtx_Translate(&transform, t_position.x, t_position.y, -1.87 - t_position.z, true);
+        Mtx_RotateX(&transform, (t_radians ? t_rotation.x : C3D_AngleFromDegrees(t_rotation.x)), true);
+        Mtx_RotateY(&transform, (t_radians ? t_rotation.y : C3D_AngleFromDegrees(t_rotation.y)), true);
+        Mtx_RotateZ(&transform, (t_radians ? t_rotation.z : C3D_AngleFromDegrees(t_rotation.z)), true);
+        Mtx_Scale(&transform, t_scale.x, t_scale.y, t_scale.z);
+
+        setMatrix(t_id, transform);
+    }
+
+    void InstanceGroup::setInstance(unsigned int t_id, const C3D_Mtx& t_transform) {
+        if (t_id >= m_tints.size()) return;
+        setMatrix(t_id, t_transform);
+    }
+
+    void InstanceGroup::setInstanceTint(unsigned int t_id, m3d::Color t_color) {
+        if (t_id >= m_tints.size()) return;
+
+        m_tints[t_id] = FVec4_New(t_color.getRed() / 255.0f, t_color.getGreen() / 255.0f, t_color.getBlue() / 255.0f, t_color.getAlpha() / 255.0f);
+        m_tinted = true;
+    }
+
+    void InstanceGroup::removeInstance(unsigned int t_id) {
+        if (t_id >= m_tints.size()) return;
+
+        m_matrices.erase(m_matrices.begin() + t_id * 3, m_matrices.begin() + t_id * 3 + 3);
+        m_tints.erase(m_tints.begin() + t_id);
+    }
+
+    void InstanceGroup::clearInstances() {
+        m_matrices.clear();
+        m_tints.clear();
+        m_tinted = false;
+    }
+
+    unsigned int InstanceGroup::getInstanceCount() {
+        return m_tints.size();
+    }
+
+    void InstanceGroup::draw(m3d::RenderContext t_context) {
+        if (t_context.getMode() != m3d::RenderContext::Mode::Spatial || t_context.getInstanceUniform() < 0) return;
+        if (!m_mesh->m_geometry->vbo || m_tints.size() == 0) return;
+
+        m_mesh->updateDirtyVertices();
+        m3d::Mesh::Geometry& geometry = *m_mesh->m_geometry;
+
+        // the state of the mesh only gets set once for all instances
+        t_context.bindMaterial(m_mesh->m_material.getMaterial());
+        t_context.bindTexture(m_mesh->m_useTexture ? m_mesh->m_texture.getTexture() : nullptr);
+
+        // the vertex format of the mesh, plus the offsets into the instance uniforms
+        C3D_AttrInfo attributeInfo = geometry.attributeInfo;
+        AttrInfo_AddFixed(&attributeInfo, 3); // v3=instance offsets
+        t_context.bindAttributeInfo(&attributeInfo);
+
+        if (t_context.getQuantizationUniform() >= 0) {
+            memcpy(C3D_FVUnifWritePtr(GPU_VERTEX_SHADER, t_context.getQuantizationUniform(), 3), geometry.quantization, sizeof(geometry.quantization));
+        }
+
+        C3D_BufInfo* bufInfo = C3D_GetBufInfo();
+        BufInfo_Init(bufInfo);
+        BufInfo_Add(bufInfo, geometry.vbo, m3d::Mesh::getStride(geometry.format), 3, 0x210);
+
+        C3D_BoolUnifSet(GPU_VERTEX_SHADER, t_context.getInstancedUniform(), true);
+
+        if (m_tinted) {
+            // multiply the lit color with the tint (the vertex color)
+            C3D_TexEnv* env = C3D_GetTexEnv(2);
+            C3D_TexEnvInit(env);
+            C3D_TexEnvSrc(env, C3D_Both, GPU_PREVIOUS, GPU_PRIMARY_COLOR, GPU_PRIMARY_COLOR);
+            C3D_TexEnvFunc(env, C3D_Both, GPU_MODULATE);
+        } else {
+            // all instances use the first tint
+            C3D_FVUnifSet(GPU_VERTEX_SHADER, t_context.getTintUniform(), 1.0f, 1.0f, 1.0f, 1.0f);
+        }
+
+        unsigned int count = m_tints.size();
+
+        for (unsigned int first = 0; first < count; first += m3d::RenderContext::MaxInstances) {
+            unsigned int batch = count - first;
+            if (batch > m3d::RenderContext::MaxInstances) batch = m3d::RenderContext::MaxInstances;
+
+            // upload the matrices (and tints) of the whole batch at once
+            memcpy(C3D_FVUnifWritePtr(GPU_VERTEX_SHADER, t_context.getInstanceUniform(), batch * 3), &m_matrices[first * 3], batch * 3 * sizeof(C3D_FVec));
+
+            if (m_tinted) {
+                memcpy(C3D_FVUnifWritePtr(GPU_VERTEX_SHADER, t_context.getTintUniform(), batch), &m_tints[first], batch * sizeof(C3D_FVec));
+            }
+
+            for (unsigned int i = 0; i < batch; i++) {
+                *C3D_FixedAttribGetWritePtr(3) = FVec4_New(i * 3, (m_tinted ? i : 0), 0.0f, 0.0f);
+
+                if (geometry.ibo) {
+                    C3D_DrawElements(GPU_TRIANGLES, geometry.iboSize, C3D_UNSIGNED_SHORT, geometry.ibo);
+                } else {
+                    C3D_DrawArrays(GPU_TRIANGLES, 0, geometry.vboSize);
+                }
+            }
+        }
+
+        C3D_BoolUnifSet(GPU_VERTEX_SHADER, t_context.getInstancedUniform(), false);
+        if (m_tinted) C3D_TexEnvInit(C3D_GetTexEnv(2));
+    }
+
+    bool InstanceGroup::isVisible(m3d::Frustum& t_frustum) {
+        float radius = m_mesh->getBoundingRadius();
+        if (radius <= 0.0f) return true;
+
+        m3d::Vector3f min = m_mesh->getBoundingBoxMin(),
+                      max = m_mesh->getBoundingBoxMax(),
+                      center = { (min.x + max.x) / 2, (min.y + max.y) / 2, (min.z + max.z) / 2 };
+
+        for (unsigned int i = 0; i < m_tints.size(); i++) {
+            const C3D_FVec* rows = &m_matrices[i * 3];
+            m3d::Vector3f worldCenter;
+            float scale = 0.0f;
+
+            worldCenter.x = rows[0].x * center.x + rows[0].y * center.y + rows[0].z * center.z + rows[0].w;
+            worldCenter.y = rows[1].x * center.x + rows[1].y * center.y + rows[1].z * center.z + rows[1].w;
+            worldCenter.z = rows[2].x * center.x + rows[2].y * center.y + rows[2].z * center.z + rows[2].w;
+
+            // the sphere gets scaled by the largest axis scale of the instance
+            for (int j = 0; j < 3; j++) {
+                scale = fmaxf(scale, rows[0].c[3 - j] * rows[0].c[3 - j] +
+                                     rows[1].c[3 - j] * rows[1].c[3 - j] +
+                                     rows[2].c[3 - j] * rows[2].c[3 - j]);
+            }
+
+            if (t_frustum.intersects(worldCenter, radius * sqrtf(scale))) return true;
+        }
+
+        return false;
+    }
+
+    u64 InstanceGroup::getStateKey() {
+        u64 key = m_mesh->getStateKey();
+
+        // translucent tints get blended, so the group has to stay in order
+        if (m_tinted) {
+            for (const auto& tint : m_tints) {
+                if (tint.w < 1.0f) return key & ~m3d::Drawable::OpaqueStateBit;
+            }
+        }
+
+        return key;
+    }
+
+    // private methods
+    void InstanceGroup::setMatrix(unsigned int t_id, const C3D_Mtx& t_transform) {
+        m_matrices[t_id * 3]     = t_transform.r[0];
+        m_matrices[t_id * 3 + 1] = t_transform.r[1];
+        m_matrices[t_id * 3 + 2] = t_transform.r[2];
+    }
+} /* m3d */
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cmath>
+#include "m3d/graphics/drawables/lodGroup.hpp"
+
+namespace m3d {
+    LodGroup::LodGroup() :
+        m_level(-1),
+        m_hysteresis(0.0f),
+        m_drawDistance(0.0f) { /* do nothing */ }
+
+    void LodGroup::addLevel(m3d::Mesh& t_mesh, float t_distance) {
+        auto it = std::upper_bound(m_levels.begin(), m_levels.end(), t_distance, [](float t_lhs, const m3d::LodGroup::Level& t_rhs) {
+            return t_lhs < t_rhs.distance;
+        });
+
+        m_levels.insert(it, { &t_mesh, t_distance });
+
+        // until the first level gets selected, the most detailed one gets drawn
+        if (m_level < 0) m_level = 0;
+    }
+
+    void LodGroup::clearLevels() {
+        m_levels.clear();
+        m_level = -1;
+    }
+
+    unsigned int LodGroup::getLevelCount() {
+        return m_levels.size();
+    }
+
+    m3d::Mesh* LodGroup::getLevel(unsigned int t_level) {
+        return (t_level < m_levels.size() ? m_levels[t_level].mesh : nullptr);
+    }
+
+    int LodGroup::getCurrentLevel() {
+        return m_level;
+    }
+
+    void LodGroup::setHysteresis(float t_hysteresis) {
+        m_hysteresis = fmaxf(0.0f, t_hysteresis);
+    }
+
+    float LodGroup::getHysteresis() {
+        return m_hysteresis;
+    }
+
+    void LodGroup::setDrawDistance(float t_distance) {
+        m_drawDistance = fmaxf(0.0f, t_distance);
+    }
+
+    float LodGroup::getDrawDistance() {
+        return m_drawDistance;
+    }
+
+    void LodGroup::draw(m3d::RenderContext t_context) {
+        if (m_level >= 0) m_levels[m_level].mesh->draw(t_context);
+    }
+
+    bool LodGroup::isVisible(m3d::Frustum& t_frustum) {
+        return m_level >= 0 && m_levels[m_level].mesh->isVisible(t_frustum);
+    }
+
+    u64 LodGroup::getStateKey() {
+        return (m_level >= 0 ? m_levels[m_level].mesh->getStateKey() : 0);
+    }
+
+    void LodGroup::selectLevelOfDetail(const m3d::Vector3f& t_eyePosition) {
+        if (m_levels.empty()) {
+            m_level = -1;
+            return;
+        }
+
+        // the distance gets measured to the center of the first level, so all levels switch at the same distance
+        m3d::Mesh& mesh = *m_levels[0].mesh;
+        mesh.updateModelMatrix();
+
+        const C3D_Mtx& model = mesh.m_modelMatrix;
+        m3d::Vector3f center = {
+            (mesh.m_geometry->boundingMin.x + mesh.m_geometry->boundingMax.x) / 2,
+            (mesh.m_geometry->boundingMin.y + mesh.m_geometry->boundingMax.y) / 2,
+            (mesh.m_geometry->boundingMin.z + mesh.m_geometry->boundingMax.z) / 2
+        };
+
+        float deltaX = model.r[0].x * center.x + model.r[0].y * center.y + model.r[0].z * center.z + model.r[0].w - t_eyePosition.x,
+              deltaY = model.r[1].x * center.x + model.r[1].y * center.y + model.r[1].z * center.z + model.r[1].w - t_eyePosition.y,
+              deltaZ = model.r[2].x * center.x + model.r[2].y * center.y + model.r[2].z * center.z + model.r[2].w - t_eyePosition.z,
+              distance = sqrtf(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ),
+              farther = 1.0f + m_hysteresis,
+              closer = 1.0f - m_hysteresis;
+
+        // switches away from the current state need to exceed the hysteresis
+        if (m_drawDistance > 0.0f && distance >= m_drawDistance * (m_level < 0 ? closer : farther)) {
+            m_level = -1;
+            return;
+        }
+
+        int level = std::max(m_level, 0), count = m_levels.size();
+
+        while (level + 1 < count && distance >= m_levels[level + 1].distance * farther) level++;
+        while (level > 0 && distance < m_levels[level].distance * closer) level--;
+
+        m_level = level;
+    }
+} /* m3d */
@@ -10,11 +10,12 @@ namespace m3d {
         }
 
     Material::Material(C3D_Material t_material) {
+        m_material = new C3D_Material;
         setMaterial(t_material);
-        updateMaterial();
     }
 
     Material::Material(const m3d::Material& t_source) {
+        m_material = new C3D_Material;
         operator=(t_source);
     }
 
@@ -105,6 +106,10 @@ namespace m3d {
         return m_emission;
     }
 
+    u32 Material::getHash() const {
+        return m_hash;
+    }
+
     Material& Material::operator=(const Material& rhs) {
         setMaterial(*rhs.getMaterial());
         return *this;
@@ -131,5 +136,15 @@ namespace m3d {
         m_material->emission[0] = (float) m_emission.getBlue() / 255;
         m_material->emission[1] = (float) m_emission.getGreen() / 255;
         m_material->emission[2] = (float) m_emission.getRed() / 255;
+
+        // FNV-1a over all colors
+        u32 colors[5] = { m_ambient.getRgb8(), m_diffuse.getRgb8(), m_specular0.getRgb8(), m_specular1.getRgb8(), m_emission.getRgb8() };
+        m_hash = 2166136261u;
+
+        for (int i = 0; i < 5; i++) {
+            for (int j = 0; j < 4; j++) {
+                m_hash = (m_hash ^ ((colors[i] >> (j * 8)) & 0xFF)) * 16777619u;
+            }
+        }
     }
 } /* m3d */
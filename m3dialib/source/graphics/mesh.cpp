@@ -1,8 +1,38 @@
+#include <algorithm>
 #include <citro3d.h>
+#include <cmath>
 #include <cstring>
+#include <unordered_map>
 #include "m3d/graphics/drawables/mesh.hpp"
+#include "m3d/private/simplifier.hpp"
+#include "m3d/private/vertexCache.hpp"
 
 namespace m3d {
+    Mesh::Geometry::Geometry() :
+        vbo(nullptr),
+        ibo(nullptr),
+        vboSize(0),
+        iboSize(0),
+        vboCapacity(0),
+        iboCapacity(0),
+        dirtyBegin(0),
+        dirtyEnd(0),
+        format(m3d::Mesh::VertexFormat::Float),
+        boundingRadius(0.0f),
+        cached(false) {
+            boundingMin = { 0.0f, 0.0f, 0.0f };
+            boundingMax = { 0.0f, 0.0f, 0.0f };
+            quantization[0] = FVec4_New(1.0f, 1.0f, 1.0f, 0.0f);
+            quantization[1] = FVec4_New(0.0f, 0.0f, 0.0f, 0.0f);
+            quantization[2] = FVec4_New(1.0f, 1.0f, 0.0f, 0.0f);
+            AttrInfo_Init(&attributeInfo);
+        }
+
+    Mesh::Geometry::~Geometry() {
+        linearFree(vbo);
+        linearFree(ibo);
+    }
+
     Mesh::Mesh() :
         m_rotationX(0.0f),
         m_rotationY(0.0f),
@@ -13,42 +43,176 @@ namespace m3d {
         m_scaleX(1.0f),
         m_scaleY(1.0f),
         m_scaleZ(1.0f),
-        m_useTexture(false) { /* do nothing */ }
+        m_useTexture(false),
+        m_transformDirty(true),
+        m_parent(nullptr),
+        m_parentVersion(0),
+        m_geometry(std::make_shared<m3d::Mesh::Geometry>()) {
+            updateAttributeInfo();
+        }
 
-    Mesh::~Mesh() {
-        linearFree(m_vbo);
+    std::shared_ptr<m3d::Mesh::Geometry> Mesh::getGeometry() {
+        return m_geometry;
+    }
+
+    void Mesh::setGeometry(std::shared_ptr<m3d::Mesh::Geometry> t_geometry) {
+        if (t_geometry) {
+            m_geometry = t_geometry;
+        } else {
+            m_geometry = std::make_shared<m3d::Mesh::Geometry>();
+            updateAttributeInfo();
+        }
+    }
+
+    bool Mesh::isGeometryShared() {
+        // the cache only holds a weak reference, so geometry loaded by only one mesh still has to stay untouched
+        return m_geometry.use_count() > 1 || m_geometry->cached;
     }
 
     void Mesh::addPolygon(m3d::Mesh::Polygon t_polygon) {
-        m3d::Mesh::Polygon::Vertex vertex0 = t_polygon.getVertex(0),
-                                   vertex1 = t_polygon.getVertex(1),
-                                   vertex2 = t_polygon.getVertex(2);
+        unsigned int index0 = addVertex(t_polygon.getVertex(0)),
+                     index1 = addVertex(t_polygon.getVertex(1)),
+                     index2 = addVertex(t_polygon.getVertex(2));
+
+        addTriangle(index0, index1, index2);
+    }
 
-        m_vertices.push_back({
-            { vertex0.position[0], vertex0.position[1], vertex0.position[2] },
-            { vertex0.texcoord[0], vertex0.texcoord[1] },
-            { vertex0.normal[0], vertex0.normal[1], vertex0.normal[2] },
-        });
+    unsigned int Mesh::addVertex(const m3d::Mesh::Polygon::Vertex& t_vertex) {
+        detachGeometry();
+        m_geometry->vertices.push_back(t_vertex);
+        return m_geometry->vertices.size() - 1;
+    }
+
+    void Mesh::addTriangle(unsigned int t_index0, unsigned int t_index1, unsigned int t_index2) {
+        detachGeometry();
+        m_geometry->indices.push_back(t_index0);
+        m_geometry->indices.push_back(t_index1);
+        m_geometry->indices.push_back(t_index2);
+    }
 
-        m_vertices.push_back({
-            { vertex1.position[0], vertex1.position[1], vertex1.position[2] },
-            { vertex1.texcoord[0], vertex1.texcoord[1] },
-            { vertex1.normal[0], vertex1.normal[1], vertex1.normal[2] },
-        });
+    void Mesh::setVertices(std::vector<m3d::Mesh::Polygon::Vertex>&& t_vertices, std::vector<unsigned int>&& t_indices) {
+        detachGeometry(false, false);
+        m_geometry->vertices = std::move(t_vertices);
+        m_geometry->indices = std::move(t_indices);
+    }
 
-        m_vertices.push_back({
-            { vertex2.position[0], vertex2.position[1], vertex2.position[2] },
-            { vertex2.texcoord[0], vertex2.texcoord[1] },
-            { vertex2.normal[0], vertex2.normal[1], vertex2.normal[2] },
-        });
+    void Mesh::setVertices(const m3d::Mesh::Polygon::Vertex* t_vertices, unsigned int t_vertexCount, const unsigned int* t_indices, unsigned int t_indexCount) {
+        detachGeometry(false, false);
+        m_geometry->vertices.assign(t_vertices, t_vertices + t_vertexCount);
+        m_geometry->indices.assign(t_indices, t_indices + t_indexCount);
+    }
+
+    m3d::Mesh::Polygon::Vertex Mesh::getVertex(unsigned int t_index) {
+        if (t_index >= m_geometry->vertices.size()) return { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+        return m_geometry->vertices[t_index];
+    }
+
+    void Mesh::setVertex(unsigned int t_index, const m3d::Mesh::Polygon::Vertex& t_vertex) {
+        updateVertices(t_index, &t_vertex, 1);
+    }
+
+    void Mesh::updateVertices(unsigned int t_first, const m3d::Mesh::Polygon::Vertex* t_vertices, unsigned int t_count) {
+        if (t_first >= m_geometry->vertices.size()) return;
+        if (t_count > m_geometry->vertices.size() - t_first) t_count = m_geometry->vertices.size() - t_first;
+
+        detachGeometry();
+        memcpy(&m_geometry->vertices[t_first], t_vertices, t_count * sizeof(m3d::Mesh::Polygon::Vertex));
+
+        // the bounds only get recalculated if a vertex left them
+        for (unsigned int i = 0; i < t_count; i++) {
+            const float* position = t_vertices[i].position;
+
+            if (position[0] < m_geometry->boundingMin.x || position[1] < m_geometry->boundingMin.y || position[2] < m_geometry->boundingMin.z ||
+                position[0] > m_geometry->boundingMax.x || position[1] > m_geometry->boundingMax.y || position[2] > m_geometry->boundingMax.z) {
+                updateBounds();
+                break;
+            }
+        }
+
+        // the vertex buffer gets updated the next time the mesh gets drawn
+        if (m_geometry->dirtyEnd > m_geometry->dirtyBegin) {
+            m_geometry->dirtyBegin = std::min(m_geometry->dirtyBegin, t_first);
+            m_geometry->dirtyEnd = std::max(m_geometry->dirtyEnd, t_first + t_count);
+        } else {
+            m_geometry->dirtyBegin = t_first;
+            m_geometry->dirtyEnd = t_first + t_count;
+        }
+    }
+
+    unsigned int Mesh::getVertexCount() {
+        return m_geometry->vertices.size();
+    }
+
+    unsigned int Mesh::getTriangleCount() {
+        return m_geometry->indices.size() / 3;
     }
 
     void Mesh::clearVertices() {
-        m_vertices.clear();
+        detachGeometry(true, false);
+        m_geometry->vertices.clear();
+        m_geometry->indices.clear();
+    }
+
+    float Mesh::simplify(float t_ratio, float t_maxError) {
+        if (t_ratio >= 1.0f || m_geometry->indices.size() < 3 || isBufferOnly()) return 0.0f;
+
+        // collapses would stop at identical vertices, as they look like seams
+        detachGeometry(false);
+        weldVertices();
+
+        std::vector<m3d::Mesh::Polygon::Vertex>& vertices = m_geometry->vertices;
+        std::vector<unsigned int>& indices = m_geometry->indices;
+        unsigned int target = static_cast<unsigned int>(indices.size() / 3 * std::max(0.0f, t_ratio)) * 3;
+
+        float error = m3d::priv::simplify::simplify(indices, vertices[0].position, vertices.size(), sizeof(m3d::Mesh::Polygon::Vertex), target, t_maxError);
+
+        // also removes the vertices that aren't used anymore
+        optimizeVertexCache();
+        return error;
+    }
+
+    void Mesh::optimizeVertexCache() {
+        // re-uploading without vertices would empty the buffers
+        if (isBufferOnly()) return;
+
+        detachGeometry(false);
+        weldVertices();
+
+        m3d::priv::vertexCache::optimizeTriangles(m_geometry->indices, m_geometry->vertices.size());
+        m3d::priv::vertexCache::optimizeVertexFetch(m_geometry->vertices, m_geometry->indices);
+
+        updateBounds();
+        uploadBuffers();
+    }
+
+    float Mesh::getCacheMissRatio() {
+        // unindexed buffers transform every vertex of every triangle
+        if (!m_geometry->ibo) return (m_geometry->vboSize > 0 ? 3.0f : 0.0f);
+        return m3d::priv::vertexCache::getAcmr(m_geometry->ibo, m_geometry->iboSize, m_geometry->vboSize);
+    }
+
+    void Mesh::setVertexFormat(m3d::Mesh::VertexFormat t_format) {
+        if (t_format == m_geometry->format || isBufferOnly()) return;
+
+        detachGeometry();
+        m_geometry->format = t_format;
+        updateAttributeInfo();
+
+        // re-upload the vertices if they were uploaded already
+        if (m_geometry->vbo) updateVBO();
+    }
+
+    m3d::Mesh::VertexFormat Mesh::getVertexFormat() {
+        return m_geometry->format;
+    }
+
+    unsigned int Mesh::getBufferSize() {
+        return m_geometry->vboCapacity + m_geometry->iboCapacity;
     }
 
     void Mesh::setPitch(float t_rotation, bool t_radians) {
         m_rotationX = (t_radians ? t_rotation : C3D_AngleFromDegrees(t_rotation));
+        m_transformDirty = true;
     }
 
     float Mesh::getPitch(bool t_radians) {
@@ -57,6 +221,7 @@ namespace m3d {
 
     void Mesh::setYaw(float t_rotation, bool t_radians) {
         m_rotationY = (t_radians ? t_rotation : C3D_AngleFromDegrees(t_rotation));
+        m_transformDirty = true;
     }
 
     float Mesh::getYaw(bool t_radians) {
@@ -65,6 +230,7 @@ namespace m3d {
 
     void Mesh::setRoll(float t_rotation, bool t_radians) {
         m_rotationZ = (t_radians ? t_rotation : C3D_AngleFromDegrees(t_rotation));
+        m_transformDirty = true;
     }
 
     float Mesh::getRoll(bool t_radians) {
@@ -81,22 +247,27 @@ namespace m3d {
             m_rotationY = C3D_AngleFromDegrees(t_yaw);
             m_rotationZ = C3D_AngleFromDegrees(t_roll);
         }
+        m_transformDirty = true;
     }
 
     void Mesh::rotatePitch(float t_delta, bool t_radians) {
         m_rotationX += (t_radians ? t_delta : C3D_AngleFromDegrees(t_delta));
+        m_transformDirty = true;
     }
 
     void Mesh::rotateYaw(float t_delta, bool t_radians) {
         m_rotationY += (t_radians ? t_delta : C3D_AngleFromDegrees(t_delta));
+        m_transformDirty = true;
     }
 
     void Mesh::rotateRoll(float t_delta, bool t_radians) {
         m_rotationZ += (t_radians ? t_delta : C3D_AngleFromDegrees(t_delta));
+        m_transformDirty = true;
     }
 
     void Mesh::setPositionX(float t_position) {
         m_posX = t_position;
+        m_transformDirty = true;
     }
 
     float Mesh::getPositionX() {
@@ -105,6 +276,7 @@ namespace m3d {
 
     void Mesh::setPositionY(float t_position) {
         m_posY = t_position;
+        m_transformDirty = true;
     }
 
     float Mesh::getPositionY() {
@@ -113,6 +285,7 @@ namespace m3d {
 
     void Mesh::setPositionZ(float t_position) {
         m_posZ = t_position;
+        m_transformDirty = true;
     }
 
     float Mesh::getPositionZ() {
@@ -123,28 +296,34 @@ namespace m3d {
         m_posX = t_positionX;
         m_posY = t_positionY;
         m_posZ = t_positionZ;
+        m_transformDirty = true;
     }
 
     void Mesh::setPosition(m3d::Vector3f t_position) {
         m_posX = t_position.x;
         m_posY = t_position.y;
         m_posZ = t_position.z;
+        m_transformDirty = true;
     }
 
     void Mesh::moveX(float t_delta) {
         m_posX += t_delta;
+        m_transformDirty = true;
     }
 
     void Mesh::moveY(float t_delta) {
         m_posY += t_delta;
+        m_transformDirty = true;
     }
 
     void Mesh::moveZ(float t_delta) {
         m_posZ += t_delta;
+        m_transformDirty = true;
     }
 
     void Mesh::setScaleX(float t_scale) {
         m_scaleX = t_scale;
+        m_transformDirty = true;
     }
 
     float Mesh::getScaleX() {
@@ -153,6 +332,7 @@ namespace m3d {
 
     void Mesh::setScaleY(float t_scale) {
         m_scaleY = t_scale;
+        m_transformDirty = true;
     }
 
     float Mesh::getScaleY() {
@@ -161,6 +341,7 @@ namespace m3d {
 
     void Mesh::setScaleZ(float t_scale) {
         m_scaleZ = t_scale;
+        m_transformDirty = true;
     }
 
     float Mesh::getScaleZ() {
@@ -171,18 +352,32 @@ namespace m3d {
         m_scaleX = t_scaleX;
         m_scaleY = t_scaleY;
         m_scaleZ = t_scaleZ;
+        m_transformDirty = true;
     }
 
     void Mesh::scaleX(float t_delta) {
         m_scaleX += t_delta;
+        m_transformDirty = true;
     }
 
     void Mesh::scaleY(float t_delta) {
         m_scaleY += t_delta;
+        m_transformDirty = true;
     }
 
     void Mesh::scaleZ(float t_delta) {
         m_scaleZ += t_delta;
+        m_transformDirty = true;
+    }
+
+    void Mesh::setParent(m3d::SceneNode* t_parent) {
+        m_parent = t_parent;
+        m_parentVersion = 0;
+        m_transformDirty = true;
+    }
+
+    m3d::SceneNode* Mesh::getParent() {
+        return m_parent;
     }
 
     void Mesh::setMaterial(m3d::Material& t_material) {
@@ -221,58 +416,460 @@ namespace m3d {
 
     void Mesh::draw(m3d::RenderContext t_context) {
         if (t_context.getMode() == m3d::RenderContext::Mode::Spatial) {
-            // manipulate modelview matrix
-            Mtx_Identity(&t_context.getModelMatrix());
-            Mtx_Translate(&t_context.getModelMatrix(), m_posX, m_posY,  -1.87 - m_posZ, true);
-            Mtx_RotateX(&t_context.getModelMatrix(), m_rotationX, true);
-            Mtx_RotateY(&t_context.getModelMatrix(), m_rotationY, true);
-            Mtx_RotateZ(&t_context.getModelMatrix(), m_rotationZ, true);
-            Mtx_Scale(&t_context.getModelMatrix(), m_scaleX, m_scaleY, m_scaleZ);
-
-            // set material
-            C3D_LightEnvMaterial(&t_context.getLightEnvironment(), m_material.getMaterial());
-
-            if (m_useTexture) {
-                // enable textures
-                t_context.enableTextures(true);
-
-                // bind the texture
-                C3D_TexSetFilter(m_texture.getTexture(), GPU_LINEAR, GPU_LINEAR);
-                C3D_TexBind(0, m_texture.getTexture());
-            } else {
-                // disable textures
-                t_context.enableTextures(false);
+            // the model matrix only gets recalculated if the mesh got transformed
+            updateModelMatrix();
+            Mtx_Copy(&t_context.getModelMatrix(), &m_modelMatrix);
+
+            // set material and texture (skipped if the previous mesh used the same ones)
+            t_context.bindMaterial(m_material.getMaterial());
+            t_context.bindTexture(m_useTexture ? m_texture.getTexture() : nullptr);
+
+            // upload the vertices that changed since the last frame
+            updateDirtyVertices();
+
+            // set the vertex format
+            t_context.bindAttributeInfo(&m_geometry->attributeInfo);
+
+            if (t_context.getQuantizationUniform() >= 0) {
+                memcpy(C3D_FVUnifWritePtr(GPU_VERTEX_SHADER, t_context.getQuantizationUniform(), 3), m_geometry->quantization, sizeof(m_geometry->quantization));
             }
 
             // create buffer
             C3D_BufInfo* bufInfo = C3D_GetBufInfo();
             BufInfo_Init(bufInfo);
-            BufInfo_Add(bufInfo, m_vbo, sizeof(m3d::Mesh::Polygon::Vertex), 3, 0x210);
+            BufInfo_Add(bufInfo, m_geometry->vbo, getStride(m_geometry->format), 3, 0x210);
 
             // update the uniforms
             C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, t_context.getModelUniform(),  &t_context.getModelMatrix());
 
             // draw the VBO
-            C3D_DrawArrays(GPU_TRIANGLES, 0, m_vertices.size());
+            if (m_geometry->ibo) {
+                C3D_DrawElements(GPU_TRIANGLES, m_geometry->iboSize, C3D_UNSIGNED_SHORT, m_geometry->ibo);
+            } else {
+                C3D_DrawArrays(GPU_TRIANGLES, 0, m_geometry->vboSize);
+            }
         }
     }
 
+    bool Mesh::isVisible(m3d::Frustum& t_frustum) {
+        if (m_geometry->boundingRadius <= 0.0f) return true;
+
+        updateModelMatrix();
+
+        m3d::Vector3f center = {
+                (m_geometry->boundingMin.x + m_geometry->boundingMax.x) / 2,
+                (m_geometry->boundingMin.y + m_geometry->boundingMax.y) / 2,
+                (m_geometry->boundingMin.z + m_geometry->boundingMax.z) / 2
+            },
+            extents = {
+                (m_geometry->boundingMax.x - m_geometry->boundingMin.x) / 2,
+                (m_geometry->boundingMax.y - m_geometry->boundingMin.y) / 2,
+                (m_geometry->boundingMax.z - m_geometry->boundingMin.z) / 2
+            },
+            worldCenter, worldExtents;
+
+        // transform the center and extents of the bounding box into world space
+        worldCenter.x = m_modelMatrix.r[0].x * center.x + m_modelMatrix.r[0].y * center.y + m_modelMatrix.r[0].z * center.z + m_modelMatrix.r[0].w;
+        worldCenter.y = m_modelMatrix.r[1].x * center.x + m_modelMatrix.r[1].y * center.y + m_modelMatrix.r[1].z * center.z + m_modelMatrix.r[1].w;
+        worldCenter.z = m_modelMatrix.r[2].x * center.x + m_modelMatrix.r[2].y * center.y + m_modelMatrix.r[2].z * center.z + m_modelMatrix.r[2].w;
+
+        worldExtents.x = fabsf(m_modelMatrix.r[0].x) * extents.x + fabsf(m_modelMatrix.r[0].y) * extents.y + fabsf(m_modelMatrix.r[0].z) * extents.z;
+        worldExtents.y = fabsf(m_modelMatrix.r[1].x) * extents.x + fabsf(m_modelMatrix.r[1].y) * extents.y + fabsf(m_modelMatrix.r[1].z) * extents.z;
+        worldExtents.z = fabsf(m_modelMatrix.r[2].x) * extents.x + fabsf(m_modelMatrix.r[2].y) * extents.y + fabsf(m_modelMatrix.r[2].z) * extents.z;
+
+        // the sphere gets scaled by the largest axis scale of the model matrix
+        float scale = 0.0f;
+
+        for (int i = 0; i < 3; i++) {
+            scale = fmaxf(scale, m_modelMatrix.r[0].c[3 - i] * m_modelMatrix.r[0].c[3 - i] +
+                                 m_modelMatrix.r[1].c[3 - i] * m_modelMatrix.r[1].c[3 - i] +
+                                 m_modelMatrix.r[2].c[3 - i] * m_modelMatrix.r[2].c[3 - i]);
+        }
+
+        scale = sqrtf(scale);
+
+        // the sphere test is cheaper, the box test is tighter
+
+        return t_frustum.intersects(worldCenter, m_geometry->boundingRadius * scale) && t_frustum.intersects(worldCenter, worldExtents);
+    }
+
+    m3d::Vector3f Mesh::getBoundingBoxMin() {
+        return m_geometry->boundingMin;
+    }
+
+    m3d::Vector3f Mesh::getBoundingBoxMax() {
+        return m_geometry->boundingMax;
+    }
+
+    float Mesh::getBoundingRadius() {
+        return m_geometry->boundingRadius;
+    }
+
+    u64 Mesh::getStateKey() {
+        u64 texture = 0;
+        bool opaque = true;
+
+        if (m_useTexture && m_texture.getTexture()) {
+            // textures copied from each other share their data
+            texture = (reinterpret_cast<uintptr_t>(m_texture.getTexture()->data) >> 4) & 0x1FFFFFFF;
+
+            // textures with alpha may be blended with whatever was drawn before
+            m3d::Texture::Format format = m_texture.getFormat();
+            opaque = format == m3d::Texture::Format::RGB565 || format == m3d::Texture::Format::ETC1;
+        }
+
+        u64 key = (1ull << 62) | (texture << 32) | m_material.getHash();
+        if (opaque) key |= m3d::Drawable::OpaqueStateBit;
+
+        return key;
+    }
+
     // protected methods
     void Mesh::updateVBO() {
-        linearFree(m_vbo);
-        m_vbo = static_cast<m3d::Mesh::Polygon::Vertex*>(linearAlloc(m_vertices.size() * sizeof(m3d::Mesh::Polygon::Vertex)));
+        detachGeometry(false);
+        weldVertices();
+        updateBounds();
+        uploadBuffers();
+    }
+
+    // private methods
+    unsigned int Mesh::getStride(m3d::Mesh::VertexFormat t_format) {
+        return (t_format == m3d::Mesh::VertexFormat::Compact ? sizeof(m3d::Mesh::CompactVertex) : sizeof(m3d::Mesh::Polygon::Vertex));
+    }
+
+    void* Mesh::reserveBuffer(void* t_buffer, unsigned int& t_capacity, unsigned int t_size) {
+        if (t_size <= t_capacity) return t_buffer;
+
+        // buffers only grow, and grow geometrically once they had to grow before
+        linearFree(t_buffer);
+        t_capacity = (t_capacity == 0 ? t_size : std::max(t_size, t_capacity + t_capacity / 2));
+        return linearAlloc(t_capacity);
+    }
+
+    void Mesh::detachGeometry(bool t_copyBuffers, bool t_copyVertices) {
+        if (!isGeometryShared()) return;
+
+        // copy-on-write, shared geometry never changes
+        std::shared_ptr<m3d::Mesh::Geometry> geometry = std::make_shared<m3d::Mesh::Geometry>();
+
+        if (t_copyVertices) {
+            geometry->vertices = m_geometry->vertices;
+            geometry->indices = m_geometry->indices;
+        }
 
-        for (unsigned int i = 0; i < m_vertices.size(); i++) {
-            float x = m_vertices[i].position[0],
-                  y = m_vertices[i].position[1],
-                  z = m_vertices[i].position[2],
-                  u = m_vertices[i].texcoord[0],
-                  v = m_vertices[i].texcoord[1],
-                 nx = m_vertices[i].normal[0],
-                 ny = m_vertices[i].normal[1],
-                 nz = m_vertices[i].normal[2];
+        geometry->vboSize = t_copyBuffers ? m_geometry->vboSize : 0;
+        geometry->iboSize = t_copyBuffers ? m_geometry->iboSize : 0;
+        geometry->dirtyBegin = t_copyBuffers ? m_geometry->dirtyBegin : 0;
+        geometry->dirtyEnd = t_copyBuffers ? m_geometry->dirtyEnd : 0;
+        geometry->format = m_geometry->format;
+        geometry->attributeInfo = m_geometry->attributeInfo;
+        geometry->boundingMin = m_geometry->boundingMin;
+        geometry->boundingMax = m_geometry->boundingMax;
+        geometry->boundingRadius = m_geometry->boundingRadius;
+        memcpy(geometry->quantization, m_geometry->quantization, sizeof(geometry->quantization));
+
+        // keep the buffers, so the mesh still gets drawn until its VBO gets updated
+        if (t_copyBuffers && m_geometry->vbo) {
+            geometry->vboCapacity = m_geometry->vboSize * getStride(m_geometry->format);
+            geometry->vbo = linearAlloc(geometry->vboCapacity);
+            memcpy(geometry->vbo, m_geometry->vbo, geometry->vboCapacity);
+        }
+
+        if (t_copyBuffers && m_geometry->ibo) {
+            geometry->iboCapacity = m_geometry->iboSize * sizeof(u16);
+            geometry->ibo = static_cast<u16*>(linearAlloc(geometry->iboCapacity));
+            memcpy(geometry->ibo, m_geometry->ibo, geometry->iboCapacity);
+        }
+
+        m_geometry = geometry;
+    }
+
+    bool Mesh::isBufferOnly() {
+        // binary models get read straight into the buffers, without keeping the vertices
+        return m_geometry->vbo && m_geometry->vboSize > 0 && m_geometry->vertices.empty();
+    }
+
+    size_t Mesh::VertexHash::operator()(const m3d::Mesh::Polygon::Vertex& t_vertex) const {
+        u32 words[sizeof(m3d::Mesh::Polygon::Vertex) / sizeof(u32)];
+        size_t hash = 2166136261u;
+
+        memcpy(words, &t_vertex, sizeof(words));
+
+        for (unsigned int i = 0; i < sizeof(words) / sizeof(u32); i++) {
+            hash = (hash ^ words[i]) * 16777619u;
+        }
+
+        return hash;
+    }
+
+    bool Mesh::VertexEqual::operator()(const m3d::Mesh::Polygon::Vertex& t_lhs, const m3d::Mesh::Polygon::Vertex& t_rhs) const {
+        return memcmp(&t_lhs, &t_rhs, sizeof(m3d::Mesh::Polygon::Vertex)) == 0;
+    }
+
+    void Mesh::weldVertices() {
+        std::vector<m3d::Mesh::Polygon::Vertex>& vertices = m_geometry->vertices;
+        std::unordered_map<m3d::Mesh::Polygon::Vertex, unsigned int, m3d::Mesh::VertexHash, m3d::Mesh::VertexEqual> lookup;
+        std::vector<unsigned int> remap(vertices.size());
+        unsigned int count = 0;
+
+        lookup.reserve(vertices.size());
+
+        // unique vertices get moved to the front in place
+        for (unsigned int i = 0; i < vertices.size(); i++) {
+            auto entry = lookup.emplace(vertices[i], count);
+
+            if (entry.second) {
+                if (count != i) vertices[count] = vertices[i];
+                count++;
+            }
+
+            remap[i] = entry.first->second;
+        }
+
+        // nothing to do if all vertices are unique already
+        if (count == vertices.size()) return;
+
+        for (auto& index : m_geometry->indices) {
+            index = remap[index];
+        }
+
+        vertices.resize(count);
+        vertices.shrink_to_fit();
+    }
+
+    void Mesh::uploadBuffers() {
+        m3d::Mesh::Geometry& geometry = *m_geometry;
+
+        // the GPU only supports 16-bit indices, bigger meshes get drawn without an index buffer
+        bool indexed = geometry.vertices.size() <= 0x10000;
+        geometry.vboSize = indexed ? geometry.vertices.size() : geometry.indices.size();
+        geometry.iboSize = indexed ? geometry.indices.size() : 0;
+
+        updateQuantization();
+
+        // the buffers get reused if they are big enough
+        geometry.vbo = reserveBuffer(geometry.vbo, geometry.vboCapacity, geometry.vboSize * getStride(geometry.format));
+
+        if (indexed) {
+            writeVertices(0, geometry.vboSize);
+
+            geometry.ibo = static_cast<u16*>(reserveBuffer(geometry.ibo, geometry.iboCapacity, geometry.iboSize * sizeof(u16)));
+
+            for (unsigned int i = 0; i < geometry.iboSize; i++) {
+                geometry.ibo[i] = geometry.indices[i];
+            }
+
+            if (geometry.ibo) GSPGPU_FlushDataCache(geometry.ibo, geometry.iboSize * sizeof(u16));
+        } else {
+            for (unsigned int i = 0; i < geometry.vboSize; i++) {
+                writeVertex(i, geometry.vertices[geometry.indices[i]]);
+            }
+
+            if (geometry.vbo) GSPGPU_FlushDataCache(geometry.vbo, geometry.vboSize * getStride(geometry.format));
+
+            linearFree(geometry.ibo);
+            geometry.ibo = nullptr;
+            geometry.iboCapacity = 0;
+        }
+
+        geometry.dirtyBegin = geometry.dirtyEnd = 0;
+    }
+
+    void Mesh::updateDirtyVertices() {
+        m3d::Mesh::Geometry& geometry = *m_geometry;
+
+        if (geometry.dirtyEnd <= geometry.dirtyBegin) return;
+
+        // buffers that don't map one-to-one onto the vertices (unindexed or outdated ones) get uploaded as a whole
+        if (!geometry.vbo || !geometry.ibo || geometry.vboSize != geometry.vertices.size() || geometry.dirtyEnd > geometry.vertices.size()) {
+            uploadBuffers();
+            return;
+        }
+
+        if (geometry.format == m3d::Mesh::VertexFormat::Compact) {
+            // vertices outside of the quantized range change the quantization of all vertices
+            for (unsigned int i = geometry.dirtyBegin; i < geometry.dirtyEnd; i++) {
+                const m3d::Mesh::Polygon::Vertex& vertex = geometry.vertices[i];
+
+                if (fabsf(vertex.position[0] - geometry.quantization[1].x) > geometry.quantization[0].x * 32767.0f ||
+                    fabsf(vertex.position[1] - geometry.quantization[1].y) > geometry.quantization[0].y * 32767.0f ||
+                    fabsf(vertex.position[2] - geometry.quantization[1].z) > geometry.quantization[0].z * 32767.0f ||
+                    fabsf(vertex.texcoord[0] - geometry.quantization[2].z) > geometry.quantization[2].x * 32767.0f ||
+                    fabsf(vertex.texcoord[1] - geometry.quantization[2].w) > geometry.quantization[2].y * 32767.0f) {
+                    geometry.dirtyBegin = 0;
+                    geometry.dirtyEnd = geometry.vertices.size();
+                    updateQuantization();
+                    break;
+                }
+            }
+        }
+
+        // only the changed range gets written, the buffer stays where it is
+        writeVertices(geometry.dirtyBegin, geometry.dirtyEnd - geometry.dirtyBegin);
+        geometry.dirtyBegin = geometry.dirtyEnd = 0;
+    }
+
+    void Mesh::updateQuantization() {
+        m3d::Mesh::Geometry& geometry = *m_geometry;
+
+        if (geometry.format != m3d::Mesh::VertexFormat::Compact) {
+            geometry.quantization[0] = FVec4_New(1.0f, 1.0f, 1.0f, 0.0f);
+            geometry.quantization[1] = FVec4_New(0.0f, 0.0f, 0.0f, 0.0f);
+            geometry.quantization[2] = FVec4_New(1.0f, 1.0f, 0.0f, 0.0f);
+            return;
+        }
+
+        // positions get quantized to the bounding box, texture coordinates to their own bounds
+        float minU = 0.0f, minV = 0.0f, maxU = 0.0f, maxV = 0.0f;
+
+        if (geometry.vertices.size() > 0) {
+            minU = maxU = geometry.vertices[0].texcoord[0];
+            minV = maxV = geometry.vertices[0].texcoord[1];
+        }
+
+        for (const auto& vertex : geometry.vertices) {
+            minU = fminf(minU, vertex.texcoord[0]);
+            minV = fminf(minV, vertex.texcoord[1]);
+            maxU = fmaxf(maxU, vertex.texcoord[0]);
+            maxV = fmaxf(maxV, vertex.texcoord[1]);
+        }
+
+        auto scale = [](float t_min, float t_max) {
+            return (t_max > t_min ? (t_max - t_min) / 65534.0f : 1.0f);
+        };
+
+        geometry.quantization[0] = FVec4_New(
+            scale(geometry.boundingMin.x, geometry.boundingMax.x),
+            scale(geometry.boundingMin.y, geometry.boundingMax.y),
+            scale(geometry.boundingMin.z, geometry.boundingMax.z),
+            0.0f
+        );
+        geometry.quantization[1] = FVec4_New((geometry.boundingMin.x + geometry.boundingMax.x) / 2, (geometry.boundingMin.y + geometry.boundingMax.y) / 2, (geometry.boundingMin.z + geometry.boundingMax.z) / 2, 0.0f);
+        geometry.quantization[2] = FVec4_New(scale(minU, maxU), scale(minV, maxV), (minU + maxU) / 2, (minV + maxV) / 2);
+    }
+
+    void Mesh::writeVertices(unsigned int t_first, unsigned int t_count) {
+        m3d::Mesh::Geometry& geometry = *m_geometry;
+        if (t_count == 0 || !geometry.vbo) return;
+
+        unsigned int stride = getStride(geometry.format);
+
+        if (geometry.format == m3d::Mesh::VertexFormat::Float) {
+            // the vertices already have the layout of the buffer
+            memcpy(static_cast<u8*>(geometry.vbo) + t_first * stride, &geometry.vertices[t_first], t_count * stride);
+        } else {
+            for (unsigned int i = t_first; i < t_first + t_count; i++) {
+                writeVertex(i, geometry.vertices[i]);
+            }
+        }
+
+        GSPGPU_FlushDataCache(static_cast<u8*>(geometry.vbo) + t_first * stride, t_count * stride);
+    }
+
+    void Mesh::writeVertex(unsigned int t_slot, const m3d::Mesh::Polygon::Vertex& t_vertex) {
+        m3d::Mesh::Geometry& geometry = *m_geometry;
+
+        if (geometry.format == m3d::Mesh::VertexFormat::Float) {
+            static_cast<m3d::Mesh::Polygon::Vertex*>(geometry.vbo)[t_slot] = t_vertex;
+            return;
+        }
+
+        auto quantize = [](float t_value, float t_offset, float t_scale) {
+            return static_cast<s16>(fmaxf(-32767.0f, fminf(32767.0f, roundf((t_value - t_offset) / t_scale))));
+        };
+
+        m3d::Mesh::CompactVertex& vertex = static_cast<m3d::Mesh::CompactVertex*>(geometry.vbo)[t_slot];
+
+        vertex.position[0] = quantize(t_vertex.position[0], geometry.quantization[1].x, geometry.quantization[0].x);
+        vertex.position[1] = quantize(t_vertex.position[1], geometry.quantization[1].y, geometry.quantization[0].y);
+        vertex.position[2] = quantize(t_vertex.position[2], geometry.quantization[1].z, geometry.quantization[0].z);
+        vertex.position[3] = 0;
+        vertex.texcoord[0] = quantize(t_vertex.texcoord[0], geometry.quantization[2].z, geometry.quantization[2].x);
+        vertex.texcoord[1] = quantize(t_vertex.texcoord[1], geometry.quantization[2].w, geometry.quantization[2].y);
 
-            m_vbo[i] = (m3d::Mesh::Polygon::Vertex) { { x, y, z }, { u, v }, { nx, ny, nz } };
+        // normals get normalized in the shader, so they don't need to be dequantized
+        for (int j = 0; j < 3; j++) {
+            vertex.normal[j] = static_cast<s8>(fmaxf(-127.0f, fminf(127.0f, roundf(t_vertex.normal[j] * 127.0f))));
         }
+
+        vertex.normal[3] = 0;
+    }
+
+    void Mesh::updateAttributeInfo() {
+        AttrInfo_Init(&m_geometry->attributeInfo);
+
+        if (m_geometry->format == m3d::Mesh::VertexFormat::Compact) {
+            AttrInfo_AddLoader(&m_geometry->attributeInfo, 0, GPU_SHORT, 4); // v0=position
+            AttrInfo_AddLoader(&m_geometry->attributeInfo, 1, GPU_SHORT, 2); // v1=texcoord
+            AttrInfo_AddLoader(&m_geometry->attributeInfo, 2, GPU_BYTE, 4);  // v2=normal
+        } else {
+            AttrInfo_AddLoader(&m_geometry->attributeInfo, 0, GPU_FLOAT, 3); // v0=position
+            AttrInfo_AddLoader(&m_geometry->attributeInfo, 1, GPU_FLOAT, 2); // v1=texcoord
+            AttrInfo_AddLoader(&m_geometry->attributeInfo, 2, GPU_FLOAT, 3); // v2=normal
+        }
+    }
+
+    void Mesh::updateModelMatrix() {
+        if (m_transformDirty) {
+            // the offset only applies to the root of a hierarchy
+            Mtx_Identity(&m_localMatrix);
+            Mtx_Translate(&m_localMatrix, m_posX, m_posY, (m_parent ? 0.0f : -1.87f) - m_posZ, true);
+            Mtx_RotateX(&m_localMatrix, m_rotationX, true);
+            Mtx_RotateY(&m_localMatrix, m_rotationY, true);
+            Mtx_RotateZ(&m_localMatrix, m_rotationZ, true);
+            Mtx_Scale(&m_localMatrix, m_scaleX, m_scaleY, m_scaleZ);
+        }
+
+        if (m_parent) {
+            // only recalculated if the mesh or one of the nodes above it changed
+            const C3D_Mtx& parent = m_parent->getWorldMatrix();
+
+            if (m_transformDirty || m_parentVersion != m_parent->m_version) {
+                Mtx_Multiply(&m_modelMatrix, &parent, &m_localMatrix);
+                m_parentVersion = m_parent->m_version;
+            }
+        } else if (m_transformDirty) {
+            Mtx_Copy(&m_modelMatrix, &m_localMatrix);
+        }
+
+        m_transformDirty = false;
+    }
+
+    void Mesh::updateBounds() {
+        if (m_geometry->vertices.size() == 0) {
+            m_geometry->boundingMin = { 0.0f, 0.0f, 0.0f };
+            m_geometry->boundingMax = { 0.0f, 0.0f, 0.0f };
+            m_geometry->boundingRadius = 0.0f;
+            return;
+        }
+
+        m_geometry->boundingMin = { m_geometry->vertices[0].position[0], m_geometry->vertices[0].position[1], m_geometry->vertices[0].position[2] };
+        m_geometry->boundingMax = m_geometry->boundingMin;
+
+        for (const auto& vertex : m_geometry->vertices) {
+            m_geometry->boundingMin.x = fminf(m_geometry->boundingMin.x, vertex.position[0]);
+            m_geometry->boundingMin.y = fminf(m_geometry->boundingMin.y, vertex.position[1]);
+            m_geometry->boundingMin.z = fminf(m_geometry->boundingMin.z, vertex.position[2]);
+            m_geometry->boundingMax.x = fmaxf(m_geometry->boundingMax.x, vertex.position[0]);
+            m_geometry->boundingMax.y = fmaxf(m_geometry->boundingMax.y, vertex.position[1]);
+            m_geometry->boundingMax.z = fmaxf(m_geometry->boundingMax.z, vertex.position[2]);
+        }
+
+        // the bounding sphere is centered on the bounding box
+        float centerX = (m_geometry->boundingMin.x + m_geometry->boundingMax.x) / 2,
+              centerY = (m_geometry->boundingMin.y + m_geometry->boundingMax.y) / 2,
+              centerZ = (m_geometry->boundingMin.z + m_geometry->boundingMax.z) / 2,
+              radius = 0.0f;
+
+        for (const auto& vertex : m_geometry->vertices) {
+            float dx = vertex.position[0] - centerX,
+                  dy = vertex.position[1] - centerY,
+                  dz = vertex.position[2] - centerZ;
+
+            radius = fmaxf(radius, dx * dx + dy * dy + dz * dz);
+        }
+
+        // make sure meshes never get culled because of rounding errors
+        m_geometry->boundingRadius = sqrtf(radius) * 1.001f + 0.0001f;
     }
 } /* m3d */
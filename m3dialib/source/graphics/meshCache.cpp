@@ -0,0 +1,45 @@
+#include "m3d/graphics/meshCache.hpp"
+
+namespace m3d {
+    std::shared_ptr<m3d::Mesh::Geometry> MeshCache::get(const std::string& t_path, m3d::Mesh::VertexFormat t_format) {
+        std::shared_ptr<m3d::Mesh::Geometry> geometry = getCache().get(getKey(t_path, t_format));
+
+        // the format of geometry reached through m3d::Mesh::getGeometry() could have been changed directly
+        return (geometry && geometry->format == t_format ? geometry : nullptr);
+    }
+
+    void MeshCache::add(const std::string& t_path, std::shared_ptr<m3d::Mesh::Geometry> t_geometry) {
+        if (!t_geometry) return;
+
+        t_geometry->cached = true;
+        getCache().add(getKey(t_path, t_geometry->format), t_geometry);
+    }
+
+    void MeshCache::remove(const std::string& t_path) {
+        getCache().remove(getKey(t_path, m3d::Mesh::VertexFormat::Float));
+        getCache().remove(getKey(t_path, m3d::Mesh::VertexFormat::Compact));
+    }
+
+    void MeshCache::clear() {
+        getCache().clear();
+    }
+
+    unsigned int MeshCache::getSize() {
+        return getCache().getSize();
+    }
+
+    // private methods
+    std::string MeshCache::getKey(const std::string& t_path, m3d::Mesh::VertexFormat t_format) {
+        return (t_format == m3d::Mesh::VertexFormat::Compact ? "compact:" : "float:") + t_path;
+    }
+
+    void MeshCache::uncache(m3d::Mesh::Geometry& t_geometry) {
+        // geometry that isn't cached anymore may be changed by its last mesh again
+        t_geometry.cached = false;
+    }
+
+    m3d::priv::WeakCache<m3d::Mesh::Geometry>& MeshCache::getCache() {
+        static m3d::priv::WeakCache<m3d::Mesh::Geometry> cache(&m3d::MeshCache::uncache);
+        return cache;
+    }
+} /* m3d */
@@ -1,63 +1,177 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include "m3d/graphics/drawables/meshes/model.hpp"
-#include "m3d/private/OBJ_Loader.h"
+#include "m3d/graphics/meshCache.hpp"
 
 namespace m3d {
-        bool Model::loadFromFile(const std::string& t_filename) {
-            objl::Loader loader;
+        bool Model::loadFromFile(const std::string& t_filename, bool t_useCache) {
+            FILE* file = fopen(t_filename.c_str(), "rb");
 
-            if(!loader.LoadFile(t_filename)) {
+            if (!file) {
                 return false;
             }
 
-            for (unsigned int i = 0; i < loader.LoadedMeshes.size(); i++) {
-                objl::Mesh curMesh = loader.LoadedMeshes[i];
-
-                for (unsigned int j = 0; j < curMesh.Vertices.size() - 2; j += 3) {
-                    addPolygon(m3d::Mesh::Polygon(
-                        { {
-                            curMesh.Vertices[j].Position.X,
-                            curMesh.Vertices[j].Position.Y,
-                            curMesh.Vertices[j].Position.Z
-                        }, {
-                            curMesh.Vertices[j].TextureCoordinate.X,
-                            curMesh.Vertices[j].TextureCoordinate.Y
-                        }, {
-                            curMesh.Vertices[j].Normal.X,
-                            curMesh.Vertices[j].Normal.Y,
-                            curMesh.Vertices[j].Normal.Z
-                        } },
-
-                        { {
-                            curMesh.Vertices[j + 1].Position.X,
-                            curMesh.Vertices[j + 1].Position.Y,
-                            curMesh.Vertices[j + 1].Position.Z
-                        }, {
-                            curMesh.Vertices[j + 1].TextureCoordinate.X,
-                            curMesh.Vertices[j + 1].TextureCoordinate.Y
-                        }, {
-                            curMesh.Vertices[j + 1].Normal.X,
-                            curMesh.Vertices[j + 1].Normal.Y,
-                            curMesh.Vertices[j + 1].Normal.Z
-                        } },
-
-                        { {
-                            curMesh.Vertices[j + 2].Position.X,
-                            curMesh.Vertices[j + 2].Position.Y,
-                            curMesh.Vertices[j + 2].Position.Z
-                        }, {
-                            curMesh.Vertices[j + 2].TextureCoordinate.X,
-                            curMesh.Vertices[j + 2].TextureCoordinate.Y
-                        }, {
-                            curMesh.Vertices[j + 2].Normal.X,
-                            curMesh.Vertices[j + 2].Normal.Y,
-                            curMesh.Vertices[j + 2].Normal.Z
-                        } }
-                    ));
+            // binary files start with the magic
+            m3d::priv::meshFile::Header header;
+
+            if (fread(&header, 1, sizeof(header), file) == sizeof(header) && memcmp(header.magic, m3d::priv::meshFile::magic, sizeof(header.magic)) == 0) {
+                bool success = loadBinary(file, header, t_filename, t_useCache);
+                fclose(file);
+                return success;
+            }
+
+            fclose(file);
+
+            // both the cached and the parsed geometry use the format the model had before loading
+            m3d::Mesh::VertexFormat format = getVertexFormat();
+
+            static_assert(sizeof(m3d::priv::obj::Vertex) == sizeof(m3d::Mesh::Polygon::Vertex), "the vertex layouts of the parser and the mesh must match");
+
+            m3d::priv::obj::Parser parser;
+
+            if (t_useCache) {
+                std::shared_ptr<m3d::Mesh::Geometry> geometry = m3d::MeshCache::get(t_filename, format);
+
+                if (geometry) {
+                    // the cache only holds the geometry, the material still has to be read
+                    if (parser.parseMaterial(t_filename)) applyMaterial(parser);
+
+                    setGeometry(geometry);
+                    return true;
+                }
+            }
+
+            if (!parser.parseFile(t_filename)) {
+                return false;
+            }
+
+            // load into new geometry, so geometry shared with other meshes stays untouched
+            setGeometry(nullptr);
+            setVertexFormat(format);
+
+            // the parser already merged the vertices, so they can be handed to the mesh in one go
+            setVertices(reinterpret_cast<const m3d::Mesh::Polygon::Vertex*>(parser.getVertices().data()), parser.getVertices().size(), parser.getIndices().data(), parser.getIndices().size());
+
+            applyMaterial(parser);
+
+            // the triangles of .obj-files are in no particular order
+            optimizeVertexCache();
+
+            if (t_useCache) m3d::MeshCache::add(t_filename, getGeometry());
+
+            return true;
+        }
+
+        // private methods
+        bool Model::loadBinary(FILE* t_file, const m3d::priv::meshFile::Header& t_header, const std::string& t_filename, bool t_useCache) {
+            bool compact = t_header.format == m3d::priv::meshFile::CompactFormat;
+
+            if (t_header.version != m3d::priv::meshFile::version ||
+                (t_header.format != m3d::priv::meshFile::FloatFormat && !compact) ||
+                t_header.stride != (compact ? m3d::priv::meshFile::compactStride : m3d::priv::meshFile::floatStride)) {
+                return false;
+            }
+
+            // the attributes have to describe the layout the shader expects from the format
+            static const m3d::priv::meshFile::Attribute floatAttributes[3] = {
+                { m3d::priv::meshFile::Float, 3 }, { m3d::priv::meshFile::Float, 2 }, { m3d::priv::meshFile::Float, 3 }
+            };
+
+            static const m3d::priv::meshFile::Attribute compactAttributes[3] = {
+                { m3d::priv::meshFile::Short, 4 }, { m3d::priv::meshFile::Short, 2 }, { m3d::priv::meshFile::Byte, 4 }
+            };
+
+            const m3d::priv::meshFile::Attribute* attributes = (compact ? compactAttributes : floatAttributes);
+
+            for (int i = 0; i < 3; i++) {
+                if (t_header.attributes[i].type != attributes[i].type || t_header.attributes[i].count != attributes[i].count) return false;
+            }
+
+            // 16-bit indices can't address more vertices, and the sizes of the blobs must not overflow
+            if (t_header.vertexCount == 0 ||
+                (t_header.indexCount > 0 && t_header.vertexCount > 0x10000) ||
+                t_header.vertexCount > UINT32_MAX / t_header.stride ||
+                t_header.indexCount > UINT32_MAX / sizeof(u16)) {
+                return false;
+            }
+
+            if (t_header.flags & m3d::priv::meshFile::hasMaterial) {
+                getMaterial().setAmbient(t_header.ambient[0], t_header.ambient[1], t_header.ambient[2]);
+                getMaterial().setDiffuse(t_header.diffuse[0], t_header.diffuse[1], t_header.diffuse[2]);
+                getMaterial().setSpecular0(t_header.specular[0], t_header.specular[1], t_header.specular[2]);
+            }
+
+            if (t_useCache) {
+                // binary files dictate their vertex format
+                std::shared_ptr<m3d::Mesh::Geometry> geometry = m3d::MeshCache::get(t_filename, compact ? m3d::Mesh::VertexFormat::Compact : m3d::Mesh::VertexFormat::Float);
+
+                if (geometry) {
+                    setGeometry(geometry);
+                    return true;
+                }
+            }
+
+            std::shared_ptr<m3d::Mesh::Geometry> geometry = std::make_shared<m3d::Mesh::Geometry>();
+
+            geometry->format = (compact ? m3d::Mesh::VertexFormat::Compact : m3d::Mesh::VertexFormat::Float);
+            geometry->vboSize = t_header.vertexCount;
+            geometry->iboSize = t_header.indexCount;
+
+            for (int i = 0; i < 3; i++) {
+                AttrInfo_AddLoader(&geometry->attributeInfo, i, static_cast<GPU_FORMATS>(t_header.attributes[i].type), t_header.attributes[i].count);
+                geometry->quantization[i] = FVec4_New(t_header.quantization[i][0], t_header.quantization[i][1], t_header.quantization[i][2], t_header.quantization[i][3]);
+            }
+
+            geometry->boundingMin = { t_header.boundingMin[0], t_header.boundingMin[1], t_header.boundingMin[2] };
+            geometry->boundingMax = { t_header.boundingMax[0], t_header.boundingMax[1], t_header.boundingMax[2] };
+            geometry->boundingRadius = t_header.boundingRadius;
+
+            // read the blobs straight into linear memory
+            geometry->vboCapacity = t_header.vertexCount * t_header.stride;
+            geometry->vbo = linearAlloc(geometry->vboCapacity);
+
+            if (!geometry->vbo ||
+                fseek(t_file, t_header.vertexOffset, SEEK_SET) != 0 ||
+                fread(geometry->vbo, t_header.stride, t_header.vertexCount, t_file) != t_header.vertexCount) {
+                return false;
+            }
+
+            GSPGPU_FlushDataCache(geometry->vbo, geometry->vboCapacity);
+
+            if (t_header.indexCount > 0) {
+                geometry->iboCapacity = t_header.indexCount * sizeof(u16);
+                geometry->ibo = static_cast<u16*>(linearAlloc(geometry->iboCapacity));
+
+                if (!geometry->ibo ||
+                    fseek(t_file, t_header.indexOffset, SEEK_SET) != 0 ||
+                    fread(geometry->ibo, sizeof(u16), t_header.indexCount, t_file) != t_header.indexCount) {
+                    return false;
                 }
+
+                // indices past the vertices would make the GPU read outside of the vertex buffer
+                for (unsigned int i = 0; i < t_header.indexCount; i++) {
+                    if (geometry->ibo[i] >= t_header.vertexCount) return false;
+                }
+
+                GSPGPU_FlushDataCache(geometry->ibo, geometry->iboCapacity);
             }
 
-            updateVBO();
+            setGeometry(geometry);
+
+            if (t_useCache) m3d::MeshCache::add(t_filename, geometry);
 
             return true;
         }
+
+        void Model::applyMaterial(m3d::priv::obj::Parser& t_parser) {
+            if (!t_parser.hasMaterial()) return;
+
+            const m3d::priv::obj::Material& material = t_parser.getMaterial();
+            auto toColor = [](float t_value) { return static_cast<int>(fmaxf(0.0f, fminf(255.0f, roundf(t_value * 255.0f)))); };
+
+            getMaterial().setAmbient(toColor(material.ambient[0]), toColor(material.ambient[1]), toColor(material.ambient[2]));
+            getMaterial().setDiffuse(toColor(material.diffuse[0]), toColor(material.diffuse[1]), toColor(material.diffuse[2]));
+            getMaterial().setSpecular0(toColor(material.specular[0]), toColor(material.specular[1]), toColor(material.specular[2]));
+        }
 } /* m3d */
@@ -1,6 +1,20 @@
+#include <cstring>
 #include "m3d/graphics/renderContext.hpp"
 
 namespace m3d {
+    RenderContext::State::State() :
+        materialValid(false),
+        textureValid(false),
+        attributesValid(false),
+        texturesEnabled(false),
+        texture(nullptr) { /* do nothing */ }
+
+    void RenderContext::State::invalidate() {
+        materialValid = false;
+        textureValid = false;
+        attributesValid = false;
+    }
+
     RenderContext::RenderContext(
         int t_modelUniform,
         bool t_3dEnabled,
@@ -10,22 +24,50 @@ namespace m3d {
         C3D_Mtx& t_model,
         C3D_LightEnv& t_lightEnv,
         C3D_Light& t_light,
-        C3D_LightLut& t_lightLut
+        C3D_LightLut& t_lightLut,
+        bool t_replay,
+        m3d::RenderContext::State* t_state,
+        int t_quantizationUniform,
+        int t_instanceUniform,
+        int t_tintUniform,
+        int t_instancedUniform
     ) :
     m_modelUniformLocation(t_modelUniform),
+    m_quantizationUniformLocation(t_quantizationUniform),
+    m_instanceUniformLocation(t_instanceUniform),
+    m_tintUniformLocation(t_tintUniform),
+    m_instancedUniformLocation(t_instancedUniform),
     m_3dEnabled(t_3dEnabled),
+    m_replay(t_replay),
     m_mode(t_mode),
     m_side(t_side),
     m_target(t_target),
     m_model(t_model),
     m_lightEnv(t_lightEnv),
     m_light(t_light),
-    m_lightLut(t_lightLut) { /* do nothing */ }
+    m_lightLut(t_lightLut),
+    m_state(t_state) { /* do nothing */ }
 
     int RenderContext::getModelUniform() {
         return m_modelUniformLocation;
     }
 
+    int RenderContext::getQuantizationUniform() {
+        return m_quantizationUniformLocation;
+    }
+
+    int RenderContext::getInstanceUniform() {
+        return m_instanceUniformLocation;
+    }
+
+    int RenderContext::getTintUniform() {
+        return m_tintUniformLocation;
+    }
+
+    int RenderContext::getInstancedUniform() {
+        return m_instancedUniformLocation;
+    }
+
     bool RenderContext::is3dEnabled() {
         return m_3dEnabled;
     }
@@ -42,6 +84,10 @@ namespace m3d {
         return m_target;
     }
 
+    bool RenderContext::isReplay() {
+        return m_replay;
+    }
+
     C3D_Mtx& RenderContext::getModelMatrix() {
         return m_model;
     }
@@ -82,4 +128,45 @@ namespace m3d {
                 C3D_TexEnvFunc(env, C3D_Both, GPU_ADD);
         }
     }
+
+    void RenderContext::bindMaterial(const C3D_Material* t_material) {
+        if (m_state && m_state->materialValid && memcmp(&m_state->material, t_material, sizeof(C3D_Material)) == 0) return;
+
+        C3D_LightEnvMaterial(&m_lightEnv, t_material);
+
+        if (m_state) {
+            m_state->material = *t_material;
+            m_state->materialValid = true;
+        }
+    }
+
+    void RenderContext::bindTexture(C3D_Tex* t_texture) {
+        bool enable = t_texture != nullptr,
+             valid = m_state && m_state->textureValid;
+
+        if (!valid || m_state->texturesEnabled != enable) {
+            enableTextures(enable);
+        }
+
+        if (enable && (!valid || m_state->texture != t_texture)) {
+            C3D_TexBind(0, t_texture);
+        }
+
+        if (m_state) {
+            m_state->texturesEnabled = enable;
+            m_state->texture = t_texture;
+            m_state->textureValid = true;
+        }
+    }
+
+    void RenderContext::bindAttributeInfo(const C3D_AttrInfo* t_attributeInfo) {
+        if (m_state && m_state->attributesValid && memcmp(&m_state->attributeInfo, t_attributeInfo, sizeof(C3D_AttrInfo)) == 0) return;
+
+        C3D_SetAttrInfo(const_cast<C3D_AttrInfo*>(t_attributeInfo));
+
+        if (m_state) {
+            m_state->attributeInfo = *t_attributeInfo;
+            m_state->attributesValid = true;
+        }
+    }
 } /* m3d */
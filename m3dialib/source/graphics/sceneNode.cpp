@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+#include "m3d/graphics/sceneNode.hpp"
+
+namespace m3d {
+    SceneNode::SceneNode() :
+        m_posX(0.0f),
+        m_posY(0.0f),
+        m_posZ(0.0f),
+        m_rotationX(0.0f),
+        m_rotationY(0.0f),
+        m_rotationZ(0.0f),
+        m_scaleX(1.0f),
+        m_scaleY(1.0f),
+        m_scaleZ(1.0f),
+        m_localDirty(true),
+        m_worldDirty(true),
+        m_version(1),
+        m_parent(nullptr) { /* do nothing */ }
+
+    SceneNode::~SceneNode() {
+        if (m_parent) m_parent->removeChild(*this);
+
+        for (auto child : m_children) {
+            child->m_parent = nullptr;
+            child->m_localDirty = true;
+            child->invalidate();
+        }
+    }
+
+    void SceneNode::addChild(m3d::SceneNode& t_child) {
+        if (t_child.m_parent == this) return;
+
+        // a node can't become a child of itself or of one of its descendants
+        for (m3d::SceneNode* node = this; node; node = node->m_parent) {
+            if (node == &t_child) return;
+        }
+
+        if (t_child.m_parent) t_child.m_parent->removeChild(t_child);
+
+        t_child.m_parent = this;
+        t_child.m_localDirty = true;
+        m_children.push_back(&t_child);
+        t_child.invalidate();
+    }
+
+    void SceneNode::removeChild(m3d::SceneNode& t_child) {
+        auto it = std::find(m_children.begin(), m_children.end(), &t_child);
+        if (it == m_children.end()) return;
+
+        m_children.erase(it);
+        t_child.m_parent = nullptr;
+        t_child.m_localDirty = true;
+        t_child.invalidate();
+    }
+
+    m3d::SceneNode* SceneNode::getParent() {
+        return m_parent;
+    }
+
+    unsigned int SceneNode::getChildCount() {
+        return m_children.size();
+    }
+
+    m3d::SceneNode* SceneNode::getChild(unsigned int t_index) {
+        return (t_index < m_children.size() ? m_children[t_index] : nullptr);
+    }
+
+    void SceneNode::setPosition(float t_positionX, float t_positionY, float t_positionZ) {
+        m_posX = t_positionX;
+        m_posY = t_positionY;
+        m_posZ = t_positionZ;
+        m_localDirty = true;
+        invalidate();
+    }
+
+    void SceneNode::setPosition(m3d::Vector3f t_position) {
+        setPosition(t_position.x, t_position.y, t_position.z);
+    }
+
+    m3d::Vector3f SceneNode::getPosition() {
+        return { m_posX, m_posY, m_posZ };
+    }
+
+    void SceneNode::move(float t_deltaX, float t_deltaY, float t_deltaZ) {
+        setPosition(m_posX + t_deltaX, m_posY + t_deltaY, m_posZ + t_deltaZ);
+    }
+
+    void SceneNode::setRotation(float t_pitch, float t_yaw, float t_roll, bool t_radians) {
+        m_rotationX = (t_radians ? t_pitch : C3D_AngleFromDegrees(t_pitch));
+        m_rotationY = (t_radians ? t_yaw : C3D_AngleFromDegrees(t_yaw));
+        m_rotationZ = (t_radians ? t_roll : C3D_AngleFromDegrees(t_roll));
+        m_localDirty = true;
+        invalidate();
+    }
+
+    m3d::Vector3f SceneNode::getRotation(bool t_radians) {
+        if (t_radians) return { m_rotationX, m_rotationY, m_rotationZ };
+
+        const float degrees = 180.0f / M_PI;
+        return { m_rotationX * degrees, m_rotationY * degrees, m_rotationZ * degrees };
+    }
+
+    void SceneNode::rotate(float t_deltaPitch, float t_deltaYaw, float t_deltaRoll, bool t_radians) {
+        if (t_radians) {
+            setRotation(m_rotationX + t_deltaPitch, m_rotationY + t_deltaYaw, m_rotationZ + t_deltaRoll, true);
+        } else {
+            setRotation(m_rotationX + C3D_AngleFromDegrees(t_deltaPitch), m_rotationY + C3D_AngleFromDegrees(t_deltaYaw), m_rotationZ + C3D_AngleFromDegrees(t_deltaRoll), true);
+        }
+    }
+
+    void SceneNode::setScale(float t_scaleX, float t_scaleY, float t_scaleZ) {
+        m_scaleX = t_scaleX;
+        m_scaleY = t_scaleY;
+        m_scaleZ = t_scaleZ;
+        m_localDirty = true;
+        invalidate();
+    }
+
+    m3d::Vector3f SceneNode::getScale() {
+        return { m_scaleX, m_scaleY, m_scaleZ };
+    }
+
+    const C3D_Mtx& SceneNode::getLocalMatrix() {
+        if (m_localDirty) {
+            // the same transformation as the one of m3d::Mesh, root nodes share the origin of meshes
+            Mtx_Identity(&m_localMatrix);
+            Mtx_Translate(&m_localMatrix, m_posX, m_posY, (m_parent ? 0.0f : -1.87f) - m_posZ, true);
+            Mtx_RotateX(&m_localMatrix, m_rotationX, true);
+            Mtx_RotateY(&m_localMatrix, m_rotationY, true);
+            Mtx_RotateZ(&m_localMatrix, m_rotationZ, true);
+            Mtx_Scale(&m_localMatrix, m_scaleX, m_scaleY, m_scaleZ);
+
+            m_localDirty = false;
+        }
+
+        return m_localMatrix;
+    }
+
+    const C3D_Mtx& SceneNode::getWorldMatrix() {
+        if (m_worldDirty) {
+            if (m_parent) {
+                Mtx_Multiply(&m_worldMatrix, &m_parent->getWorldMatrix(), &getLocalMatrix());
+            } else {
+                Mtx_Copy(&m_worldMatrix, &getLocalMatrix());
+            }
+
+            m_worldDirty = false;
+            m_version++;
+        }
+
+        return m_worldMatrix;
+    }
+
+    // private methods
+    void SceneNode::invalidate() {
+        // the descendants of dirty nodes are always dirty as well
+        if (m_worldDirty) return;
+
+        m_worldDirty = true;
+
+        for (auto child : m_children) {
+            child->invalidate();
+        }
+    }
+} /* m3d */
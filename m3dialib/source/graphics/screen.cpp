@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <citro2d.h>
 #include "m3d/graphics/screen.hpp"
 #include "m3d/graphics/color.hpp"
+#include "m3d/graphics/textureLoader.hpp"
 #include "m3d/private/graphics.hpp"
 #include "render3d_shbin.h"
 
@@ -8,6 +10,11 @@ namespace m3d {
     Screen::Screen(bool t_enable3d) :
             m_3dEnabled(t_enable3d),
             m_useCulling(true),
+            m_useStereoReplay(false),
+            m_useStateSorting(true),
+            m_useFrustumCulling(true),
+            m_drawnObjects(0),
+            m_culledObjects(0),
             m_clearColorTop(m3d::Color(0, 0, 0)),
             m_clearColorBottom(m3d::Color(0, 0, 0)),
             m_cameraTop(m3d::priv::graphics::defaultCamera0),
@@ -17,6 +24,13 @@ namespace m3d {
             m_fogDensityTop(0.05),
             m_fogDensityBottom(0.05) {
         C2D_Init(C2D_DEFAULT_MAX_OBJECTS);
+
+        // preallocate the draw stacks so the first frames don't have to grow them
+        m_drawStackTop2d.reserve(256);
+        m_drawStackTop3d.reserve(256);
+        m_drawStackBottom2d.reserve(256);
+        m_drawStackBottom3d.reserve(256);
+
         gfxSet3D(m_3dEnabled);
         m_targetTopLeft  = new m3d::RenderTarget(400, 240);
         m_targetTopRight = new m3d::RenderTarget(400, 240);
@@ -36,6 +50,10 @@ namespace m3d {
         m_projectionUniform = shaderInstanceGetUniformLocation(m_shader.vertexShader, "projection");
         m_modelUniform = shaderInstanceGetUniformLocation(m_shader.vertexShader, "model");
         m_viewUniform = shaderInstanceGetUniformLocation(m_shader.vertexShader, "view");
+        m_quantizationUniform = shaderInstanceGetUniformLocation(m_shader.vertexShader, "quantization");
+        m_instanceUniform = shaderInstanceGetUniformLocation(m_shader.vertexShader, "instances");
+        m_tintUniform = shaderInstanceGetUniformLocation(m_shader.vertexShader, "tints");
+        m_instancedUniform = shaderInstanceGetUniformLocation(m_shader.vertexShader, "instanced");
 
         AttrInfo_Init(&m_attributeInfo);
         AttrInfo_AddLoader(&m_attributeInfo, 0, GPU_FLOAT, 3); // v0=position
@@ -86,6 +104,38 @@ namespace m3d {
         return m_useCulling;
     }
 
+    void Screen::useStereoReplay(bool t_useStereoReplay) {
+        m_useStereoReplay = t_useStereoReplay;
+    }
+
+    bool Screen::isUsingStereoReplay() {
+        return m_useStereoReplay;
+    }
+
+    void Screen::useStateSorting(bool t_useStateSorting) {
+        m_useStateSorting = t_useStateSorting;
+    }
+
+    bool Screen::isUsingStateSorting() {
+        return m_useStateSorting;
+    }
+
+    void Screen::useFrustumCulling(bool t_useFrustumCulling) {
+        m_useFrustumCulling = t_useFrustumCulling;
+    }
+
+    bool Screen::isUsingFrustumCulling() {
+        return m_useFrustumCulling;
+    }
+
+    unsigned int Screen::getDrawnObjects() {
+        return m_drawnObjects;
+    }
+
+    unsigned int Screen::getCulledObjects() {
+        return m_culledObjects;
+    }
+
     void Screen::setClearColor(m3d::Color t_color) {
         m_clearColorTop = t_color;
         m_clearColorBottom = t_color;
@@ -102,88 +152,27 @@ namespace m3d {
     }
 
     void Screen::drawTop(m3d::Drawable& t_object, m3d::RenderContext::Mode t_mode, int t_layer) {
-        if (t_mode == m3d::RenderContext::Mode::Flat) {
-            if(m_drawStackTop2d.count(t_layer) > 0) {
-                m_drawStackTop2d[t_layer].insert(m_drawStackTop2d[t_layer].end(), std::make_pair(&t_object, [](){return true;}));
-            } else {
-                std::vector<std::pair<m3d::Drawable*, std::function<bool()>>> newStack;
-                newStack.push_back(std::make_pair(&t_object, [](){return true;}));
-                m_drawStackTop2d.insert(std::make_pair(t_layer, newStack));
-            }
-        } else {
-            if(m_drawStackTop3d.count(t_layer) > 0) {
-                m_drawStackTop3d[t_layer].insert(m_drawStackTop3d[t_layer].end(), std::make_pair(&t_object, [](){return true;}));
-            } else {
-                std::vector<std::pair<m3d::Drawable*, std::function<bool()>>> newStack;
-                newStack.push_back(std::make_pair(&t_object, [](){return true;}));
-                m_drawStackTop3d.insert(std::make_pair(t_layer, newStack));
-            }
-        }
+        enqueue(t_mode == m3d::RenderContext::Mode::Flat ? m_drawStackTop2d : m_drawStackTop3d, t_object, nullptr, t_layer);
     }
 
     void Screen::drawTop(m3d::Drawable& t_object, std::function<bool()> t_shadingFunction, m3d::RenderContext::Mode t_mode, int t_layer) {
-        if (t_mode == m3d::RenderContext::Mode::Flat) {
-            if(m_drawStackTop2d.count(t_layer) > 0) {
-                m_drawStackTop2d[t_layer].insert(m_drawStackTop2d[t_layer].end(), std::make_pair(&t_object, t_shadingFunction));
-            } else {
-                std::vector<std::pair<m3d::Drawable*, std::function<bool()>>> newStack;
-                newStack.push_back(std::make_pair(&t_object, t_shadingFunction));
-                m_drawStackTop2d.insert(std::make_pair(t_layer, newStack));
-            }
-        } else {
-            if(m_drawStackTop3d.count(t_layer) > 0) {
-                m_drawStackTop3d[t_layer].insert(m_drawStackTop3d[t_layer].end(), std::make_pair(&t_object, t_shadingFunction));
-            } else {
-                std::vector<std::pair<m3d::Drawable*, std::function<bool()>>> newStack;
-                newStack.push_back(std::make_pair(&t_object, t_shadingFunction));
-                m_drawStackTop3d.insert(std::make_pair(t_layer, newStack));
-            }
-        }
+        enqueue(t_mode == m3d::RenderContext::Mode::Flat ? m_drawStackTop2d : m_drawStackTop3d, t_object, std::move(t_shadingFunction), t_layer);
     }
 
     void Screen::drawBottom(m3d::Drawable& t_object, m3d::RenderContext::Mode t_mode, int t_layer) {
-        if (t_mode == m3d::RenderContext::Mode::Flat) {
-            if(m_drawStackBottom2d.count(t_layer) > 0) {
-                m_drawStackBottom2d[t_layer].insert(m_drawStackBottom2d[t_layer].end(), std::make_pair(&t_object, [](){return true;}));
-            } else {
-                std::vector<std::pair<m3d::Drawable*, std::function<bool()>>> newStack;
-                newStack.push_back(std::make_pair(&t_object, [](){return true;}));
-                m_drawStackBottom2d.insert(std::make_pair(t_layer, newStack));
-            }
-        } else {
-            if(m_drawStackBottom3d.count(t_layer) > 0) {
-                m_drawStackBottom3d[t_layer].insert(m_drawStackBottom3d[t_layer].end(), std::make_pair(&t_object, [](){return true;}));
-            } else {
-                std::vector<std::pair<m3d::Drawable*, std::function<bool()>>> newStack;
-                newStack.push_back(std::make_pair(&t_object, [](){return true;}));
-                m_drawStackBottom3d.insert(std::make_pair(t_layer, newStack));
-            }
-        }
+        enqueue(t_mode == m3d::RenderContext::Mode::Flat ? m_drawStackBottom2d : m_drawStackBottom3d, t_object, nullptr, t_layer);
     }
 
     void Screen::drawBottom(m3d::Drawable& t_object, std::function<bool()> t_shadingFunction, m3d::RenderContext::Mode t_mode, int t_layer) {
-        if (t_mode == m3d::RenderContext::Mode::Flat) {
-            if(m_drawStackBottom2d.count(t_layer) > 0) {
-                m_drawStackBottom2d[t_layer].insert(m_drawStackBottom2d[t_layer].end(), std::make_pair(&t_object, t_shadingFunction));
-            } else {
-                std::vector<std::pair<m3d::Drawable*, std::function<bool()>>> newStack;
-                newStack.push_back(std::make_pair(&t_object, t_shadingFunction));
-                m_drawStackBottom2d.insert(std::make_pair(t_layer, newStack));
-            }
-        } else {
-            if(m_drawStackBottom3d.count(t_layer) > 0) {
-                m_drawStackBottom3d[t_layer].insert(m_drawStackBottom3d[t_layer].end(), std::make_pair(&t_object, t_shadingFunction));
-            } else {
-                std::vector<std::pair<m3d::Drawable*, std::function<bool()>>> newStack;
-                newStack.push_back(std::make_pair(&t_object, t_shadingFunction));
-                m_drawStackBottom3d.insert(std::make_pair(t_layer, newStack));
-            }
-        }
+        enqueue(t_mode == m3d::RenderContext::Mode::Flat ? m_drawStackBottom2d : m_drawStackBottom3d, t_object, std::move(t_shadingFunction), t_layer);
     }
 
     void Screen::render(bool t_clear) {
         C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
 
+        // the previous frame is done, so placeholders of textures loaded in the background can be replaced
+        m3d::TextureLoader::publish();
+
         if (t_clear) {
             m_targetTopLeft->clear();
             m_targetTopRight->clear();
@@ -191,103 +180,61 @@ namespace m3d {
             clear();
         }
 
+        m_drawnObjects = 0;
+        m_culledObjects = 0;
+
+        // the selected levels of detail change the state keys and bounds of the objects
+        selectLevelsOfDetail(m_drawStackTop3d, m_cameraTop);
+        selectLevelsOfDetail(m_drawStackBottom3d, m_cameraBottom);
+
+        sortDrawStack(m_drawStackTop2d);
+        sortDrawStack(m_drawStackTop3d, true);
+        sortDrawStack(m_drawStackBottom2d);
+        sortDrawStack(m_drawStackBottom3d, true);
+
         // draw 3d
         if(m_drawStackTop3d.size() > 0 || m_drawStackBottom3d.size() > 0) {
             prepare();
             C3D_DepthTest(true, GPU_GEQUAL, GPU_WRITE_ALL);
-            Mtx_PerspStereoTilt(&m_projection, C3D_AngleFromDegrees(40.0f), C3D_AspectRatioBot, 0.01f, 1000.0f, 0, 2.0f, false);
-
-            C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, m_projectionUniform, &m_projection);
-            C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, m_viewUniform, &m_cameraBottom.getViewMatrix());
 
             if(m_drawStackBottom3d.size() > 0) {
                 C3D_FrameDrawOn(m_targetBottom->getRenderTarget());
                 prepareLights(m3d::RenderContext::ScreenTarget::Bottom);
                 if (m_useFogBottom) prepareFog(m3d::RenderContext::ScreenTarget::Bottom);
 
-                for(const auto &entry : m_drawStackBottom3d) { // for every layer
-                    for(const auto &drawable : entry.second) { // draw every object
-                        if (drawable.second()) {
-                            drawable.first->draw(m3d::RenderContext(
-                                m_modelUniform, // modelUniform
-                                m_3dEnabled, // 3dEnabled
-                                m3d::RenderContext::Mode::Spatial,        // mode
-                                m3d::RenderContext::Stereo3dSide::Left,   // side
-                                m3d::RenderContext::ScreenTarget::Bottom, // target
-                                m_model,  // model
-                                m_lightEnvBottom, // lightEnv
-                                m_lightBottom,    // light
-                                m_lutPhongBottom  // lutPhong
-                            ));
-                        }
-                    }
-                }
+                C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, m_projectionUniform, &m_cameraBottom.getProjectionMatrix(C3D_AspectRatioBot));
+                C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, m_viewUniform, &m_cameraBottom.getViewMatrix());
 
+                if (m_useFrustumCulling) cullDrawStack(m_drawStackBottom3d, m_cameraBottom.getViewProjectionMatrix(C3D_AspectRatioBot));
+                renderDrawStack(m_drawStackBottom3d, m3d::RenderContext::Mode::Spatial, m3d::RenderContext::Stereo3dSide::Left, m3d::RenderContext::ScreenTarget::Bottom);
                 m_drawStackBottom3d.clear();
             }
 
             if (m_drawStackTop3d.size() > 0) {
+                bool stereo = m_3dEnabled && osGet3DSliderState() > 0.0f;
+
+                // tilt stereo perspective (the camera caches the projections of both eyes)
+                float eyeOffset = (m_3dEnabled ? osGet3DSliderState() / 3.0f : 0.0f);
+
                 C3D_FrameDrawOn(m_targetTopLeft->getRenderTarget());
                 prepareLights(m3d::RenderContext::ScreenTarget::Top);
                 if (m_useFogTop) prepareFog(m3d::RenderContext::ScreenTarget::Top);
 
-                // tilt stereo perspective
-                if (m_3dEnabled) {
-                    Mtx_PerspStereoTilt(&m_projection, C3D_AngleFromDegrees(40.0f), C3D_AspectRatioTop, 0.01f, 1000.0f, -(osGet3DSliderState() / 3.0f), 2.0f, false);
-                } else {
-                    Mtx_PerspStereoTilt(&m_projection, C3D_AngleFromDegrees(40.0f), C3D_AspectRatioTop, 0.01f, 1000.0f, 0, 2.0f, false);
-                }
-
-                C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, m_projectionUniform, &m_projection);
+                C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, m_projectionUniform, &m_cameraTop.getProjectionMatrix(C3D_AspectRatioTop, -eyeOffset));
                 C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, m_viewUniform, &m_cameraTop.getViewMatrix());
 
-                for (const auto &entry : m_drawStackTop3d) { // for every layer
-                    for (const auto &drawable : entry.second) { // draw every object
-                        if (drawable.second()) {
-                            drawable.first->draw(m3d::RenderContext(
-                                m_modelUniform, // modelUniform
-                                m_3dEnabled, // 3dEnabled
-                                m3d::RenderContext::Mode::Spatial,      // mode
-                                m3d::RenderContext::Stereo3dSide::Left, // side
-                                m3d::RenderContext::ScreenTarget::Top,  // target
-                                m_model,  // model
-                                m_lightEnvTop, // lightEnv
-                                m_lightTop,    // light
-                                m_lutPhongTop  // lutPhong
-                            ));
-                        }
-                    }
+                // objects get culled once for both eyes
+                if (m_useFrustumCulling) {
+                    cullDrawStack(m_drawStackTop3d, m_cameraTop.getViewProjectionMatrix(C3D_AspectRatioTop, -eyeOffset), stereo ? &m_cameraTop.getViewProjectionMatrix(C3D_AspectRatioTop, eyeOffset) : nullptr);
                 }
 
-                if (m_3dEnabled && osGet3DSliderState() > 0.0f) {
+                renderDrawStack(m_drawStackTop3d, m3d::RenderContext::Mode::Spatial, m3d::RenderContext::Stereo3dSide::Left, m3d::RenderContext::ScreenTarget::Top);
+
+                if (stereo) {
                     C3D_FrameDrawOn(m_targetTopRight->getRenderTarget());
+                    C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, m_projectionUniform, &m_cameraTop.getProjectionMatrix(C3D_AspectRatioTop, eyeOffset));
 
-                    // tilt stereo perspective
-                    if (m_3dEnabled) {
-                        Mtx_PerspStereoTilt(&m_projection, C3D_AngleFromDegrees(40.0f), C3D_AspectRatioTop, 0.01f, 1000.0f, osGet3DSliderState() / 3.0f, 2.0f, false);
-                    } else {
-                        Mtx_PerspStereoTilt(&m_projection, C3D_AngleFromDegrees(40.0f), C3D_AspectRatioTop, 0.01f, 1000.0f, 0, 2.0f, false);
-                    }
-
-                    C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, m_projectionUniform, &m_projection);
-
-                    for (const auto &entry : m_drawStackTop3d) { // for every layer
-                        for (const auto &drawable : entry.second) { // draw every object
-                            if (drawable.second()) {
-                                drawable.first->draw(m3d::RenderContext(
-                                    m_modelUniform, // modelUniform
-                                    m_3dEnabled, // 3dEnabled
-                                    m3d::RenderContext::Mode::Spatial,       // mode
-                                    m3d::RenderContext::Stereo3dSide::Right, // side
-                                    m3d::RenderContext::ScreenTarget::Top,   // target
-                                    m_model,  // model
-                                    m_lightEnvTop, // lightEnv
-                                    m_lightTop,    // light
-                                    m_lutPhongTop  // lutPhong
-                                ));
-                            }
-                        }
-                    }
+                    renderDrawStack(m_drawStackTop3d, m3d::RenderContext::Mode::Spatial, m3d::RenderContext::Stereo3dSide::Right, m3d::RenderContext::ScreenTarget::Top, m_useStereoReplay);
                 }
 
                 m_drawStackTop3d.clear();
@@ -302,68 +249,19 @@ namespace m3d {
             if(m_drawStackBottom2d.size() > 0) {
                 C2D_SceneBegin(m_targetBottom->getRenderTarget());
 
-                for(const auto &entry : m_drawStackBottom2d) { // for every layer
-                    for(const auto &drawable : entry.second) { // draw every object
-                        if (drawable.second()) {
-                            drawable.first->draw(m3d::RenderContext(
-                                m_modelUniform, // modelUniform
-                                m_3dEnabled, // 3dEnabled
-                                m3d::RenderContext::Mode::Flat,           // mode
-                                m3d::RenderContext::Stereo3dSide::Left,   // side
-                                m3d::RenderContext::ScreenTarget::Bottom, // target
-                                m_model,  // model
-                                m_lightEnvBottom, // lightEnv
-                                m_lightBottom,    // light
-                                m_lutPhongBottom  // lutPhong
-                            ));
-                        }
-                    }
-                }
-
+                renderDrawStack(m_drawStackBottom2d, m3d::RenderContext::Mode::Flat, m3d::RenderContext::Stereo3dSide::Left, m3d::RenderContext::ScreenTarget::Bottom);
                 m_drawStackBottom2d.clear();
             }
 
             if(m_drawStackTop2d.size() > 0) {
                 C2D_SceneBegin(m_targetTopLeft->getRenderTarget());
 
-                for(const auto &entry : m_drawStackTop2d) { // for every layer
-                    for(const auto &drawable : entry.second) { // draw every object
-                        if (drawable.second()) {
-                            drawable.first->draw(m3d::RenderContext(
-                                m_modelUniform, // modelUniform
-                                m_3dEnabled, // 3dEnabled
-                                m3d::RenderContext::Mode::Flat,         // mode
-                                m3d::RenderContext::Stereo3dSide::Left, // side
-                                m3d::RenderContext::ScreenTarget::Top,  // target
-                                m_model,  // model
-                                m_lightEnvTop, // lightEnv
-                                m_lightTop,    // light
-                                m_lutPhongTop  // lutPhong
-                            ));
-                        }
-                    }
-                }
+                renderDrawStack(m_drawStackTop2d, m3d::RenderContext::Mode::Flat, m3d::RenderContext::Stereo3dSide::Left, m3d::RenderContext::ScreenTarget::Top);
 
                 if(m_3dEnabled && osGet3DSliderState() > 0.0f) {
                     C2D_SceneBegin(m_targetTopRight->getRenderTarget());
 
-                    for(const auto &entry : m_drawStackTop2d) { // for every layer
-                        for(const auto &drawable : entry.second) { // draw every object
-                            if (drawable.second()) {
-                                drawable.first->draw(m3d::RenderContext(
-                                    m_modelUniform, // modelUniform
-                                    m_3dEnabled, // 3dEnabled
-                                    m3d::RenderContext::Mode::Flat,          // mode
-                                    m3d::RenderContext::Stereo3dSide::Right, // side
-                                    m3d::RenderContext::ScreenTarget::Top,   // target
-                                    m_model,  // model
-                                    m_lightEnvTop, // lightEnv
-                                    m_lightTop,    // light
-                                    m_lutPhongTop  // lutPhong
-                                ));
-                            }
-                        }
-                    }
+                    renderDrawStack(m_drawStackTop2d, m3d::RenderContext::Mode::Flat, m3d::RenderContext::Stereo3dSide::Right, m3d::RenderContext::ScreenTarget::Top, m_useStereoReplay);
                 }
 
                 m_drawStackTop2d.clear();
@@ -426,11 +324,136 @@ namespace m3d {
     }
 
     // private methods
+    void Screen::enqueue(std::vector<m3d::Screen::DrawCommand>& t_stack, m3d::Drawable& t_object, std::function<bool()> t_shadingFunction, int t_layer) {
+        t_stack.emplace_back();
+
+        m3d::Screen::DrawCommand& command = t_stack.back();
+        command.layer = t_layer;
+        command.index = t_stack.size() - 1;
+        command.key = 0;
+        command.group = 0;
+        command.drawable = &t_object;
+        command.shadingFunction = std::move(t_shadingFunction);
+        command.visible = true;
+    }
+
+    void Screen::sortDrawStack(std::vector<m3d::Screen::DrawCommand>& t_stack, bool t_spatial) {
+        bool sortByState = t_spatial && m_useStateSorting;
+
+        if (t_spatial) {
+            unsigned int group = 0;
+
+            // the stack is still in submission order here
+            for (auto& command : t_stack) {
+                command.key = command.drawable->getStateKey();
+
+                // objects with their own shading function use a different shader
+                if (command.key != 0 && command.shadingFunction) command.key |= 1ull << 63;
+
+                // blending depends on the order, so everything but opaque objects keeps its position relative to all other objects
+                if (command.key & m3d::Drawable::OpaqueStateBit) {
+                    command.group = group;
+                } else {
+                    command.group = ++group;
+                    group++;
+                }
+            }
+        }
+
+        auto compare = [sortByState](const m3d::Screen::DrawCommand& t_lhs, const m3d::Screen::DrawCommand& t_rhs) {
+            if (t_lhs.layer != t_rhs.layer) return t_lhs.layer < t_rhs.layer;
+            if (sortByState && t_lhs.group != t_rhs.group) return t_lhs.group < t_rhs.group;
+            if (sortByState && t_lhs.key != t_rhs.key) return t_lhs.key < t_rhs.key;
+            return t_lhs.index < t_rhs.index;
+        };
+
+        // most frames are drawn layer by layer, so only sort when necessary
+        if (!std::is_sorted(t_stack.begin(), t_stack.end(), compare)) {
+            std::sort(t_stack.begin(), t_stack.end(), compare);
+        }
+    }
+
+    void Screen::selectLevelsOfDetail(std::vector<m3d::Screen::DrawCommand>& t_stack, m3d::Camera& t_camera) {
+        if (t_stack.empty()) return;
+
+        // one level per frame for both eyes, the eyes are close enough to each other
+        m3d::Vector3f eye = t_camera.getEyePosition();
+
+        for (auto& command : t_stack) {
+            command.drawable->selectLevelOfDetail(eye);
+        }
+    }
+
+    void Screen::cullDrawStack(std::vector<m3d::Screen::DrawCommand>& t_stack, const C3D_Mtx& t_viewProjection, const C3D_Mtx* t_viewProjectionRight) {
+        m_frustumLeft.update(t_viewProjection);
+        if (t_viewProjectionRight) m_frustumRight.update(*t_viewProjectionRight);
+
+        for (auto& command : t_stack) {
+            // with stereoscopic 3D, objects are only culled if neither eye can see them
+            command.culled = !command.drawable->isVisible(m_frustumLeft) &&
+                             !(t_viewProjectionRight && command.drawable->isVisible(m_frustumRight));
+
+            if (command.culled) m_culledObjects++;
+        }
+    }
+
+    void Screen::renderDrawStack(std::vector<m3d::Screen::DrawCommand>& t_stack, m3d::RenderContext::Mode t_mode, m3d::RenderContext::Stereo3dSide t_side, m3d::RenderContext::ScreenTarget t_target, bool t_replay) {
+        bool top = t_target == m3d::RenderContext::ScreenTarget::Top,
+             spatial = t_mode == m3d::RenderContext::Mode::Spatial;
+
+        m_renderState.invalidate();
+
+        for (auto& command : t_stack) {
+            if (command.culled) continue;
+
+            // when replaying, reuse the result of the shading function from the previous pass
+            if (command.shadingFunction) {
+                if (!t_replay) command.visible = command.shadingFunction();
+
+                // the shading function may have changed the GPU state
+                m_renderState.invalidate();
+            }
+
+            if (command.visible) {
+                // objects without a state key expect the default vertex format (after an invalidation, the previous mesh may have left any format behind)
+                if (spatial && command.key == 0 && (!m_renderState.attributesValid || memcmp(&m_renderState.attributeInfo, &m_attributeInfo, sizeof(C3D_AttrInfo)) != 0)) {
+                    prepareVertexFormat();
+                    m_renderState.attributeInfo = m_attributeInfo;
+                    m_renderState.attributesValid = true;
+                }
+
+                command.drawable->draw(m3d::RenderContext(
+                    m_modelUniform, // modelUniform
+                    m_3dEnabled,    // 3dEnabled
+                    t_mode,         // mode
+                    t_side,         // side
+                    t_target,       // target
+                    m_model,        // model
+                    top ? m_lightEnvTop : m_lightEnvBottom, // lightEnv
+                    top ? m_lightTop : m_lightBottom,       // light
+                    top ? m_lutPhongTop : m_lutPhongBottom, // lutPhong
+                    t_replay,       // replay
+                    spatial ? &m_renderState : nullptr,     // state
+                    m_quantizationUniform,                  // quantizationUniform
+                    m_instanceUniform,                      // instanceUniform
+                    m_tintUniform,                          // tintUniform
+                    m_instancedUniform                      // instancedUniform
+                ));
+
+                // objects without a state key set their own state
+                if (command.key == 0) m_renderState.invalidate();
+
+                if (spatial && t_side == m3d::RenderContext::Stereo3dSide::Left) m_drawnObjects++;
+            }
+        }
+    }
+
     void Screen::prepare() {
         C3D_BindProgram(&m_shader);
 
         // initialize and configure attributes
-        C3D_SetAttrInfo(&m_attributeInfo);
+        prepareVertexFormat();
+        C3D_BoolUnifSet(GPU_VERTEX_SHADER, m_instancedUniform, false);
 
         // Configure the first fragment shading substage to blend the fragment primary color
         // with the fragment secondary color.
@@ -473,4 +496,12 @@ namespace m3d {
                 C3D_LightEnvBind(&m_lightEnvTop);
         }
     }
+
+    void Screen::prepareVertexFormat() {
+        // floating point vertices, which don't need to be dequantized
+        C3D_SetAttrInfo(&m_attributeInfo);
+        C3D_FVUnifSet(GPU_VERTEX_SHADER, m_quantizationUniform,     1.0f, 1.0f, 1.0f, 0.0f);
+        C3D_FVUnifSet(GPU_VERTEX_SHADER, m_quantizationUniform + 1, 0.0f, 0.0f, 0.0f, 0.0f);
+        C3D_FVUnifSet(GPU_VERTEX_SHADER, m_quantizationUniform + 2, 1.0f, 1.0f, 0.0f, 0.0f);
+    }
 } /* m3d */
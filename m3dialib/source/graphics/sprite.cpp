@@ -12,10 +12,11 @@ namespace m3d {
             m_scaleY(1.0f),
             m_rotation(0.f),
             m_blendStrength(0.f),
+            m_textureLoading(false),
             m_spriteSheetPath(""),
             m_tintColor(m3d::Color(255, 255, 255, 255)) {
                 updateTint();
-                m_spriteSheet = nullptr;
+                updateImage({ nullptr, nullptr });
             }
 
     Sprite::Sprite(const std::string& t_spriteSheet, int t_imageId) :
@@ -24,10 +25,12 @@ namespace m3d {
             m_centerX(0),
             m_centerY(0),
             m_opacity(255),
+            m_index(0),
             m_scaleX(1.0f),
             m_scaleY(1.0f),
             m_rotation(0),
             m_blendStrength(0.f),
+            m_textureLoading(false),
             m_tintColor(m3d::Color(255, 255, 255, 255)) {
                 updateTint();
                 setSpriteSheet(t_spriteSheet, t_imageId);
@@ -200,22 +203,77 @@ namespace m3d {
     }
 
     void Sprite::setSpriteSheet(const std::string& t_spriteSheet, int t_imageId) {
+        // sprites using the same sheet share it instead of loading it again
+        m3d::SpriteSheet spriteSheet;
+        spriteSheet.loadFromFile(t_spriteSheet);
+
+        setSpriteSheet(spriteSheet, t_imageId);
         m_spriteSheetPath = t_spriteSheet;
+    }
+
+    void Sprite::setSpriteSheet(const m3d::SpriteSheet& t_spriteSheet, int t_imageId) {
+        m_texture.setData(nullptr);
+        m_textureLoading = false;
+        m_spriteSheet = t_spriteSheet;
+        m_spriteSheetPath = m_spriteSheet.getPath();
+        setImage(t_imageId);
+    }
+
+    void Sprite::setSpriteSheet(const m3d::SpriteSheet& t_spriteSheet, const std::string& t_imageName) {
+        m_texture.setData(nullptr);
+        m_textureLoading = false;
+        m_spriteSheet = t_spriteSheet;
+        m_spriteSheetPath = m_spriteSheet.getPath();
+        setImage(t_imageName);
+    }
+
+    void Sprite::setImage(int t_imageId) {
         m_index = t_imageId;
-        m_spriteSheet = C2D_SpriteSheetLoad(m_spriteSheetPath.c_str());
+        updateImage(m_spriteSheet.getImage(m_index));
+    }
 
-        C2D_SpriteFromSheet(&m_sprite, m_spriteSheet, m_index);
+    void Sprite::setImage(const std::string& t_imageName) {
+        setImage(m_spriteSheet.getIndex(t_imageName));
+    }
+
+    int Sprite::getImageId() {
+        return m_index;
     }
 
     void Sprite::setTexture(m3d::Texture& t_texture) {
-        C2D_SpriteFromImage(&m_sprite, t_texture.getImage());
+        m_spriteSheet.setData(nullptr);
+        m_spriteSheetPath = "";
+
+        // the copy keeps the texture data and the subtexture the image points to alive
+        m_texture = t_texture;
+        m_textureLoading = m_texture.getStatus() == m3d::Texture::Status::Loading;
+        updateImage(m_texture.getImage());
     }
 
     const std::string& Sprite::getSpriteSheet() {
         return m_spriteSheetPath;
     }
 
+    m3d::SpriteSheet& Sprite::getSpriteSheetData() {
+        return m_spriteSheet;
+    }
+
     void Sprite::draw(m3d::RenderContext t_context) {
+        if (m_texture.getTexture()) {
+            C2D_Image& image = m_texture.getImage();
+
+            if (m_textureLoading && m_texture.getStatus() != m3d::Texture::Status::Loading) {
+                // textures loaded in the background only have their final size once they're loaded
+                m_textureLoading = false;
+                updateImage(image);
+            } else {
+                // copies of the sprite point to their own copy of the texture
+                m_sprite.image = image;
+            }
+        }
+
+        if (!m_sprite.image.tex) return;
+
         C2D_DrawSpriteTinted(&m_sprite, &m_imageTint);
     }
 
@@ -228,4 +286,19 @@ namespace m3d {
 
         m_imageTint = { tint, tint, tint, tint };
     }
+
+    void Sprite::updateImage(C2D_Image t_image) {
+        // images out of range of the sheet don't get drawn
+        if (!t_image.tex) {
+            m_sprite.image = t_image;
+            return;
+        }
+
+        // setting the image resets the parameters of the sprite
+        C2D_SpriteFromImage(&m_sprite, t_image);
+        C2D_SpriteSetScale(&m_sprite, m_scaleX, m_scaleY);
+        C2D_SpriteSetCenterRaw(&m_sprite, m_centerX, m_centerY);
+        C2D_SpriteSetPos(&m_sprite, m_posX, m_posY);
+        C2D_SpriteSetRotationDegrees(&m_sprite, m_rotation);
+    }
 } /* m3d */
@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <cmath>
+#include "m3d/graphics/drawables/spriteBatch.hpp"
+#include "m3d/graphics/screen.hpp"
+#include "spriteBatch_shbin.h"
+
+namespace {
+    // the indices are 16-bit, so a draw call covers at most this many quads
+    const unsigned int MaxQuadsPerDraw = 65536 / 4;
+
+    // the shader gets loaded once and shared by all batches
+    struct Program {
+        DVLB_s* dvlb;
+        shaderProgram_s shader;
+        C3D_AttrInfo attributeInfo;
+        int projectionUniform;
+
+        Program() {
+            dvlb = DVLB_ParseFile((u32*) spriteBatch_shbin, spriteBatch_shbin_size);
+            shaderProgramInit(&shader);
+            shaderProgramSetVsh(&shader, &dvlb->DVLE[0]);
+            projectionUniform = shaderInstanceGetUniformLocation(shader.vertexShader, "projection");
+
+            AttrInfo_Init(&attributeInfo);
+            AttrInfo_AddLoader(&attributeInfo, 0, GPU_FLOAT, 2);         // v0=position
+            AttrInfo_AddLoader(&attributeInfo, 1, GPU_FLOAT, 2);         // v1=texcoord
+            AttrInfo_AddLoader(&attributeInfo, 2, GPU_UNSIGNED_BYTE, 4); // v2=color
+        }
+
+        ~Program() {
+            shaderProgramFree(&shader);
+            DVLB_Free(dvlb);
+        }
+    };
+
+    Program& getProgram() {
+        static Program program;
+        return program;
+    }
+}
+
+namespace m3d {
+    SpriteBatch::SpriteBatch(unsigned int t_capacity) :
+            m_vbo(nullptr),
+            m_ibo(nullptr),
+            m_vboCapacity(0),
+            m_iboQuads(0),
+            m_drawCalls(0),
+            m_dirty(true) {
+        m_x.reserve(t_capacity);
+        m_y.reserve(t_capacity);
+        m_rotation.reserve(t_capacity);
+        m_xScale.reserve(t_capacity);
+        m_yScale.reserve(t_capacity);
+        m_tint.reserve(t_capacity);
+        m_image.reserve(t_capacity);
+    }
+
+    SpriteBatch::~SpriteBatch() {
+        if (m_vbo) linearFree(m_vbo);
+        if (m_ibo) linearFree(m_ibo);
+    }
+
+    int SpriteBatch::addImage(m3d::Texture& t_texture) {
+        if (!t_texture.getTexture()) return -1;
+
+        m_textures.push_back(t_texture);
+        return addImage(t_texture.getImage());
+    }
+
+    int SpriteBatch::addImage(m3d::SpriteSheet& t_spriteSheet, int t_index) {
+        C2D_Image image = t_spriteSheet.getImage(t_index);
+        if (!image.tex) return -1;
+
+        m_spriteSheets.push_back(t_spriteSheet);
+        return addImage(image);
+    }
+
+    int SpriteBatch::getImageCount() {
+        return m_images.size();
+    }
+
+    int SpriteBatch::add(int t_image, float t_x, float t_y) {
+        if (t_image < 0 || t_image >= getImageCount()) return -1;
+
+        m_x.push_back(t_x);
+        m_y.push_back(t_y);
+        m_rotation.push_back(0.0f);
+        m_xScale.push_back(1.0f);
+        m_yScale.push_back(1.0f);
+        m_tint.push_back(0xFFFFFFFF);
+        m_image.push_back(t_image);
+        m_dirty = true;
+
+        return m_x.size() - 1;
+    }
+
+    void SpriteBatch::remove(int t_sprite) {
+        if (!isValid(t_sprite)) return;
+
+        // the last sprite takes the place of the removed one, so the arrays stay packed
+        m_x[t_sprite] = m_x.back();
+        m_y[t_sprite] = m_y.back();
+        m_rotation[t_sprite] = m_rotation.back();
+        m_xScale[t_sprite] = m_xScale.back();
+        m_yScale[t_sprite] = m_yScale.back();
+        m_tint[t_sprite] = m_tint.back();
+        m_image[t_sprite] = m_image.back();
+
+        m_x.pop_back();
+        m_y.pop_back();
+        m_rotation.pop_back();
+        m_xScale.pop_back();
+        m_yScale.pop_back();
+        m_tint.pop_back();
+        m_image.pop_back();
+        m_dirty = true;
+    }
+
+    void SpriteBatch::clear() {
+        m_x.clear();
+        m_y.clear();
+        m_rotation.clear();
+        m_xScale.clear();
+        m_yScale.clear();
+        m_tint.clear();
+        m_image.clear();
+        m_dirty = true;
+    }
+
+    int SpriteBatch::getCount() {
+        return m_x.size();
+    }
+
+    void SpriteBatch::setPosition(int t_sprite, float t_x, float t_y) {
+        if (!isValid(t_sprite)) return;
+
+        m_x[t_sprite] = t_x;
+        m_y[t_sprite] = t_y;
+        m_dirty = true;
+    }
+
+    void SpriteBatch::move(int t_sprite, float t_offsetX, float t_offsetY) {
+        if (!isValid(t_sprite)) return;
+
+        m_x[t_sprite] += t_offsetX;
+        m_y[t_sprite] += t_offsetY;
+        m_dirty = true;
+    }
+
+    float SpriteBatch::getXPosition(int t_sprite) {
+        return isValid(t_sprite) ? m_x[t_sprite] : 0.0f;
+    }
+
+    float SpriteBatch::getYPosition(int t_sprite) {
+        return isValid(t_sprite) ? m_y[t_sprite] : 0.0f;
+    }
+
+    float* SpriteBatch::getXPositions() {
+        // the positions may get changed through the pointer
+        m_dirty = true;
+        return m_x.data();
+    }
+
+    float* SpriteBatch::getYPositions() {
+        m_dirty = true;
+        return m_y.data();
+    }
+
+    void SpriteBatch::setRotation(int t_sprite, float t_rotation, bool t_radians) {
+        if (!isValid(t_sprite)) return;
+
+        m_rotation[t_sprite] = t_radians ?
+                                t_rotation :
+                                t_rotation * (3.141592653589793238463 / 180.0);
+        m_dirty = true;
+    }
+
+    float SpriteBatch::getRotation(int t_sprite, bool t_radians) {
+        if (!isValid(t_sprite)) return 0.0f;
+
+        return t_radians ?
+                m_rotation[t_sprite] :
+                m_rotation[t_sprite] * (180.0 / 3.141592653589793238463);
+    }
+
+    void SpriteBatch::setScale(int t_sprite, float t_xScale, float t_yScale) {
+        if (!isValid(t_sprite)) return;
+
+        m_xScale[t_sprite] = t_xScale;
+        m_yScale[t_sprite] = t_yScale;
+        m_dirty = true;
+    }
+
+    void SpriteBatch::setTint(int t_sprite, m3d::Color t_color) {
+        if (!isValid(t_sprite)) return;
+
+        // the bytes are in the order of the color attribute (red first)
+        m_tint[t_sprite] = t_color.getRgba8();
+        m_dirty = true;
+    }
+
+    void SpriteBatch::setImage(int t_sprite, int t_image) {
+        if (!isValid(t_sprite) || t_image < 0 || t_image >= getImageCount()) return;
+
+        m_image[t_sprite] = t_image;
+        m_dirty = true;
+    }
+
+    int SpriteBatch::getImage(int t_sprite) {
+        return isValid(t_sprite) ? m_image[t_sprite] : -1;
+    }
+
+    unsigned int SpriteBatch::getDrawCalls() {
+        return m_drawCalls;
+    }
+
+    void SpriteBatch::draw(m3d::RenderContext t_context) {
+        if (t_context.getMode() != m3d::RenderContext::Mode::Flat || m_x.empty()) return;
+
+        // the vertices only get rewritten if the batch changed (the right eye reuses the ones of the left)
+        if (m_dirty) {
+            updateVertices();
+            m_dirty = false;
+        }
+
+        if (!m_vbo || !m_ibo) return;
+
+        // everything citro2d batched so far has to be drawn first
+        C2D_Flush();
+
+        Program& program = getProgram();
+        C3D_BindProgram(&program.shader);
+        C3D_SetAttrInfo(&program.attributeInfo);
+
+        C3D_Mtx projection;
+        Mtx_OrthoTilt(&projection, 0.0f, m3d::Screen::getScreenWidth(t_context.getScreenTarget()), m3d::Screen::getScreenHeight(), 0.0f, 1.0f, -1.0f, true);
+        C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, program.projectionUniform, &projection);
+
+        // the texture gets multiplied with the tint
+        C3D_TexEnv* env = C3D_GetTexEnv(0);
+        C3D_TexEnvInit(env);
+        C3D_TexEnvSrc(env, C3D_Both, GPU_TEXTURE0, GPU_PRIMARY_COLOR, GPU_PRIMARY_COLOR);
+        C3D_TexEnvFunc(env, C3D_Both, GPU_MODULATE);
+
+        for (int i = 1; i < 6; i++) C3D_TexEnvInit(C3D_GetTexEnv(i));
+
+        C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA);
+        C3D_CullFace(GPU_CULL_NONE);
+
+        m_drawCalls = 0;
+
+        for (size_t slot = 0; slot < m_slots.size(); slot++) {
+            unsigned int start = m_slotOffsets[slot], end = m_slotOffsets[slot + 1];
+            if (start == end) continue;
+
+            C3D_TexBind(0, m_slots[slot]);
+
+            // every texture's quads start at the beginning of the buffer info, so the same indices work for all of them
+            for (; start < end; start += MaxQuadsPerDraw) {
+                unsigned int quads = std::min(end - start, MaxQuadsPerDraw);
+
+                C3D_BufInfo* bufInfo = C3D_GetBufInfo();
+                BufInfo_Init(bufInfo);
+                BufInfo_Add(bufInfo, m_vbo + start * 4, sizeof(m3d::SpriteBatch::Vertex), 3, 0x210);
+
+                C3D_DrawElements(GPU_TRIANGLES, quads * 6, C3D_UNSIGNED_SHORT, m_ibo);
+                m_drawCalls++;
+            }
+        }
+
+        // hand the GPU back to citro2d
+        C2D_Prepare();
+        C3D_DepthTest(true, GPU_ALWAYS, GPU_WRITE_ALL);
+    }
+
+    // private methods
+    int SpriteBatch::addImage(C2D_Image t_image) {
+        m3d::SpriteBatch::Image image;
+        image.texture = t_image.tex;
+        image.width = t_image.subtex->width;
+        image.height = t_image.subtex->height;
+
+        // images of sprite sheets may be stored rotated
+        Tex3DS_SubTextureTopLeft(t_image.subtex, &image.u[0], &image.v[0]);
+        Tex3DS_SubTextureTopRight(t_image.subtex, &image.u[1], &image.v[1]);
+        Tex3DS_SubTextureBottomLeft(t_image.subtex, &image.u[2], &image.v[2]);
+        Tex3DS_SubTextureBottomRight(t_image.subtex, &image.u[3], &image.v[3]);
+
+        // images on the same texture share a slot, which gets drawn with one call
+        auto slot = std::find(m_slots.begin(), m_slots.end(), t_image.tex);
+        image.slot = slot - m_slots.begin();
+        if (slot == m_slots.end()) m_slots.push_back(t_image.tex);
+
+        m_images.push_back(image);
+        return m_images.size() - 1;
+    }
+
+    void SpriteBatch::updateVertices() {
+        unsigned int count = m_x.size();
+
+        // count the sprites of each texture, the offsets are where their quads start
+        m_slotOffsets.assign(m_slots.size() + 1, 0);
+        for (unsigned int i = 0; i < count; i++) m_slotOffsets[m_images[m_image[i]].slot + 1]++;
+        for (size_t slot = 0; slot < m_slots.size(); slot++) m_slotOffsets[slot + 1] += m_slotOffsets[slot];
+
+        unsigned int quads = 0;
+
+        for (size_t slot = 0; slot < m_slots.size(); slot++) {
+            quads = std::max(quads, std::min(m_slotOffsets[slot + 1] - m_slotOffsets[slot], MaxQuadsPerDraw));
+        }
+
+        // the buffers only grow
+        if (count * 4 > m_vboCapacity) {
+            if (m_vbo) linearFree(m_vbo);
+            m_vboCapacity = std::max(count * 4, m_vboCapacity + m_vboCapacity / 2);
+            m_vbo = static_cast<m3d::SpriteBatch::Vertex*>(linearAlloc(m_vboCapacity * sizeof(m3d::SpriteBatch::Vertex)));
+
+            if (!m_vbo) {
+                m_vboCapacity = 0;
+                return;
+            }
+        }
+
+        if (quads > m_iboQuads) {
+            if (m_ibo) linearFree(m_ibo);
+            m_ibo = static_cast<u16*>(linearAlloc(quads * 6 * sizeof(u16)));
+
+            if (!m_ibo) {
+                m_iboQuads = 0;
+                return;
+            }
+
+            // two triangles per quad (top left, top right, bottom left and bottom left, top right, bottom right)
+            for (unsigned int i = 0; i < quads; i++) {
+                u16* indices = m_ibo + i * 6, first = i * 4;
+                indices[0] = first;
+                indices[1] = first + 1;
+                indices[2] = first + 2;
+                indices[3] = first + 2;
+                indices[4] = first + 1;
+                indices[5] = first + 3;
+            }
+
+            m_iboQuads = quads;
+            GSPGPU_FlushDataCache(m_ibo, m_iboQuads * 6 * sizeof(u16));
+        }
+
+        m_slotCursors.assign(m_slotOffsets.begin(), m_slotOffsets.end() - 1);
+
+        for (unsigned int i = 0; i < count; i++) {
+            const m3d::SpriteBatch::Image& image = m_images[m_image[i]];
+            m3d::SpriteBatch::Vertex* quad = m_vbo + m_slotCursors[image.slot]++ * 4;
+
+            float halfWidth = image.width * m_xScale[i] * 0.5f,
+                  halfHeight = image.height * m_yScale[i] * 0.5f,
+                  x = m_x[i],
+                  y = m_y[i];
+
+            // the corners relative to the center: top left, top right, bottom left, bottom right
+            float cornersX[4] = { -halfWidth, halfWidth, -halfWidth, halfWidth },
+                  cornersY[4] = { -halfHeight, -halfHeight, halfHeight, halfHeight };
+
+            if (m_rotation[i] != 0.0f) {
+                float cosine = cosf(m_rotation[i]), sine = sinf(m_rotation[i]);
+
+                for (int corner = 0; corner < 4; corner++) {
+                    float cornerX = cornersX[corner];
+                    cornersX[corner] = cornerX * cosine - cornersY[corner] * sine;
+                    cornersY[corner] = cornerX * sine + cornersY[corner] * cosine;
+                }
+            }
+
+            for (int corner = 0; corner < 4; corner++) {
+                quad[corner].x = x + cornersX[corner];
+                quad[corner].y = y + cornersY[corner];
+                quad[corner].u = image.u[corner];
+                quad[corner].v = image.v[corner];
+                quad[corner].color = m_tint[i];
+            }
+        }
+
+        GSPGPU_FlushDataCache(m_vbo, count * 4 * sizeof(m3d::SpriteBatch::Vertex));
+    }
+
+    inline bool SpriteBatch::isValid(int t_sprite) {
+        return t_sprite >= 0 && t_sprite < getCount();
+    }
+} /* m3d */
@@ -0,0 +1,138 @@
+#include <cstdio>
+#include "m3d/graphics/spriteSheet.hpp"
+#include "m3d/graphics/spriteSheetCache.hpp"
+
+namespace m3d {
+    SpriteSheet::Data::Data() :
+        sheet(nullptr) { /* do nothing */ }
+
+    SpriteSheet::Data::~Data() {
+        if (sheet) C2D_SpriteSheetFree(sheet);
+    }
+
+    SpriteSheet::SpriteSheet() :
+        m_data(nullptr) { /* do nothing */ }
+
+    SpriteSheet::SpriteSheet(const std::string& t_filename, bool t_useCache) :
+            m_data(nullptr) {
+        loadFromFile(t_filename, t_useCache);
+    }
+
+    bool SpriteSheet::loadFromFile(const std::string& t_filename, bool t_useCache) {
+        if (t_useCache) {
+            std::shared_ptr<m3d::SpriteSheet::Data> data = m3d::SpriteSheetCache::get(t_filename);
+
+            if (data) {
+                m_data = data;
+                return true;
+            }
+        }
+
+        // loading always creates new data, sprite sheets sharing the old data keep it
+        std::shared_ptr<m3d::SpriteSheet::Data> data = std::make_shared<m3d::SpriteSheet::Data>();
+        data->sheet = C2D_SpriteSheetLoad(t_filename.c_str());
+
+        if (!data->sheet) {
+            m_data = nullptr;
+            return false;
+        }
+
+        data->path = t_filename;
+        m_data = data;
+
+        if (t_useCache) m3d::SpriteSheetCache::add(t_filename, m_data);
+
+        return true;
+    }
+
+    bool SpriteSheet::loadFromBuffer(const void* t_buffer, size_t t_size) {
+        std::shared_ptr<m3d::SpriteSheet::Data> data = std::make_shared<m3d::SpriteSheet::Data>();
+        data->sheet = C2D_SpriteSheetLoadFromMem(t_buffer, t_size);
+
+        m_data = (data->sheet ? data : nullptr);
+        return m_data != nullptr;
+    }
+
+    bool SpriteSheet::loadNames(const std::string& t_filename) {
+        if (!m_data) return false;
+
+        FILE* file = fopen(t_filename.c_str(), "r");
+        if (!file) return false;
+
+        char buffer[256];
+        int index = 0;
+
+        while (fgets(buffer, sizeof(buffer), file)) {
+            std::string line(buffer);
+
+            // strip the line ending and surrounding whitespace
+            size_t first = line.find_first_not_of(" \t\r\n"),
+                   last = line.find_last_not_of(" \t\r\n");
+
+            // tex3ds-options and empty lines don't describe images
+            if (first == std::string::npos || line[first] == '-') continue;
+
+            line = line.substr(first, last - first + 1);
+
+            size_t slash = line.find_last_of("/\\");
+            if (slash != std::string::npos) line = line.substr(slash + 1);
+
+            size_t dot = line.find_last_of('.');
+            if (dot != std::string::npos && dot > 0) line = line.substr(0, dot);
+
+            m_data->names[line] = index++;
+        }
+
+        fclose(file);
+        return true;
+    }
+
+    void SpriteSheet::setName(const std::string& t_name, int t_index) {
+        if (m_data) m_data->names[t_name] = t_index;
+    }
+
+    int SpriteSheet::getIndex(const std::string& t_name) {
+        if (!m_data) return -1;
+
+        auto entry = m_data->names.find(t_name);
+        return entry != m_data->names.end() ? entry->second : -1;
+    }
+
+    int SpriteSheet::getImageCount() {
+        return m_data ? C2D_SpriteSheetCount(m_data->sheet) : 0;
+    }
+
+    C2D_Image SpriteSheet::getImage(int t_index) {
+        if (t_index < 0 || t_index >= getImageCount()) return { nullptr, nullptr };
+
+        return C2D_SpriteSheetGetImage(m_data->sheet, t_index);
+    }
+
+    C2D_Image SpriteSheet::getImage(const std::string& t_name) {
+        return getImage(getIndex(t_name));
+    }
+
+    bool SpriteSheet::isLoaded() {
+        return m_data != nullptr;
+    }
+
+    std::string SpriteSheet::getPath() {
+        return m_data ? m_data->path : "";
+    }
+
+    C2D_SpriteSheet SpriteSheet::getSpriteSheet() {
+        return m_data ? m_data->sheet : nullptr;
+    }
+
+    std::shared_ptr<m3d::SpriteSheet::Data> SpriteSheet::getData() {
+        return m_data;
+    }
+
+    void SpriteSheet::setData(std::shared_ptr<m3d::SpriteSheet::Data> t_data) {
+        m_data = (t_data && t_data->sheet ? t_data : nullptr);
+    }
+
+    bool SpriteSheet::isShared() {
+        return m_data && m_data.use_count() > 1;
+    }
+} /* m3d */
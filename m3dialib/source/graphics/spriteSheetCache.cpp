@@ -0,0 +1,29 @@
+#include "m3d/graphics/spriteSheetCache.hpp"
+
+namespace m3d {
+    std::shared_ptr<m3d::SpriteSheet::Data> SpriteSheetCache::get(const std::string& t_path) {
+        return getCache().get(t_path);
+    }
+
+    void SpriteSheetCache::add(const std::string& t_path, std::shared_ptr<m3d::SpriteSheet::Data> t_data) {
+        getCache().add(t_path, t_data);
+    }
+
+    void SpriteSheetCache::remove(const std::string& t_path) {
+        getCache().remove(t_path);
+    }
+
+    void SpriteSheetCache::clear() {
+        getCache().clear();
+    }
+
+    unsigned int SpriteSheetCache::getSize() {
+        return getCache().getSize();
+    }
+
+    // private methods
+    m3d::priv::WeakCache<m3d::SpriteSheet::Data>& SpriteSheetCache::getCache() {
+        static m3d::priv::WeakCache<m3d::SpriteSheet::Data> cache;
+        return cache;
+    }
+} /* m3d */
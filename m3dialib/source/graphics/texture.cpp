@@ -1,199 +1,400 @@
 #include <cstring>
-#include <fstream>
-#include <png.h>
-#include <vector>
 #include "m3d/graphics/texture.hpp"
+#include "m3d/graphics/textureCache.hpp"
+#include "m3d/graphics/textureLoader.hpp"
+#include "m3d/private/mipmap.hpp"
+#include "m3d/private/pngReader.hpp"
+#include "m3d/private/textureFile.hpp"
+
+namespace {
+    // the memory used by all allocated textures
+    unsigned int residentMemory = 0;
+}
 
 namespace m3d {
+    Texture::Data::Data() :
+        initialized(false),
+        width(0),
+        height(0),
+        format(m3d::Texture::Format::RGBA8),
+        requestedFormat(m3d::Texture::Format::RGBA8),
+        mipmaps(false),
+        status(m3d::Texture::Status::Loaded) { /* do nothing */ }
+
+    Texture::Data::~Data() {
+        if (initialized) {
+            residentMemory -= texture.size;
+            C3D_TexDelete(&texture);
+        }
+    }
+
     Texture::Texture() :
-    m_width(0),
-    m_height(0),
-    m_path(""),
-    m_texture(nullptr) { /* do nothing */ }
+    m_magnificationFilter(m3d::Texture::Filter::Linear),
+    m_minificationFilter(m3d::Texture::Filter::Linear),
+    m_mipmapFilter(m3d::Texture::Filter::Linear),
+    m_lodBias(0.0f),
+    m_useRegion(false),
+    m_regionX(0),
+    m_regionY(0),
+    m_regionWidth(0),
+    m_regionHeight(0),
+    m_data(nullptr) {
+        updateImage();
+    }
+
+    Texture::Texture(const m3d::Texture& t_texture) :
+    m_magnificationFilter(t_texture.m_magnificationFilter),
+    m_minificationFilter(t_texture.m_minificationFilter),
+    m_mipmapFilter(t_texture.m_mipmapFilter),
+    m_lodBias(t_texture.m_lodBias),
+    m_useRegion(t_texture.m_useRegion),
+    m_regionX(t_texture.m_regionX),
+    m_regionY(t_texture.m_regionY),
+    m_regionWidth(t_texture.m_regionWidth),
+    m_regionHeight(t_texture.m_regionHeight),
+    m_data(t_texture.m_data) {
+        updateImage();
+    }
+
+    bool Texture::loadFromFile(const std::string& t_filename, m3d::Texture::Format t_format, bool t_mipmaps, bool t_useCache) {
+        if (t_useCache) {
+            std::shared_ptr<m3d::Texture::Data> data = m3d::TextureCache::get(t_filename);
+
+            // textures loaded with other options (or still loading in the background) don't match
+            if (data && data->requestedFormat == t_format && data->mipmaps == t_mipmaps && data->status == m3d::Texture::Status::Loaded) {
+                setData(data);
+
+                // the data is shared, but the sampling settings are the ones of this texture
+                applyFilters();
+                return true;
+            }
+        }
+
+        FILE* file = fopen(t_filename.c_str(), "rb");
+        if (!file) return false;
+
+        // binary files start with the magic
+        m3d::priv::textureFile::Header header;
+        bool success;
+
+        if (fread(&header, 1, sizeof(header), file) == sizeof(header) && memcmp(header.magic, m3d::priv::textureFile::magic, sizeof(header.magic)) == 0) {
+            // the texels get read straight into the texture
+            success = createTexture(header, t_mipmaps) &&
+                      fseek(file, header.dataOffset, SEEK_SET) == 0 &&
+                      fread(m_image.tex->data, 1, header.dataSize, file) == header.dataSize;
+
+            if (success) {
+                finishTexture(getMipmapLevels() > header.levels);
+            } else {
+                destroyTexture();
+            }
+        } else {
+            rewind(file);
+
+            m3d::priv::image::PngReader reader;
+            success = reader.open(file) && loadPng(reader, t_format, t_mipmaps);
+        }
+
+        fclose(file);
+
+        if (success) {
+            m_data->path = t_filename;
+            m_data->requestedFormat = t_format;
+            m_data->mipmaps = t_mipmaps;
+
+            if (t_useCache) m3d::TextureCache::add(t_filename, m_data);
+        }
 
-    Texture::Texture(m3d::Texture& t_texture) {
-        operator=(t_texture);
+        return success;
     }
 
-    Texture::~Texture() {
-        if (m_texture != nullptr) {
-            unloadImage(m_image);
+    bool Texture::loadFromBuffer(const void* t_buffer, m3d::Texture::Format t_format, bool t_mipmaps) {
+        if (t_buffer && memcmp(t_buffer, m3d::priv::textureFile::magic, sizeof(m3d::priv::textureFile::magic)) == 0) {
+            m3d::priv::textureFile::Header header;
+            memcpy(&header, t_buffer, sizeof(header));
+
+            if (!createTexture(header, t_mipmaps)) return false;
+
+            memcpy(m_image.tex->data, static_cast<const u8*>(t_buffer) + header.dataOffset, header.dataSize);
+            finishTexture(getMipmapLevels() > header.levels);
+            return true;
+        }
+
+        m3d::priv::image::PngReader reader;
+        return reader.open(t_buffer) && loadPng(reader, t_format, t_mipmaps);
+    }
+
+    bool Texture::loadFromFileAsync(const std::string& t_filename, m3d::Texture::Format t_format, bool t_mipmaps, bool t_useCache) {
+        if (t_useCache) {
+            std::shared_ptr<m3d::Texture::Data> data = m3d::TextureCache::get(t_filename);
+
+            // textures still loading get shared as well, the file only gets decoded once
+            if (data && data->requestedFormat == t_format && data->mipmaps == t_mipmaps && data->status != m3d::Texture::Status::Failed) {
+                setData(data);
+                applyFilters();
+                return true;
+            }
         }
+
+        // the placeholder is the smallest texture possible, with a size of 0 so sprites don't show it
+        if (!createTexture(0, 0, 8, 8, m3d::Texture::Format::RGBA8, 1)) return false;
+
+        // colors are stored as ABGR, texels as RGBA
+        u32 color = __builtin_bswap32(m3d::TextureLoader::getPlaceholderColor().getRgba8());
+        u32* texels = static_cast<u32*>(m_image.tex->data);
+
+        for (int i = 0; i < 8 * 8; i++) texels[i] = color;
+
+        finishTexture(false);
+
+        m_data->path = t_filename;
+        m_data->requestedFormat = t_format;
+        m_data->mipmaps = t_mipmaps;
+        m_data->status = m3d::Texture::Status::Loading;
+
+        if (t_useCache) m3d::TextureCache::add(t_filename, m_data);
+
+        m3d::TextureLoader::enqueue(*this);
+        return true;
+    }
+
+    m3d::Texture::Status Texture::getStatus() {
+        return m_data ? m_data->status : m3d::Texture::Status::Empty;
     }
 
-    bool Texture::loadFromFile(const std::string& t_filename) {
-        FILE* fp = fopen(t_filename.c_str(), "rb");
-        return loadPng(fp);
+    m3d::Texture Texture::getRegion(int t_x, int t_y, int t_width, int t_height) {
+        m3d::Texture region(*this);
+
+        // regions of regions are relative to the region
+        region.m_regionX = (m_useRegion ? m_regionX : 0) + t_x;
+        region.m_regionY = (m_useRegion ? m_regionY : 0) + t_y;
+        region.m_regionWidth = t_width;
+        region.m_regionHeight = t_height;
+        region.m_useRegion = true;
+        region.updateImage();
+
+        return region;
     }
 
-    bool Texture::loadFromBuffer(const void* t_buffer) {
-        return loadPng(t_buffer, true);
+    bool Texture::isRegion() {
+        return m_useRegion;
     }
 
     int Texture::getWidth() {
-        return m_width;
+        if (m_useRegion) return m_data ? m_regionWidth : 0;
+        return m_data ? m_data->width : 0;
     }
 
     int Texture::getHeight() {
-        return m_height;
+        if (m_useRegion) return m_data ? m_regionHeight : 0;
+        return m_data ? m_data->height : 0;
     }
 
     int Texture::getCalculatedWidth() {
-        return getNextPow2(m_width);
+        return getNextPow2(getWidth());
     }
 
     int Texture::getCalculatedHeight() {
-        return getNextPow2(m_height);
+        return getNextPow2(getHeight());
+    }
+
+    m3d::Texture::Format Texture::getFormat() {
+        return static_cast<m3d::Texture::Format>(m_image.tex ? m_image.tex->fmt : GPU_RGBA8);
+    }
+
+    int Texture::getMipmapLevels() {
+        return m_image.tex ? m_image.tex->maxLevel + 1 : 0;
+    }
+
+    void Texture::setFilter(m3d::Texture::Filter t_magnification, m3d::Texture::Filter t_minification) {
+        m_magnificationFilter = t_magnification;
+        m_minificationFilter = t_minification;
+        applyFilters();
+    }
+
+    void Texture::setMipmapFilter(m3d::Texture::Filter t_filter) {
+        m_mipmapFilter = t_filter;
+        applyFilters();
+    }
+
+    void Texture::setLodBias(float t_bias) {
+        m_lodBias = t_bias;
+        applyFilters();
     }
 
     std::string Texture::getPath() {
-        return m_path;
+        return m_data ? m_data->path : "";
     }
 
     C3D_Tex* Texture::getTexture() {
-        return m_texture;
+        return m_data ? &m_data->texture : nullptr;
+    }
+
+    std::shared_ptr<m3d::Texture::Data> Texture::getData() {
+        return m_data;
+    }
+
+    void Texture::setData(std::shared_ptr<m3d::Texture::Data> t_data) {
+        m_data = (t_data && t_data->initialized ? t_data : nullptr);
+        m_useRegion = false;
+        updateImage();
+    }
+
+    bool Texture::isShared() {
+        return m_data && m_data.use_count() > 1;
+    }
+
+    unsigned int Texture::getMemoryUsage() {
+        return m_data ? m_data->texture.size : 0;
+    }
+
+    unsigned int Texture::getResidentMemory() {
+        return residentMemory;
     }
 
     Tex3DS_SubTexture& Texture::getSubtexture() {
+        updateImage();
         return m_subtexture;
     }
 
-   C2D_Image& Texture::getImage() {
-       return m_image;
-   }
+    C2D_Image& Texture::getImage() {
+        // data loaded in the background changes its size once it's loaded
+        updateImage();
+        return m_image;
+    }
 
-    m3d::Texture& Texture::operator=(m3d::Texture& rhs) {
+    m3d::Texture& Texture::operator=(const m3d::Texture& rhs) {
         if(this == &rhs) return *this;
 
-        m_width = rhs.getWidth();
-        m_height = rhs.getHeight();
-        m_path = rhs.getPath();
-
-        if (m_texture) C3D_TexDelete(m_texture);
+        m_magnificationFilter = rhs.m_magnificationFilter;
+        m_minificationFilter = rhs.m_minificationFilter;
+        m_mipmapFilter = rhs.m_mipmapFilter;
+        m_lodBias = rhs.m_lodBias;
+        m_useRegion = rhs.m_useRegion;
+        m_regionX = rhs.m_regionX;
+        m_regionY = rhs.m_regionY;
+        m_regionWidth = rhs.m_regionWidth;
+        m_regionHeight = rhs.m_regionHeight;
 
-        if (rhs.getTexture() != nullptr) {
-            m_texture = static_cast<C3D_Tex*>(malloc(sizeof(C3D_Tex)));
-            C3D_TexInit(m_texture, getNextPow2(rhs.getTexture()->width), getNextPow2(rhs.getTexture()->height), GPU_RGBA8);
-            memcpy(m_texture, rhs.getTexture(), sizeof(C3D_Tex));
-        }
+        // the data gets shared (and freed once the last texture using it is gone)
+        m_data = rhs.m_data;
+        updateImage();
 
         return *this;
     }
 
     // private methods
-    bool Texture::loadPng(const void* t_fp, bool t_buffer) {
-        png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    bool Texture::loadPng(m3d::priv::image::PngReader& t_reader, m3d::Texture::Format t_format, bool t_mipmaps) {
+        // encoding ETC1 is too slow for loading, .png-files have to be converted beforehand
+        if (m3d::priv::texel::isCompressed(static_cast<u8>(t_format))) return false;
 
-        png_infop info = png_create_info_struct(png);
+        u32 textureWidth = getNextPow2(t_reader.getWidth()),
+            textureHeight = getNextPow2(t_reader.getHeight());
 
-        if(setjmp(png_jmpbuf(png)))
-        {
-            png_destroy_read_struct(&png, &info, NULL);
-            return false;
-        }
+        u32 levels = (t_mipmaps ? m3d::priv::mipmap::getLevelCount(textureWidth, textureHeight) : 1);
 
-        if (t_buffer) {
-            png_set_read_fn(png, (png_voidp) t_fp,
-                            [](png_structp ptr, png_bytep data, png_size_t len) {
-                                unsigned int* addr = (unsigned int*) png_get_io_ptr(ptr);
-                                memcpy(data, (void*) *addr, len);
-                                *addr += len;
-                            });
-        } else {
-            png_set_read_fn(png, (png_voidp) t_fp,
-                            [](png_structp ptr, png_bytep data, png_size_t len) {
-                                fread(data, 1, len, (FILE*) png_get_io_ptr(ptr));
-                            });
-        }
+        if (!createTexture(t_reader.getWidth(), t_reader.getHeight(), textureWidth, textureHeight, t_format, levels)) return false;
 
-        png_read_info(png, info);
+        // only the padding around the image doesn't get overwritten (the mipmaps get generated from the first level)
+        if (t_reader.getWidth() != textureWidth || t_reader.getHeight() != textureHeight) memset(m_image.tex->data, 0, m_image.tex->size);
 
-        m_width = png_get_image_width(png, info);
-        m_height = png_get_image_height(png, info);
+        // the rows get decoded (and converted) straight into the tiles of the texture
+        if (!t_reader.readTiled(m_image.tex->data, textureWidth, static_cast<m3d::priv::texel::Format>(t_format))) {
+            destroyTexture();
+            return false;
+        }
 
-        png_byte color_type = png_get_color_type(png, info);
-        png_byte bit_depth  = png_get_bit_depth(png, info);
+        finishTexture(levels > 1);
+        return true;
+    }
 
-        // Read any color_type into 8bit depth, ABGR format.
-        // See http://www.libpng.org/pub/png/libpng-manual.txt
+    bool Texture::createTexture(int t_width, int t_height, u32 t_textureWidth, u32 t_textureHeight, m3d::Texture::Format t_format, u32 t_levels) {
+        // loading always creates new data, textures sharing the old data keep it (it gets freed if nothing uses it anymore)
+        destroyTexture();
 
-        if(bit_depth == 16)
-            png_set_strip_16(png);
+        m_data = std::make_shared<m3d::Texture::Data>();
 
-        if(color_type == PNG_COLOR_TYPE_PALETTE)
-            png_set_palette_to_rgb(png);
+        if (!allocateTexture(t_width, t_height, t_textureWidth, t_textureHeight, t_format, t_levels)) {
+            destroyTexture();
+            return false;
+        }
 
-        // PNG_COLOR_TYPE_GRAY_ALPHA is always 8 or 16bit depth.
-        if(color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
-            png_set_expand_gray_1_2_4_to_8(png);
+        return true;
+    }
 
-        if(png_get_valid(png, info, PNG_INFO_tRNS))
-            png_set_tRNS_to_alpha(png);
+    bool Texture::createTexture(const m3d::priv::textureFile::Header& t_header, bool t_mipmaps) {
+        if (!m3d::priv::textureFile::isValid(t_header)) return false;
 
-        // if color_type doesn't have an alpha channel, fill it with 0xff.
-        if(color_type == PNG_COLOR_TYPE_RGB ||
-           color_type == PNG_COLOR_TYPE_GRAY ||
-           color_type == PNG_COLOR_TYPE_PALETTE)
-            png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
+        // textures converted without mipmaps get them generated after loading (unless they are compressed)
+        u32 levels = (t_mipmaps && t_header.levels == 1 && !m3d::priv::texel::isCompressed(t_header.format) ? m3d::priv::mipmap::getLevelCount(t_header.textureWidth, t_header.textureHeight) : t_header.levels);
 
-        if(color_type == PNG_COLOR_TYPE_GRAY ||
-           color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
-            png_set_gray_to_rgb(png);
+        return createTexture(t_header.width, t_header.height, t_header.textureWidth, t_header.textureHeight, static_cast<m3d::Texture::Format>(t_header.format), levels);
+    }
 
-        // output ABGR
-        png_set_bgr(png);
-        png_set_swap_alpha(png);
+    bool Texture::allocateTexture(int t_width, int t_height, u32 t_textureWidth, u32 t_textureHeight, m3d::Texture::Format t_format, u32 t_levels) {
+        C3D_Tex texture;
+        C3D_TexInitParams params = { static_cast<u16>(t_textureWidth), static_cast<u16>(t_textureHeight), static_cast<u8>(t_levels - 1), static_cast<GPU_TEXCOLOR>(t_format), GPU_TEX_2D, false };
 
-        png_read_update_info(png, info);
+        if (!C3D_TexInitWithParams(&texture, nullptr, params)) return false;
 
-        png_bytep* row_pointers = static_cast<png_byte**>(malloc(sizeof(png_bytep) * m_height));
-        for(int y = 0; y < m_height; y++) {
-            row_pointers[y] = (png_byte*)malloc(png_get_rowbytes(png,info));
+        // the texture gets replaced in place, so all textures sharing the data use the new one
+        if (m_data->initialized) {
+            residentMemory -= m_data->texture.size;
+            C3D_TexDelete(&m_data->texture);
         }
 
-        png_read_image(png, row_pointers);
-
-        if (!t_buffer) fclose((FILE*) t_fp);
-        png_destroy_read_struct(&png, &info, NULL);
-
-        unloadImage(m_image);
-
-        m_texture = static_cast<C3D_Tex*>(malloc(sizeof(C3D_Tex)));
-        m_image.tex = m_texture;
-        m_subtexture.width = m_width;
-        m_subtexture.height = m_height;
-        m_subtexture.left = 0.0f;
-        m_subtexture.top = 1.0f;
-        m_subtexture.right = m_width / (float) getNextPow2(m_width);
-        m_subtexture.bottom = 1.0 - (m_height / (float) getNextPow2(m_height));
-        m_image.subtex = &m_subtexture;
+        m_data->texture = texture;
+        m_data->initialized = true;
+        m_data->width = t_width;
+        m_data->height = t_height;
+        m_data->format = t_format;
+        residentMemory += texture.size;
 
-        C3D_TexInit(m_image.tex, getNextPow2(m_width), getNextPow2(m_height), GPU_RGBA8);
+        updateImage();
+        return true;
+    }
 
-        memset(m_image.tex->data, 0, m_image.tex->size);
+    void Texture::finishTexture(bool t_generateMipmaps) {
+        // the levels get box-filtered one after another, straight in the tiled layout
+        if (t_generateMipmaps) m3d::priv::mipmap::generateTiled(m_image.tex->data, m_image.tex->width, m_image.tex->height, m_image.tex->fmt, m_image.tex->maxLevel + 1);
 
-        for(int j = 0; j < m_height; j++) {
-            png_bytep row = row_pointers[j];
-            for(int i = 0; i < m_width; i++) {
-                png_bytep px = &(row[i * 4]);
-                u32 dst = ((((j >> 3) * (getNextPow2(m_height) >> 3) + (i >> 3)) << 6) + ((i & 1) | ((j & 1) << 1) | ((i & 2) << 1) | ((j & 2) << 2) | ((i & 4) << 2) | ((j & 4) << 3))) * 4;
+        C3D_TexFlush(m_image.tex);
+        applyFilters();
+    }
 
-                memcpy(static_cast<char*>(m_image.tex->data) + dst, px, sizeof(u32));
-            }
-        }
+    void Texture::applyFilters() {
+        if (!m_image.tex) return;
 
-        // C3D_TexSetFilter(m_texture, GPU_LINEAR, GPU_LINEAR);
         C3D_TexSetWrap(m_image.tex, GPU_CLAMP_TO_BORDER, GPU_CLAMP_TO_BORDER);
         m_image.tex->border = 0xFFFFFFFF;
 
-        return true;
+        C3D_TexSetFilter(m_image.tex, static_cast<GPU_TEXTURE_FILTER_PARAM>(m_magnificationFilter), static_cast<GPU_TEXTURE_FILTER_PARAM>(m_minificationFilter));
+        C3D_TexSetFilterMipmap(m_image.tex, static_cast<GPU_TEXTURE_FILTER_PARAM>(m_mipmapFilter));
+        C3D_TexSetLodBias(m_image.tex, m_lodBias);
     }
 
-    inline void Texture::unloadImage(C2D_Image t_image) {
-        if (t_image.tex) C3D_TexDelete(t_image.tex);
+    void Texture::destroyTexture() {
+        m_data = nullptr;
+        m_useRegion = false;
+        updateImage();
+    }
+
+    void Texture::updateImage() {
+        m_image.tex = getTexture();
+        m_image.subtex = &m_subtexture;
+
+        // the image only covers part of the texture if its size isn't a power of 2 (or it's a region)
+        float x = (m_useRegion ? m_regionX : 0), y = (m_useRegion ? m_regionY : 0);
+
+        m_subtexture.width = getWidth();
+        m_subtexture.height = getHeight();
+        m_subtexture.left = (m_image.tex ? x / m_image.tex->width : 0.0f);
+        m_subtexture.top = (m_image.tex ? 1.0 - (y / m_image.tex->height) : 1.0f);
+        m_subtexture.right = (m_image.tex ? (x + getWidth()) / (float) m_image.tex->width : 0.0f);
+        m_subtexture.bottom = (m_image.tex ? 1.0 - ((y + getHeight()) / (float) m_image.tex->height) : 1.0f);
     }
 
-    inline u32 Texture::getNextPow2(u32 v) {
+    u32 Texture::getNextPow2(u32 v) {
         v--;
         v |= v >> 1;
         v |= v >> 2;
@@ -0,0 +1,155 @@
+#include <cstring>
+#include "m3d/graphics/textureAtlas.hpp"
+#include "m3d/private/pngReader.hpp"
+#include "m3d/private/tiling.hpp"
+
+namespace {
+    // repeats the outermost pixels of the image at (t_x, t_y) into the t_padding pixels around it
+    template <typename T>
+    void extrude(T* t_texels, uint32_t t_textureWidth, uint32_t t_x, uint32_t t_y, uint32_t t_width, uint32_t t_height, uint32_t t_padding) {
+        auto at = [&](uint32_t t_column, uint32_t t_row) -> T& {
+            return t_texels[m3d::priv::tiling::getRowOffset(t_row, t_textureWidth) + m3d::priv::tiling::getColumnOffset(t_column)];
+        };
+
+        for (uint32_t y = t_y; y < t_y + t_height; y++) {
+            for (uint32_t i = 1; i <= t_padding; i++) {
+                at(t_x - i, y) = at(t_x, y);
+                at(t_x + t_width - 1 + i, y) = at(t_x + t_width - 1, y);
+            }
+        }
+
+        // the rows include the columns extruded above, which fills the corners
+        for (uint32_t x = t_x - t_padding; x < t_x + t_width + t_padding; x++) {
+            for (uint32_t i = 1; i <= t_padding; i++) {
+                at(x, t_y - i) = at(x, t_y);
+                at(x, t_y + t_height - 1 + i) = at(x, t_y + t_height - 1);
+            }
+        }
+    }
+}
+
+namespace m3d {
+    TextureAtlas::TextureAtlas(int t_size, m3d::Texture::Format t_format, int t_padding) :
+            m_size(t_size < 1024 ? m3d::Texture::getNextPow2(t_size < 1 ? 1 : t_size) : 1024),
+            m_padding(t_padding < 0 ? 0 : t_padding),
+            m_format(t_format) { /* do nothing */ }
+
+    bool TextureAtlas::add(const std::string& t_name, const std::string& t_filename) {
+        FILE* file = fopen(t_filename.c_str(), "rb");
+        if (!file) return false;
+
+        m3d::priv::image::PngReader reader;
+        bool success = reader.open(file) && add(t_name, reader);
+
+        fclose(file);
+        return success;
+    }
+
+    bool TextureAtlas::addFromBuffer(const std::string& t_name, const void* t_buffer) {
+        m3d::priv::image::PngReader reader;
+        return reader.open(t_buffer) && add(t_name, reader);
+    }
+
+    m3d::Texture TextureAtlas::get(const std::string& t_name) {
+        auto image = m_images.find(t_name);
+        return image != m_images.end() ? image->second : m3d::Texture();
+    }
+
+    bool TextureAtlas::contains(const std::string& t_name) {
+        return m_images.find(t_name) != m_images.end();
+    }
+
+    int TextureAtlas::getCount() {
+        return m_images.size();
+    }
+
+    int TextureAtlas::getPageCount() {
+        return m_pages.size();
+    }
+
+    m3d::Texture TextureAtlas::getPage(int t_index) {
+        return t_index >= 0 && t_index < getPageCount() ? m_pages[t_index].texture : m3d::Texture();
+    }
+
+    float TextureAtlas::getOccupancy() {
+        if (m_pages.empty()) return 0.0f;
+
+        float occupancy = 0.0f;
+        for (auto& page : m_pages) occupancy += page.packer.getOccupancy();
+
+        return occupancy / m_pages.size();
+    }
+
+    unsigned int TextureAtlas::getMemoryUsage() {
+        unsigned int size = 0;
+        for (auto& page : m_pages) size += page.texture.getMemoryUsage();
+
+        return size;
+    }
+
+    int TextureAtlas::getSize() {
+        return m_size;
+    }
+
+    m3d::Texture::Format TextureAtlas::getFormat() {
+        return m_format;
+    }
+
+    void TextureAtlas::clear() {
+        m_images.clear();
+        m_pages.clear();
+    }
+
+    // private methods
+    bool TextureAtlas::add(const std::string& t_name, m3d::priv::image::PngReader& t_reader) {
+        u32 bits = m3d::priv::texel::getBitsPerTexel(static_cast<u8>(m_format)),
+            width = t_reader.getWidth(),
+            height = t_reader.getHeight(),
+            padding = m_padding;
+
+        // the pages get written texel by texel, which the compressed formats don't allow
+        if ((bits != 32 && bits != 16) || width + 2 * padding > (u32) m_size || height + 2 * padding > (u32) m_size) return false;
+
+        // the image goes into the first page it fits into, a new page only gets allocated if none has space left
+        u32 x, y;
+        size_t index = 0;
+
+        while (index < m_pages.size() && !m_pages[index].packer.insert(width + 2 * padding, height + 2 * padding, x, y)) index++;
+
+        if (index == m_pages.size() && (!addPage() || !m_pages[index].packer.insert(width + 2 * padding, height + 2 * padding, x, y))) return false;
+
+        m3d::Texture& page = m_pages[index].texture;
+        x += padding;
+        y += padding;
+
+        // the image gets decoded straight into its place in the tiled page (its space stays unused if decoding fails)
+        if (!t_reader.readTiled(page.getTexture()->data, m_size, static_cast<m3d::priv::texel::Format>(m_format), x, y)) return false;
+
+        if (padding > 0) {
+            if (bits == 32) {
+                extrude(static_cast<u32*>(page.getTexture()->data), m_size, x, y, width, height, padding);
+            } else {
+                extrude(static_cast<u16*>(page.getTexture()->data), m_size, x, y, width, height, padding);
+            }
+        }
+
+        // the rest of the page isn't used by any region yet, so this doesn't affect draws in flight
+        C3D_TexFlush(page.getTexture());
+
+        m_images[t_name] = page.getRegion(x, y, width, height);
+        return true;
+    }
+
+    bool TextureAtlas::addPage() {
+        m3d::TextureAtlas::Page page = { m3d::Texture(), m3d::priv::skyline::Packer(m_size, m_size) };
+
+        if (!page.texture.createTexture(m_size, m_size, m_size, m_size, m_format, 1)) return false;
+
+        // the space between the images stays transparent
+        memset(page.texture.getTexture()->data, 0, page.texture.getTexture()->size);
+        page.texture.finishTexture(false);
+
+        m_pages.push_back(page);
+        return true;
+    }
+} /* m3d */
@@ -0,0 +1,35 @@
+#include "m3d/graphics/textureCache.hpp"
+
+namespace m3d {
+    std::shared_ptr<m3d::Texture::Data> TextureCache::get(const std::string& t_path) {
+        return getCache().get(t_path);
+    }
+
+    void TextureCache::add(const std::string& t_path, std::shared_ptr<m3d::Texture::Data> t_data) {
+        getCache().add(t_path, t_data);
+    }
+
+    void TextureCache::remove(const std::string& t_path) {
+        getCache().remove(t_path);
+    }
+
+    void TextureCache::clear() {
+        getCache().clear();
+    }
+
+    unsigned int TextureCache::getSize() {
+        return getCache().getSize();
+    }
+
+    unsigned int TextureCache::getMemoryUsage() {
+        unsigned int size = 0;
+        getCache().forEach([&size](m3d::Texture::Data& t_data) { size += t_data.texture.size; });
+        return size;
+    }
+
+    // private methods
+    m3d::priv::WeakCache<m3d::Texture::Data>& TextureCache::getCache() {
+        static m3d::priv::WeakCache<m3d::Texture::Data> cache;
+        return cache;
+    }
+} /* m3d */
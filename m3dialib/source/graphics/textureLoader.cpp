@@ -0,0 +1,244 @@
+#include <cstdlib>
+#include <cstring>
+#include "m3d/core/lock.hpp"
+#include "m3d/graphics/textureLoader.hpp"
+#include "m3d/private/mipmap.hpp"
+#include "m3d/private/pngReader.hpp"
+#include "m3d/private/textureFile.hpp"
+
+namespace m3d {
+    TextureLoader::State::State() :
+            working(false),
+            pending(0),
+            uploadBudget(1024 * 1024),
+            placeholderColor(m3d::Color(128, 128, 128)) {
+        // libpng needs more than the default stack
+        thread.initialize(&m3d::TextureLoader::work, nullptr, false, false, 32 * 1024);
+    }
+
+    unsigned int TextureLoader::publish() {
+        return publish(getState().uploadBudget);
+    }
+
+    void TextureLoader::wait() {
+        m3d::TextureLoader::State& state = getState();
+
+        while (true) {
+            {
+                m3d::Lock lock(state.mutex);
+                if (!state.working) return;
+            }
+
+            m3d::Thread::sleep(1);
+        }
+    }
+
+    unsigned int TextureLoader::getPendingCount() {
+        return getState().pending;
+    }
+
+    void TextureLoader::setUploadBudget(unsigned int t_bytes) {
+        getState().uploadBudget = t_bytes;
+    }
+
+    unsigned int TextureLoader::getUploadBudget() {
+        return getState().uploadBudget;
+    }
+
+    void TextureLoader::setPlaceholderColor(m3d::Color t_color) {
+        getState().placeholderColor = t_color;
+    }
+
+    m3d::Color TextureLoader::getPlaceholderColor() {
+        return getState().placeholderColor;
+    }
+
+    // private methods
+    void TextureLoader::enqueue(m3d::Texture& t_texture) {
+        m3d::TextureLoader::State& state = getState();
+        m3d::TextureLoader::Job* job = new m3d::TextureLoader::Job();
+
+        job->data = t_texture.m_data;
+        job->magnificationFilter = t_texture.m_magnificationFilter;
+        job->minificationFilter = t_texture.m_minificationFilter;
+        job->mipmapFilter = t_texture.m_mipmapFilter;
+        job->lodBias = t_texture.m_lodBias;
+        job->path = t_texture.m_data->path;
+        job->format = t_texture.m_data->requestedFormat;
+        job->mipmaps = t_texture.m_data->mipmaps;
+        job->success = false;
+        job->texels = nullptr;
+        job->size = 0;
+
+        state.pending++;
+        bool start;
+
+        {
+            m3d::Lock lock(state.mutex);
+            state.queued.push_back(job);
+
+            // the worker exits once the queue is empty
+            start = !state.working;
+            state.working = true;
+        }
+
+        if (start) {
+            // the previous worker (if any) already left its loop but may not have returned yet, in which case start() would do nothing
+            state.thread.join();
+            state.thread.start();
+        }
+    }
+
+    unsigned int TextureLoader::publish(unsigned int t_budget) {
+        m3d::TextureLoader::State& state = getState();
+        std::vector<m3d::TextureLoader::Job*> jobs;
+
+        {
+            m3d::Lock lock(state.mutex);
+            unsigned int bytes = 0;
+            auto it = state.decoded.begin();
+
+            for (; it != state.decoded.end() && (t_budget == 0 || it == state.decoded.begin() || bytes + (*it)->size <= t_budget); it++) {
+                bytes += (*it)->size;
+                jobs.push_back(*it);
+            }
+
+            state.decoded.erase(state.decoded.begin(), it);
+        }
+
+        unsigned int published = 0;
+
+        for (auto job : jobs) {
+            // nothing uses the data anymore, the placeholder gets freed with the job
+            if (job->data.use_count() > 1) {
+                m3d::Texture texture;
+                texture.m_data = job->data;
+                texture.m_magnificationFilter = job->magnificationFilter;
+                texture.m_minificationFilter = job->minificationFilter;
+                texture.m_mipmapFilter = job->mipmapFilter;
+                texture.m_lodBias = job->lodBias;
+
+                // the placeholder gets replaced in place, which all textures sharing the data see
+                if (job->success && texture.allocateTexture(job->width, job->height, job->textureWidth, job->textureHeight, static_cast<m3d::Texture::Format>(job->textureFormat), job->levels)) {
+                    memcpy(texture.m_image.tex->data, job->texels, job->size);
+                    texture.finishTexture(false);
+
+                    job->data->status = m3d::Texture::Status::Loaded;
+                    published++;
+                } else {
+                    job->data->status = m3d::Texture::Status::Failed;
+                }
+            }
+
+            free(job->texels);
+            delete job;
+            state.pending--;
+        }
+
+        return published;
+    }
+
+    void TextureLoader::work(m3d::Parameter) {
+        m3d::TextureLoader::State& state = getState();
+
+        while (true) {
+            m3d::TextureLoader::Job* job;
+
+            {
+                m3d::Lock lock(state.mutex);
+
+                if (state.queued.empty()) {
+                    state.working = false;
+                    return;
+                }
+
+                job = state.queued.front();
+                state.queued.pop_front();
+            }
+
+            decode(*job);
+
+            {
+                m3d::Lock lock(state.mutex);
+                state.decoded.push_back(job);
+            }
+        }
+    }
+
+    void TextureLoader::decode(m3d::TextureLoader::Job& t_job) {
+        FILE* file = fopen(t_job.path.c_str(), "rb");
+        if (!file) return;
+
+        t_job.success = decodeFile(t_job, file);
+        fclose(file);
+
+        if (!t_job.success) {
+            free(t_job.texels);
+            t_job.texels = nullptr;
+            t_job.size = 0;
+        }
+    }
+
+    bool TextureLoader::decodeFile(m3d::TextureLoader::Job& t_job, FILE* t_file) {
+        // binary files start with the magic
+        m3d::priv::textureFile::Header header;
+        bool generateMipmaps;
+
+        if (fread(&header, 1, sizeof(header), t_file) == sizeof(header) && memcmp(header.magic, m3d::priv::textureFile::magic, sizeof(header.magic)) == 0) {
+            if (!m3d::priv::textureFile::isValid(header)) return false;
+
+            t_job.width = header.width;
+            t_job.height = header.height;
+            t_job.textureWidth = header.textureWidth;
+            t_job.textureHeight = header.textureHeight;
+            t_job.textureFormat = header.format;
+
+            // textures converted without mipmaps get them generated after loading (unless they are compressed)
+            generateMipmaps = t_job.mipmaps && header.levels == 1 && !m3d::priv::texel::isCompressed(header.format);
+            t_job.levels = (generateMipmaps ? m3d::priv::mipmap::getLevelCount(header.textureWidth, header.textureHeight) : header.levels);
+            t_job.size = m3d::priv::mipmap::getTotalSize(header.textureWidth, header.textureHeight, t_job.levels, m3d::priv::texel::getBitsPerTexel(header.format));
+            t_job.texels = static_cast<u8*>(malloc(t_job.size));
+
+            if (!t_job.texels ||
+                fseek(t_file, header.dataOffset, SEEK_SET) != 0 ||
+                fread(t_job.texels, 1, header.dataSize, t_file) != header.dataSize) {
+                return false;
+            }
+        } else {
+            // encoding ETC1 is too slow for loading, .png-files have to be converted beforehand
+            if (m3d::priv::texel::isCompressed(static_cast<u8>(t_job.format))) return false;
+
+            rewind(t_file);
+
+            m3d::priv::image::PngReader reader;
+            if (!reader.open(t_file)) return false;
+
+            t_job.width = reader.getWidth();
+            t_job.height = reader.getHeight();
+            t_job.textureWidth = m3d::Texture::getNextPow2(reader.getWidth());
+            t_job.textureHeight = m3d::Texture::getNextPow2(reader.getHeight());
+            t_job.textureFormat = static_cast<u8>(t_job.format);
+
+            generateMipmaps = t_job.mipmaps;
+            t_job.levels = (generateMipmaps ? m3d::priv::mipmap::getLevelCount(t_job.textureWidth, t_job.textureHeight) : 1);
+            t_job.size = m3d::priv::mipmap::getTotalSize(t_job.textureWidth, t_job.textureHeight, t_job.levels, m3d::priv::texel::getBitsPerTexel(t_job.textureFormat));
+            t_job.texels = static_cast<u8*>(malloc(t_job.size));
+            if (!t_job.texels) return false;
+
+            // only the padding around the image doesn't get overwritten (the mipmaps get generated from the first level)
+            if (reader.getWidth() != t_job.textureWidth || reader.getHeight() != t_job.textureHeight) memset(t_job.texels, 0, t_job.size);
+
+            if (!reader.readTiled(t_job.texels, t_job.textureWidth, static_cast<m3d::priv::texel::Format>(t_job.textureFormat))) return false;
+        }
+
+        // the mipmaps get generated here as well, so the main thread only has to copy the texels
+        if (generateMipmaps) m3d::priv::mipmap::generateTiled(t_job.texels, t_job.textureWidth, t_job.textureHeight, t_job.textureFormat, t_job.levels);
+
+        return true;
+    }
+
+    m3d::TextureLoader::State& TextureLoader::getState() {
+        static m3d::TextureLoader::State state;
+        return state;
+    }
+} /* m3d */
@@ -0,0 +1,122 @@
+#include "m3d/private/mipmap.hpp"
+#include "m3d/private/texelFormat.hpp"
+#include "m3d/private/tiling.hpp"
+
+namespace {
+    // the channels of each format split into two groups, with at least two bits between the channels of a group
+    struct ChannelMasks {
+        uint32_t masks[2];
+    };
+
+    bool getChannelMasks(uint8_t t_format, ChannelMasks& t_masks) {
+        switch (t_format) {
+            case m3d::priv::texel::RGBA8:
+                t_masks = { { 0xFF00FF00, 0x00FF00FF } };
+                return true;
+            case m3d::priv::texel::RGBA5551:
+                t_masks = { { 0xF83E, 0x07C1 } };
+                return true;
+            case m3d::priv::texel::RGB565:
+                t_masks = { { 0xF81F, 0x07E0 } };
+                return true;
+            case m3d::priv::texel::RGBA4:
+                t_masks = { { 0xF0F0, 0x0F0F } };
+                return true;
+            case m3d::priv::texel::LA8:
+                t_masks = { { 0xFF00, 0x00FF } };
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // averages four texels, channel by channel (rounded to nearest)
+    template <typename T>
+    inline T average(const T* t_texels, const ChannelMasks& t_masks) {
+        uint32_t result = 0;
+
+        for (int i = 0; i < 2; i++) {
+            uint64_t mask = t_masks.masks[i],
+                     rounding = (mask & ~(mask << 1)) << 1,
+                     sum = (t_texels[0] & mask) + (t_texels[1] & mask) + (t_texels[2] & mask) + (t_texels[3] & mask);
+
+            result |= ((sum + rounding) >> 2) & mask;
+        }
+
+        return static_cast<T>(result);
+    }
+
+    template <typename T>
+    void downsampleTiled(T* t_destination, const T* t_source, uint32_t t_width, uint32_t t_height, const ChannelMasks& t_masks) {
+        uint32_t width = t_width / 2, height = t_height / 2;
+
+        for (uint32_t y = 0; y < height; y++) {
+            T* destination = t_destination + m3d::priv::tiling::getRowOffset(y, width);
+            const T* source = t_source + m3d::priv::tiling::getRowOffset(y * 2, t_width);
+
+            // the 2x2 pixels starting at an even column and row are consecutive texels
+            for (uint32_t x = 0; x < width; x++) {
+                destination[m3d::priv::tiling::getColumnOffset(x)] = average(source + m3d::priv::tiling::getColumnOffset(x * 2), t_masks);
+            }
+        }
+    }
+}
+
+namespace m3d {
+    namespace priv {
+        namespace mipmap {
+            uint32_t getLevelCount(uint32_t t_width, uint32_t t_height) {
+                uint32_t levels = 1;
+
+                while ((t_width >> levels) >= 8 && (t_height >> levels) >= 8) levels++;
+
+                return levels;
+            }
+
+            uint32_t getTotalSize(uint32_t t_width, uint32_t t_height, uint32_t t_levels, uint32_t t_bitsPerTexel) {
+                uint32_t size = 0;
+
+                for (uint32_t level = 0; level < t_levels; level++) size += (t_width >> level) * (t_height >> level) * t_bitsPerTexel / 8;
+
+                return size;
+            }
+
+            bool generateTiled(void* t_texels, uint32_t t_width, uint32_t t_height, uint8_t t_format, uint32_t t_levels) {
+                ChannelMasks masks;
+                if (!getChannelMasks(t_format, masks)) return false;
+
+                uint8_t* level = static_cast<uint8_t*>(t_texels);
+                uint32_t bytes = m3d::priv::texel::getBitsPerTexel(t_format) / 8;
+
+                for (uint32_t i = 1; i < t_levels; i++) {
+                    uint32_t width = t_width >> (i - 1), height = t_height >> (i - 1);
+                    uint8_t* next = level + width * height * bytes;
+
+                    if (bytes == 4) {
+                        downsampleTiled(reinterpret_cast<uint32_t*>(next), reinterpret_cast<const uint32_t*>(level), width, height, masks);
+                    } else {
+                        downsampleTiled(reinterpret_cast<uint16_t*>(next), reinterpret_cast<const uint16_t*>(level), width, height, masks);
+                    }
+
+                    level = next;
+                }
+
+                return true;
+            }
+
+            void downsample(uint32_t* t_destination, const uint32_t* t_source, uint32_t t_width, uint32_t t_height) {
+                ChannelMasks masks;
+                getChannelMasks(m3d::priv::texel::RGBA8, masks);
+
+                for (uint32_t y = 0; y < t_height / 2; y++) {
+                    for (uint32_t x = 0; x < t_width / 2; x++) {
+                        const uint32_t* source = t_source + y * 2 * t_width + x * 2;
+                        uint32_t texels[4] = { source[0], source[1], source[t_width], source[t_width + 1] };
+
+                        t_destination[y * (t_width / 2) + x] = average(texels, masks);
+                    }
+                }
+            }
+        } /* mipmap */
+    } /* priv */
+} /* m3d */
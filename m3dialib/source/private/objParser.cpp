@@ -0,0 +1,504 @@
+#include <cmath>
+#include <cstring>
+#include <new>
+#include "m3d/private/objParser.hpp"
+
+namespace {
+    // the size of the read buffer (lines must not be longer than this)
+    const size_t BufferSize = 64 * 1024;
+
+    const double powersOf10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    inline bool isSpace(char t_char) {
+        return t_char == ' ' || t_char == '\t' || t_char == '\r';
+    }
+
+    inline bool isDigit(char t_char) {
+        return t_char >= '0' && t_char <= '9';
+    }
+
+    inline const char* skipSpaces(const char* t_begin, const char* t_end) {
+        while (t_begin < t_end && isSpace(*t_begin)) t_begin++;
+        return t_begin;
+    }
+
+    // returns whether the line starts with the given keyword, followed by whitespace
+    inline bool isKeyword(const char* t_begin, const char* t_end, const char* t_keyword, const char*& t_rest) {
+        size_t length = strlen(t_keyword);
+
+        if (static_cast<size_t>(t_end - t_begin) < length || memcmp(t_begin, t_keyword, length) != 0) return false;
+        if (t_begin + length < t_end && !isSpace(t_begin[length])) return false;
+
+        t_rest = t_begin + length;
+        return true;
+    }
+
+    bool parseFloat(const char*& t_begin, const char* t_end, float& t_value) {
+        const char* it = skipSpaces(t_begin, t_end);
+        bool negative = false;
+        uint64_t mantissa = 0;
+        int exponent = 0, digits = 0;
+
+        if (it < t_end && (*it == '-' || *it == '+')) negative = *it++ == '-';
+
+        for (; it < t_end && isDigit(*it); it++, digits++) {
+            // digits beyond the precision of the mantissa only affect the exponent
+            if (mantissa < 1000000000000000000ull) {
+                mantissa = mantissa * 10 + (*it - '0');
+            } else {
+                exponent++;
+            }
+        }
+
+        if (it < t_end && *it == '.') {
+            for (it++; it < t_end && isDigit(*it); it++, digits++) {
+                if (mantissa < 1000000000000000000ull) {
+                    mantissa = mantissa * 10 + (*it - '0');
+                    exponent--;
+                }
+            }
+        }
+
+        if (digits == 0) return false;
+
+        if (it < t_end && (*it == 'e' || *it == 'E')) {
+            const char* start = it++;
+            bool negativeExponent = false;
+            int value = 0;
+
+            if (it < t_end && (*it == '-' || *it == '+')) negativeExponent = *it++ == '-';
+
+            if (it < t_end && isDigit(*it)) {
+                for (; it < t_end && isDigit(*it); it++) {
+                    if (value < 10000) value = value * 10 + (*it - '0');
+                }
+
+                exponent += negativeExponent ? -value : value;
+            } else {
+                it = start;
+            }
+        }
+
+        double result = static_cast<double>(mantissa);
+
+        if (exponent < 0) {
+            result = (exponent >= -22 ? result / powersOf10[-exponent] : result * pow(10.0, exponent));
+        } else if (exponent > 0) {
+            result = (exponent <= 22 ? result * powersOf10[exponent] : result * pow(10.0, exponent));
+        }
+
+        t_value = static_cast<float>(negative ? -result : result);
+        t_begin = it;
+        return true;
+    }
+
+    bool parseInt(const char*& t_begin, const char* t_end, int32_t& t_value) {
+        const char* it = t_begin;
+        bool negative = false;
+        int64_t value = 0;
+
+        if (it < t_end && (*it == '-' || *it == '+')) negative = *it++ == '-';
+        if (it >= t_end || !isDigit(*it)) return false;
+
+        for (; it < t_end && isDigit(*it); it++) {
+            if (value < 0x7FFFFFFF) value = value * 10 + (*it - '0');
+        }
+
+        if (value > 0x7FFFFFFF) value = 0x7FFFFFFF;
+
+        t_value = static_cast<int32_t>(negative ? -value : value);
+        t_begin = it;
+        return true;
+    }
+
+    // resolves a 1-based (or negative, relative) index, returns -1 if it's invalid
+    inline int32_t resolveIndex(int32_t t_index, size_t t_count) {
+        if (t_index > 0 && static_cast<size_t>(t_index) <= t_count) return t_index - 1;
+        if (t_index < 0 && static_cast<size_t>(-static_cast<int64_t>(t_index)) <= t_count) return static_cast<int32_t>(t_count) + t_index;
+        return -1;
+    }
+}
+
+namespace m3d {
+    namespace priv {
+        namespace obj {
+            Parser::Parser() :
+                m_buffer(nullptr),
+                m_materialUsed(false),
+                m_material(-1),
+                m_lookupCount(0) { /* do nothing */ }
+
+            Parser::~Parser() {
+                delete[] m_buffer;
+            }
+
+            bool Parser::parseFile(const std::string& t_path) {
+                if (!begin(t_path) || !readLines(t_path, &Parser::parseObjLine)) return false;
+
+                resolveMaterial();
+                return m_indices.size() > 0;
+            }
+
+            bool Parser::parseMaterial(const std::string& t_path) {
+                if (!begin(t_path) || !readLines(t_path, &Parser::parseMaterialLine)) return false;
+
+                resolveMaterial();
+                return true;
+            }
+
+            std::vector<m3d::priv::obj::Vertex>& Parser::getVertices() {
+                return m_vertices;
+            }
+
+            std::vector<unsigned int>& Parser::getIndices() {
+                return m_indices;
+            }
+
+            bool Parser::hasMaterial() {
+                return m_material >= 0;
+            }
+
+            const m3d::priv::obj::Material& Parser::getMaterial() {
+                return m_materials[m_material];
+            }
+
+            void Parser::clear() {
+                delete[] m_buffer;
+                m_buffer = nullptr;
+
+                std::vector<float>().swap(m_positions);
+                std::vector<float>().swap(m_texcoords);
+                std::vector<float>().swap(m_normals);
+                std::vector<m3d::priv::obj::Vertex>().swap(m_vertices);
+                std::vector<unsigned int>().swap(m_indices);
+                std::vector<m3d::priv::obj::Material>().swap(m_materials);
+                std::vector<m3d::priv::obj::Parser::Corner>().swap(m_corners);
+                std::vector<m3d::priv::obj::Parser::Slot>().swap(m_lookup);
+                m_lookupCount = 0;
+                m_material = -1;
+            }
+
+            // private methods
+            bool Parser::begin(const std::string& t_path) {
+                m_positions.clear();
+                m_texcoords.clear();
+                m_normals.clear();
+                m_vertices.clear();
+                m_indices.clear();
+                m_materials.clear();
+                m_usedMaterial.clear();
+                m_materialUsed = false;
+                m_material = -1;
+                m_lookup.assign(m_lookup.size(), { 0, 0, 0, UINT32_MAX });
+                m_lookupCount = 0;
+
+                if (!m_buffer) {
+                    m_buffer = new (std::nothrow) char[BufferSize];
+                    if (!m_buffer) return false;
+                }
+
+                size_t separator = t_path.find_last_of('/');
+                m_directory = (separator == std::string::npos ? "" : t_path.substr(0, separator + 1));
+
+                return true;
+            }
+
+            void Parser::resolveMaterial() {
+                if (!m_materialUsed) return;
+
+                for (unsigned int i = 0; i < m_materials.size(); i++) {
+                    if (m_materials[i].name == m_usedMaterial) {
+                        m_material = i;
+                        break;
+                    }
+                }
+            }
+
+            bool Parser::readLines(const std::string& t_path, m3d::priv::obj::Parser::LineHandler t_handler) {
+                FILE* file = fopen(t_path.c_str(), "rb");
+                if (!file) return false;
+
+                size_t filled = 0;
+                bool success = true;
+
+                while (success) {
+                    size_t read = fread(m_buffer + filled, 1, BufferSize - filled, file);
+                    filled += read;
+
+                    const char* start = m_buffer;
+                    const char* end = m_buffer + filled;
+
+                    // handle all complete lines in the buffer, a malformed line fails the whole file (skipping it would shift the indices of all following attributes)
+                    for (const char* newline; success && (newline = static_cast<const char*>(memchr(start, '\n', end - start))); start = newline + 1) {
+                        success = (this->*t_handler)(start, newline);
+                    }
+
+                    if (!success) break;
+
+                    size_t remaining = end - start;
+
+                    if (read == 0) {
+                        // the last line doesn't end with a newline
+                        if (remaining > 0) success = (this->*t_handler)(start, end);
+                        break;
+                    }
+
+                    // the line doesn't fit into the buffer
+                    if (remaining == BufferSize) success = false;
+
+                    memmove(m_buffer, start, remaining);
+                    filled = remaining;
+                }
+
+                fclose(file);
+                return success;
+            }
+
+            bool Parser::parseObjLine(const char* t_begin, const char* t_end) {
+                const char* it = skipSpaces(t_begin, t_end);
+                const char* rest;
+
+                if (it >= t_end || *it == '#') return true;
+
+                if (isKeyword(it, t_end, "v", rest)) {
+                    float x = 0.0f, y = 0.0f, z = 0.0f;
+                    if (!parseFloat(rest, t_end, x) || !parseFloat(rest, t_end, y) || !parseFloat(rest, t_end, z)) return false;
+
+                    m_positions.push_back(x);
+                    m_positions.push_back(y);
+                    m_positions.push_back(z);
+                } else if (isKeyword(it, t_end, "vt", rest)) {
+                    float u = 0.0f, v = 0.0f;
+                    if (!parseFloat(rest, t_end, u)) return false;
+                    parseFloat(rest, t_end, v);
+
+                    m_texcoords.push_back(u);
+                    m_texcoords.push_back(v);
+                } else if (isKeyword(it, t_end, "vn", rest)) {
+                    float x = 0.0f, y = 0.0f, z = 0.0f;
+                    if (!parseFloat(rest, t_end, x) || !parseFloat(rest, t_end, y) || !parseFloat(rest, t_end, z)) return false;
+
+                    m_normals.push_back(x);
+                    m_normals.push_back(y);
+                    m_normals.push_back(z);
+                } else if (isKeyword(it, t_end, "f", rest)) {
+                    return parseFace(rest, t_end);
+                } else if (isKeyword(it, t_end, "usemtl", rest)) {
+                    // only the first material gets used
+                    if (!m_materialUsed) {
+                        rest = skipSpaces(rest, t_end);
+                        const char* last = t_end;
+                        while (last > rest && isSpace(last[-1])) last--;
+
+                        m_usedMaterial.assign(rest, last);
+                        m_materialUsed = true;
+                    }
+                } else if (isKeyword(it, t_end, "mtllib", rest)) {
+                    rest = skipSpaces(rest, t_end);
+                    const char* last = t_end;
+                    while (last > rest && isSpace(last[-1])) last--;
+
+                    // the rest of the .obj-file is still in the read buffer, so the material library needs its own
+                    std::string path = m_directory + std::string(rest, last);
+                    char* buffer = m_buffer;
+                    m_buffer = new (std::nothrow) char[BufferSize];
+
+                    // a missing or broken material library only costs the material, not the model
+                    if (m_buffer) {
+                        readLines(path, &Parser::parseMtlLine);
+                        delete[] m_buffer;
+                    }
+
+                    m_buffer = buffer;
+                }
+
+                return true;
+            }
+
+            bool Parser::parseMaterialLine(const char* t_begin, const char* t_end) {
+                const char* it = skipSpaces(t_begin, t_end);
+                const char* rest;
+
+                // vertices and faces get skipped without being parsed
+                if (it < t_end && (isKeyword(it, t_end, "usemtl", rest) || isKeyword(it, t_end, "mtllib", rest))) {
+                    return parseObjLine(t_begin, t_end);
+                }
+
+                return true;
+            }
+
+            bool Parser::parseMtlLine(const char* t_begin, const char* t_end) {
+                const char* it = skipSpaces(t_begin, t_end);
+                const char* rest;
+
+                if (it >= t_end || *it == '#') return true;
+
+                if (isKeyword(it, t_end, "newmtl", rest)) {
+                    rest = skipSpaces(rest, t_end);
+                    const char* last = t_end;
+                    while (last > rest && isSpace(last[-1])) last--;
+
+                    m3d::priv::obj::Material material = { std::string(rest, last), { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+                    m_materials.push_back(material);
+                } else if (m_materials.size() > 0) {
+                    float* color = nullptr;
+
+                    if (isKeyword(it, t_end, "Ka", rest)) {
+                        color = m_materials.back().ambient;
+                    } else if (isKeyword(it, t_end, "Kd", rest)) {
+                        color = m_materials.back().diffuse;
+                    } else if (isKeyword(it, t_end, "Ks", rest)) {
+                        color = m_materials.back().specular;
+                    }
+
+                    if (color) {
+                        for (int i = 0; i < 3; i++) {
+                            if (!parseFloat(rest, t_end, color[i])) return false;
+                        }
+                    }
+                }
+
+                return true;
+            }
+
+            bool Parser::parseFace(const char* t_begin, const char* t_end) {
+                const char* it = t_begin;
+                bool hasNormals = true;
+
+                m_corners.clear();
+
+                // corners are written as v, v/vt, v//vn or v/vt/vn
+                while ((it = skipSpaces(it, t_end)) < t_end) {
+                    m3d::priv::obj::Parser::Corner corner = { -1, -1, -1 };
+                    int32_t index;
+
+                    if (!parseInt(it, t_end, index) || (corner.position = resolveIndex(index, m_positions.size() / 3)) < 0) return false;
+
+                    if (it < t_end && *it == '/') {
+                        it++;
+
+                        if (it < t_end && *it != '/') {
+                            if (!parseInt(it, t_end, index) || (corner.texcoord = resolveIndex(index, m_texcoords.size() / 2)) < 0) return false;
+                        }
+
+                        if (it < t_end && *it == '/') {
+                            it++;
+                            if (!parseInt(it, t_end, index) || (corner.normal = resolveIndex(index, m_normals.size() / 3)) < 0) return false;
+                        }
+                    }
+
+                    if (it < t_end && !isSpace(*it)) return false;
+                    if (corner.normal < 0) hasNormals = false;
+
+                    m_corners.push_back(corner);
+                }
+
+                if (m_corners.size() < 3) return false;
+
+                // faces without normals get the normal of their first triangle
+                float faceNormal[3] = { 0.0f, 0.0f, 0.0f };
+
+                if (!hasNormals) {
+                    const float* p0 = &m_positions[m_corners[0].position * 3];
+                    const float* p1 = &m_positions[m_corners[1].position * 3];
+                    const float* p2 = &m_positions[m_corners[2].position * 3];
+                    float u[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] },
+                          v[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+                    faceNormal[0] = u[1] * v[2] - u[2] * v[1];
+                    faceNormal[1] = u[2] * v[0] - u[0] * v[2];
+                    faceNormal[2] = u[0] * v[1] - u[1] * v[0];
+
+                    float length = sqrtf(faceNormal[0] * faceNormal[0] + faceNormal[1] * faceNormal[1] + faceNormal[2] * faceNormal[2]);
+
+                    if (length > 0.0f) {
+                        for (int i = 0; i < 3; i++) faceNormal[i] /= length;
+                    }
+                }
+
+                uint32_t first = getVertex(m_corners[0], hasNormals ? nullptr : faceNormal),
+                         previous = getVertex(m_corners[1], hasNormals ? nullptr : faceNormal);
+
+                for (unsigned int i = 2; i < m_corners.size(); i++) {
+                    uint32_t current = getVertex(m_corners[i], hasNormals ? nullptr : faceNormal);
+
+                    m_indices.push_back(first);
+                    m_indices.push_back(previous);
+                    m_indices.push_back(current);
+
+                    previous = current;
+                }
+
+                return true;
+            }
+
+            uint32_t Parser::getVertex(const m3d::priv::obj::Parser::Corner& t_corner, const float* t_faceNormal) {
+                m3d::priv::obj::Parser::Slot* slot = nullptr;
+
+                // vertices with generated normals can't be looked up by their indices
+                if (!t_faceNormal) {
+                    if ((m_lookupCount + 1) * 2 > m_lookup.size()) growLookup();
+
+                    uint32_t hash = (static_cast<uint32_t>(t_corner.position) * 73856093u) ^
+                                    (static_cast<uint32_t>(t_corner.texcoord) * 19349663u) ^
+                                    (static_cast<uint32_t>(t_corner.normal) * 83492791u);
+
+                    for (size_t i = hash & (m_lookup.size() - 1);; i = (i + 1) & (m_lookup.size() - 1)) {
+                        slot = &m_lookup[i];
+
+                        if (slot->index == UINT32_MAX) break;
+
+                        if (slot->position == t_corner.position && slot->texcoord == t_corner.texcoord && slot->normal == t_corner.normal) {
+                            return slot->index;
+                        }
+                    }
+                }
+
+                m3d::priv::obj::Vertex vertex;
+                memcpy(vertex.position, &m_positions[t_corner.position * 3], sizeof(vertex.position));
+
+                if (t_corner.texcoord >= 0) {
+                    memcpy(vertex.texcoord, &m_texcoords[t_corner.texcoord * 2], sizeof(vertex.texcoord));
+                } else {
+                    vertex.texcoord[0] = vertex.texcoord[1] = 0.0f;
+                }
+
+                memcpy(vertex.normal, (t_faceNormal ? t_faceNormal : &m_normals[t_corner.normal * 3]), sizeof(vertex.normal));
+
+                m_vertices.push_back(vertex);
+
+                if (slot) {
+                    slot->position = t_corner.position;
+                    slot->texcoord = t_corner.texcoord;
+                    slot->normal = t_corner.normal;
+                    slot->index = m_vertices.size() - 1;
+                    m_lookupCount++;
+                }
+
+                return m_vertices.size() - 1;
+            }
+
+            void Parser::growLookup() {
+                std::vector<m3d::priv::obj::Parser::Slot> lookup(m_lookup.size() < 1024 ? 1024 : m_lookup.size() * 2, { 0, 0, 0, UINT32_MAX });
+
+                for (const auto& slot : m_lookup) {
+                    if (slot.index == UINT32_MAX) continue;
+
+                    uint32_t hash = (static_cast<uint32_t>(slot.position) * 73856093u) ^
+                                    (static_cast<uint32_t>(slot.texcoord) * 19349663u) ^
+                                    (static_cast<uint32_t>(slot.normal) * 83492791u);
+
+                    size_t i = hash & (lookup.size() - 1);
+                    while (lookup[i].index != UINT32_MAX) i = (i + 1) & (lookup.size() - 1);
+
+                    lookup[i] = slot;
+                }
+
+                m_lookup.swap(lookup);
+            }
+        } /* obj */
+    } /* priv */
+} /* m3d */
@@ -0,0 +1,185 @@
+#include <cstdlib>
+#include <cstring>
+#include "m3d/private/pngReader.hpp"
+#include "m3d/private/tiling.hpp"
+
+namespace m3d {
+    namespace priv {
+        namespace image {
+            PngReader::PngReader() :
+                m_png(nullptr),
+                m_info(nullptr),
+                m_width(0),
+                m_height(0),
+                m_passes(1),
+                m_scratch(nullptr),
+                m_position(nullptr) { /* do nothing */ }
+
+            PngReader::~PngReader() {
+                close();
+            }
+
+            bool PngReader::open(FILE* t_file) {
+                close();
+                if (!t_file) return false;
+
+                m_png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+                if (!m_png) return false;
+
+                png_init_io(m_png, t_file);
+                return readHeader();
+            }
+
+            bool PngReader::open(const void* t_buffer) {
+                close();
+                if (!t_buffer) return false;
+
+                m_png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+                if (!m_png) return false;
+
+                m_position = static_cast<const unsigned char*>(t_buffer);
+
+                png_set_read_fn(m_png, this, [](png_structp t_png, png_bytep t_data, png_size_t t_length) {
+                    m3d::priv::image::PngReader* reader = static_cast<m3d::priv::image::PngReader*>(png_get_io_ptr(t_png));
+                    memcpy(t_data, reader->m_position, t_length);
+                    reader->m_position += t_length;
+                });
+
+                return readHeader();
+            }
+
+            uint32_t PngReader::getWidth() {
+                return m_width;
+            }
+
+            uint32_t PngReader::getHeight() {
+                return m_height;
+            }
+
+            bool PngReader::readTiled(void* t_texels, uint32_t t_textureWidth, m3d::priv::texel::Format t_format, uint32_t t_x, uint32_t t_y) {
+                uint32_t bits = m3d::priv::texel::getBitsPerTexel(t_format);
+                if (!m_png || !m_info || t_textureWidth < t_x + m_width || (bits != 32 && bits != 16)) return false;
+
+                // libpng reports errors by jumping back here, the memory gets freed by close()
+                if (setjmp(png_jmpbuf(m_png))) {
+                    close();
+                    return false;
+                }
+
+                // the decoded rows (all of them for interlaced images), followed by the column offsets of the tiles and the converted row
+                size_t rowSize = png_get_rowbytes(m_png, m_info),
+                       rowsSize = rowSize * (m_passes > 1 ? m_height : 1);
+
+                m_scratch = static_cast<unsigned char*>(malloc(rowsSize + m_width * sizeof(uint32_t) + (bits == 16 ? m_width * sizeof(uint16_t) : 0)));
+                if (!m_scratch) png_error(m_png, "out of memory");
+
+                uint32_t* columnOffsets = reinterpret_cast<uint32_t*>(m_scratch + rowsSize);
+                uint16_t* convertedRow = reinterpret_cast<uint16_t*>(columnOffsets + m_width);
+                m3d::priv::tiling::buildColumnOffsets(columnOffsets, m_width, t_x);
+
+                auto writeRow = [&](const unsigned char* t_row, uint32_t t_index) {
+                    if (bits == 16) {
+                        m3d::priv::texel::convertRow(convertedRow, reinterpret_cast<const uint32_t*>(t_row), m_width, t_format);
+                        m3d::priv::tiling::writeRow(static_cast<uint16_t*>(t_texels), columnOffsets, convertedRow, m_width, t_y + t_index, t_textureWidth);
+                    } else {
+                        m3d::priv::tiling::writeRow(static_cast<uint32_t*>(t_texels), columnOffsets, reinterpret_cast<const uint32_t*>(t_row), m_width, t_y + t_index, t_textureWidth);
+                    }
+                };
+
+                if (m_passes > 1) {
+                    for (int pass = 0; pass < m_passes; pass++) {
+                        for (uint32_t y = 0; y < m_height; y++) png_read_row(m_png, m_scratch + y * rowSize, nullptr);
+                    }
+
+                    for (uint32_t y = 0; y < m_height; y++) writeRow(m_scratch + y * rowSize, y);
+                } else {
+                    for (uint32_t y = 0; y < m_height; y++) {
+                        png_read_row(m_png, m_scratch, nullptr);
+                        writeRow(m_scratch, y);
+                    }
+                }
+
+                png_read_end(m_png, nullptr);
+                close();
+                return true;
+            }
+
+            bool PngReader::read(uint32_t* t_pixels) {
+                if (!m_png || !m_info) return false;
+
+                if (setjmp(png_jmpbuf(m_png))) {
+                    close();
+                    return false;
+                }
+
+                // the rows get decoded in place, so no scratch memory is needed
+                for (int pass = 0; pass < m_passes; pass++) {
+                    for (uint32_t y = 0; y < m_height; y++) png_read_row(m_png, reinterpret_cast<png_bytep>(t_pixels + y * m_width), nullptr);
+                }
+
+                png_read_end(m_png, nullptr);
+                close();
+                return true;
+            }
+
+            void PngReader::close() {
+                if (m_png) png_destroy_read_struct(&m_png, m_info ? &m_info : nullptr, nullptr);
+
+                free(m_scratch);
+                m_png = nullptr;
+                m_info = nullptr;
+                m_scratch = nullptr;
+                m_position = nullptr;
+            }
+
+            // private methods
+            bool PngReader::readHeader() {
+                m_info = png_create_info_struct(m_png);
+
+                if (!m_info) {
+                    close();
+                    return false;
+                }
+
+                if (setjmp(png_jmpbuf(m_png))) {
+                    close();
+                    return false;
+                }
+
+                png_read_info(m_png, m_info);
+
+                m_width = png_get_image_width(m_png, m_info);
+                m_height = png_get_image_height(m_png, m_info);
+
+                png_byte colorType = png_get_color_type(m_png, m_info),
+                         bitDepth = png_get_bit_depth(m_png, m_info);
+
+                // convert any format into 8-bit RGBA (see http://www.libpng.org/pub/png/libpng-manual.txt)
+                if (bitDepth == 16) png_set_strip_16(m_png);
+                if (colorType == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(m_png);
+                if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8) png_set_expand_gray_1_2_4_to_8(m_png);
+                if (png_get_valid(m_png, m_info, PNG_INFO_tRNS)) png_set_tRNS_to_alpha(m_png);
+
+                // images without an alpha channel are opaque
+                if (colorType == PNG_COLOR_TYPE_RGB || colorType == PNG_COLOR_TYPE_GRAY || colorType == PNG_COLOR_TYPE_PALETTE) png_set_filler(m_png, 0xFF, PNG_FILLER_AFTER);
+                if (colorType == PNG_COLOR_TYPE_GRAY || colorType == PNG_COLOR_TYPE_GRAY_ALPHA) png_set_gray_to_rgb(m_png);
+
+                // ABGR, which is RGBA8 on the PICA200 when read as a little-endian word
+                png_set_bgr(m_png);
+                png_set_swap_alpha(m_png);
+
+                // interlaced images get completed over several passes
+                m_passes = png_set_interlace_handling(m_png);
+
+                png_read_update_info(m_png, m_info);
+
+                if (png_get_rowbytes(m_png, m_info) != m_width * sizeof(uint32_t)) {
+                    close();
+                    return false;
+                }
+
+                return true;
+            }
+        } /* image */
+    } /* priv */
+} /* m3d */
@@ -0,0 +1,459 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include "m3d/private/simplifier.hpp"
+
+namespace {
+    const unsigned int Invalid = ~0u;
+
+    // border planes weigh more than the planes of the triangles, so the outline of open meshes is kept
+    const double BorderWeight = 10.0;
+
+    // the share of the cheapest collapses considered per pass, the rest waits until the costs got updated
+    const size_t PassDivisor = 3;
+
+    // the symmetric 4x4 matrix of a quadric, plus the sum of the weights of its planes
+    struct Quadric {
+        double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2, weight;
+    };
+
+    struct Collapse {
+        unsigned int source, target;
+        double cost;
+    };
+
+    void addPlane(Quadric& t_quadric, double t_a, double t_b, double t_c, double t_d, double t_weight) {
+        t_quadric.a2 += t_weight * t_a * t_a;
+        t_quadric.ab += t_weight * t_a * t_b;
+        t_quadric.ac += t_weight * t_a * t_c;
+        t_quadric.ad += t_weight * t_a * t_d;
+        t_quadric.b2 += t_weight * t_b * t_b;
+        t_quadric.bc += t_weight * t_b * t_c;
+        t_quadric.bd += t_weight * t_b * t_d;
+        t_quadric.c2 += t_weight * t_c * t_c;
+        t_quadric.cd += t_weight * t_c * t_d;
+        t_quadric.d2 += t_weight * t_d * t_d;
+        t_quadric.weight += t_weight;
+    }
+
+    void addQuadric(Quadric& t_quadric, const Quadric& t_other) {
+        t_quadric.a2 += t_other.a2;
+        t_quadric.ab += t_other.ab;
+        t_quadric.ac += t_other.ac;
+        t_quadric.ad += t_other.ad;
+        t_quadric.b2 += t_other.b2;
+        t_quadric.bc += t_other.bc;
+        t_quadric.bd += t_other.bd;
+        t_quadric.c2 += t_other.c2;
+        t_quadric.cd += t_other.cd;
+        t_quadric.d2 += t_other.d2;
+        t_quadric.weight += t_other.weight;
+    }
+
+    // the weighted sum of the squared distances to the planes of the quadric
+    double evaluate(const Quadric& t_quadric, const float* t_position) {
+        double x = t_position[0], y = t_position[1], z = t_position[2];
+
+        return t_quadric.a2 * x * x + 2 * t_quadric.ab * x * y + 2 * t_quadric.ac * x * z + 2 * t_quadric.ad * x +
+               t_quadric.b2 * y * y + 2 * t_quadric.bc * y * z + 2 * t_quadric.bd * y +
+               t_quadric.c2 * z * z + 2 * t_quadric.cd * z +
+               t_quadric.d2;
+    }
+
+    void normal(const float* t_position0, const float* t_position1, const float* t_position2, float* t_normal) {
+        float edge0[3] = { t_position1[0] - t_position0[0], t_position1[1] - t_position0[1], t_position1[2] - t_position0[2] },
+              edge1[3] = { t_position2[0] - t_position0[0], t_position2[1] - t_position0[1], t_position2[2] - t_position0[2] };
+
+        t_normal[0] = edge0[1] * edge1[2] - edge0[2] * edge1[1];
+        t_normal[1] = edge0[2] * edge1[0] - edge0[0] * edge1[2];
+        t_normal[2] = edge0[0] * edge1[1] - edge0[1] * edge1[0];
+    }
+
+    inline uint64_t edgeKey(unsigned int t_vertex0, unsigned int t_vertex1) {
+        return (t_vertex0 < t_vertex1 ? (static_cast<uint64_t>(t_vertex0) << 32) | t_vertex1 : (static_cast<uint64_t>(t_vertex1) << 32) | t_vertex0);
+    }
+
+    class Simplifier {
+    public:
+        Simplifier(std::vector<unsigned int>& t_indices, const float* t_positions, size_t t_vertexCount, size_t t_stride) :
+            m_indices(t_indices),
+            m_vertexCount(t_vertexCount),
+            m_positions(t_vertexCount * 3),
+            m_canonical(t_vertexCount),
+            m_wedge(t_vertexCount),
+            m_quadrics(t_vertexCount),
+            m_alive(t_indices.size() / 3, 1),
+            m_liveTriangles(t_indices.size() / 3) {
+                loadPositions(t_positions, t_stride);
+                buildWedges(t_positions, t_stride);
+                buildQuadrics();
+            }
+
+        float run(size_t t_targetTriangles, float t_maxError) {
+            double maxCost = static_cast<double>(t_maxError) * t_maxError, error = 0.0;
+            std::vector<Collapse> collapses;
+            std::vector<char> touched(m_vertexCount);
+
+            while (m_liveTriangles > t_targetTriangles) {
+                buildAdjacency();
+                findCollapses(collapses);
+                if (collapses.empty()) break;
+
+                std::fill(touched.begin(), touched.end(), 0);
+                size_t limit = std::max<size_t>(1, collapses.size() / PassDivisor), performed = 0;
+                bool exhausted = false;
+
+                for (size_t i = 0; i < limit && m_liveTriangles > t_targetTriangles; i++) {
+                    const Collapse& collapse = collapses[i];
+
+                    // the collapses are sorted, all following ones would exceed the error as well
+                    if (collapse.cost > maxCost) {
+                        exhausted = true;
+                        break;
+                    }
+
+                    // the costs of collapses next to the changed vertices are outdated until the next pass
+                    if (touched[collapse.source] || touched[collapse.target]) continue;
+                    if (!perform(collapse.source, collapse.target)) continue;
+
+                    touched[collapse.source] = touched[collapse.target] = 1;
+                    error = std::max(error, collapse.cost);
+                    performed++;
+                }
+
+                if (exhausted || performed == 0) break;
+            }
+
+            // remove the collapsed triangles
+            size_t count = 0;
+
+            for (size_t i = 0; i < m_alive.size(); i++) {
+                if (!m_alive[i]) continue;
+
+                m_indices[count * 3]     = m_indices[i * 3];
+                m_indices[count * 3 + 1] = m_indices[i * 3 + 1];
+                m_indices[count * 3 + 2] = m_indices[i * 3 + 2];
+                count++;
+            }
+
+            m_indices.resize(count * 3);
+            return sqrt(error);
+        }
+
+    private:
+        void loadPositions(const float* t_positions, size_t t_stride) {
+            const char* data = reinterpret_cast<const char*>(t_positions);
+            float min[3], max[3], extent = 0.0f;
+
+            for (size_t i = 0; i < m_vertexCount; i++) {
+                memcpy(&m_positions[i * 3], data + i * t_stride, sizeof(float) * 3);
+
+                for (int j = 0; j < 3; j++) {
+                    min[j] = (i == 0 ? m_positions[j] : fminf(min[j], m_positions[i * 3 + j]));
+                    max[j] = (i == 0 ? m_positions[j] : fmaxf(max[j], m_positions[i * 3 + j]));
+                }
+            }
+
+            // normalize the mesh to a size of 1, so the error is relative to its size
+            for (int j = 0; j < 3; j++) extent = fmaxf(extent, max[j] - min[j]);
+            float scale = (extent > 0.0f ? 1.0f / extent : 1.0f);
+
+            for (size_t i = 0; i < m_vertexCount; i++) {
+                for (int j = 0; j < 3; j++) m_positions[i * 3 + j] = (m_positions[i * 3 + j] - min[j]) * scale;
+            }
+        }
+
+        void buildWedges(const float* t_positions, size_t t_stride) {
+            const char* data = reinterpret_cast<const char*>(t_positions);
+            std::vector<unsigned int> order(m_vertexCount);
+
+            for (size_t i = 0; i < m_vertexCount; i++) order[i] = i;
+
+            // vertices at the same (exact) position end up next to each other
+            std::sort(order.begin(), order.end(), [data, t_stride](unsigned int t_lhs, unsigned int t_rhs) {
+                int result = memcmp(data + t_lhs * t_stride, data + t_rhs * t_stride, sizeof(float) * 3);
+                return result < 0 || (result == 0 && t_lhs < t_rhs);
+            });
+
+            // the vertices sharing a position (wedges) get linked into a ring, the first one represents all of them
+            for (size_t begin = 0, end; begin < m_vertexCount; begin = end) {
+                for (end = begin + 1; end < m_vertexCount && memcmp(data + order[begin] * t_stride, data + order[end] * t_stride, sizeof(float) * 3) == 0; end++);
+
+                for (size_t i = begin; i < end; i++) {
+                    m_canonical[order[i]] = order[begin];
+                    m_wedge[order[i]] = order[i + 1 < end ? i + 1 : begin];
+                }
+            }
+        }
+
+        void buildQuadrics() {
+            memset(m_quadrics.data(), 0, m_quadrics.size() * sizeof(Quadric));
+            std::unordered_map<uint64_t, unsigned int> edges;
+            edges.reserve(m_indices.size());
+
+            for (size_t i = 0; i < m_alive.size(); i++) {
+                unsigned int corners[3] = { m_canonical[m_indices[i * 3]], m_canonical[m_indices[i * 3 + 1]], m_canonical[m_indices[i * 3 + 2]] };
+
+                // triangles without an area don't contribute to the shape
+                if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0]) {
+                    m_alive[i] = 0;
+                    m_liveTriangles--;
+                    continue;
+                }
+
+                float plane[3];
+                normal(&m_positions[corners[0] * 3], &m_positions[corners[1] * 3], &m_positions[corners[2] * 3], plane);
+                float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+                for (int j = 0; j < 3; j++) edges[edgeKey(corners[j], corners[(j + 1) % 3])]++;
+                if (length <= 0.0f) continue;
+
+                // area-weighted, so big triangles matter more than small ones
+                for (int j = 0; j < 3; j++) plane[j] /= length;
+                double distance = -(plane[0] * m_positions[corners[0] * 3] + plane[1] * m_positions[corners[0] * 3 + 1] + plane[2] * m_positions[corners[0] * 3 + 2]);
+
+                for (int j = 0; j < 3; j++) addPlane(m_quadrics[corners[j]], plane[0], plane[1], plane[2], distance, length * 0.5);
+            }
+
+            // planes through the border edges, perpendicular to their triangles
+            for (size_t i = 0; i < m_alive.size(); i++) {
+                if (!m_alive[i]) continue;
+
+                unsigned int corners[3] = { m_canonical[m_indices[i * 3]], m_canonical[m_indices[i * 3 + 1]], m_canonical[m_indices[i * 3 + 2]] };
+                float triangleNormal[3];
+                normal(&m_positions[corners[0] * 3], &m_positions[corners[1] * 3], &m_positions[corners[2] * 3], triangleNormal);
+
+                for (int j = 0; j < 3; j++) {
+                    unsigned int from = corners[j], to = corners[(j + 1) % 3];
+                    if (edges[edgeKey(from, to)] != 1) continue;
+
+                    const float* start = &m_positions[from * 3];
+                    float edge[3] = { m_positions[to * 3] - start[0], m_positions[to * 3 + 1] - start[1], m_positions[to * 3 + 2] - start[2] },
+                          plane[3] = {
+                              edge[1] * triangleNormal[2] - edge[2] * triangleNormal[1],
+                              edge[2] * triangleNormal[0] - edge[0] * triangleNormal[2],
+                              edge[0] * triangleNormal[1] - edge[1] * triangleNormal[0]
+                          },
+                          length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+                    if (length <= 0.0f) continue;
+                    for (int k = 0; k < 3; k++) plane[k] /= length;
+
+                    double distance = -(plane[0] * start[0] + plane[1] * start[1] + plane[2] * start[2]),
+                           weight = (edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]) * BorderWeight;
+
+                    addPlane(m_quadrics[from], plane[0], plane[1], plane[2], distance, weight);
+                    addPlane(m_quadrics[to], plane[0], plane[1], plane[2], distance, weight);
+                }
+            }
+        }
+
+        // the live triangles around every vertex, stored back-to-back
+        void buildAdjacency() {
+            m_adjacencyOffsets.assign(m_vertexCount + 1, 0);
+
+            for (size_t i = 0; i < m_alive.size(); i++) {
+                if (!m_alive[i]) continue;
+                for (int j = 0; j < 3; j++) m_adjacencyOffsets[m_indices[i * 3 + j] + 1]++;
+            }
+
+            for (size_t i = 0; i < m_vertexCount; i++) m_adjacencyOffsets[i + 1] += m_adjacencyOffsets[i];
+
+            m_adjacency.resize(m_adjacencyOffsets[m_vertexCount]);
+            std::vector<unsigned int> fill(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+
+            for (size_t i = 0; i < m_alive.size(); i++) {
+                if (!m_alive[i]) continue;
+                for (int j = 0; j < 3; j++) m_adjacency[fill[m_indices[i * 3 + j]]++] = i;
+            }
+
+            // border and non-manifold edges of the current mesh (in terms of positions)
+            m_edges.clear();
+
+            for (size_t i = 0; i < m_alive.size(); i++) {
+                if (!m_alive[i]) continue;
+
+                for (int j = 0; j < 3; j++) {
+                    m_edges[edgeKey(m_canonical[m_indices[i * 3 + j]], m_canonical[m_indices[i * 3 + (j + 1) % 3]])]++;
+                }
+            }
+
+            m_border.assign(m_vertexCount, 0);
+            m_locked.assign(m_vertexCount, 0);
+
+            for (const auto& edge : m_edges) {
+                unsigned int vertex0 = edge.first >> 32, vertex1 = edge.first & 0xFFFFFFFF;
+
+                if (edge.second == 1) {
+                    m_border[vertex0] = m_border[vertex1] = 1;
+                } else if (edge.second > 2) {
+                    m_locked[vertex0] = m_locked[vertex1] = 1;
+                }
+            }
+        }
+
+        // the cheapest collapse of every vertex, sorted by cost
+        void findCollapses(std::vector<Collapse>& t_collapses) {
+            t_collapses.clear();
+            m_best.assign(m_vertexCount, { Invalid, Invalid, 0.0 });
+
+            for (size_t i = 0; i < m_alive.size(); i++) {
+                if (!m_alive[i]) continue;
+
+                for (int j = 0; j < 3; j++) {
+                    for (int direction = 0; direction < 2; direction++) {
+                        unsigned int source = m_canonical[m_indices[i * 3 + (direction ? (j + 1) % 3 : j)]],
+                                     target = m_canonical[m_indices[i * 3 + (direction ? j : (j + 1) % 3)]];
+
+                        if (m_locked[source]) continue;
+
+                        // border vertices may only move along the border
+                        if (m_border[source] && m_edges[edgeKey(source, target)] != 1) continue;
+
+                        Quadric quadric = m_quadrics[source];
+                        addQuadric(quadric, m_quadrics[target]);
+                        double cost = fmax(0.0, evaluate(quadric, &m_positions[target * 3])) / fmax(quadric.weight, 1e-12);
+
+                        if (m_best[source].source == Invalid || cost < m_best[source].cost) m_best[source] = { source, target, cost };
+                    }
+                }
+            }
+
+            for (const auto& collapse : m_best) {
+                if (collapse.source != Invalid) t_collapses.push_back(collapse);
+            }
+
+            std::sort(t_collapses.begin(), t_collapses.end(), [](const Collapse& t_lhs, const Collapse& t_rhs) {
+                return t_lhs.cost < t_rhs.cost;
+            });
+        }
+
+        bool perform(unsigned int t_source, unsigned int t_target) {
+            m_mapping.clear();
+
+            // every wedge of the source needs exactly one wedge of the target it shares an edge with
+            unsigned int wedge = t_source;
+
+            do {
+                unsigned int partner = Invalid;
+                bool used = false;
+
+                for (unsigned int i = m_adjacencyOffsets[wedge]; i < m_adjacencyOffsets[wedge + 1]; i++) {
+                    unsigned int triangle = m_adjacency[i];
+                    if (!m_alive[triangle]) continue;
+
+                    used = true;
+
+                    for (int j = 0; j < 3; j++) {
+                        unsigned int vertex = m_indices[triangle * 3 + j];
+                        if (m_canonical[vertex] != t_target) continue;
+
+                        if (partner != Invalid && partner != vertex) return false;
+                        partner = vertex;
+                    }
+                }
+
+                if (used) {
+                    // a seam ending at the collapsed edge would have to be torn open
+                    if (partner == Invalid) return false;
+
+                    // different wedges merging into one would join both sides of a seam
+                    for (size_t i = 0; i < m_mapping.size(); i += 2) {
+                        if (m_mapping[i + 1] == partner) return false;
+                    }
+
+                    m_mapping.push_back(wedge);
+                    m_mapping.push_back(partner);
+                }
+
+                wedge = m_wedge[wedge];
+            } while (wedge != t_source);
+
+            // reject collapses flipping a triangle
+            for (size_t i = 0; i < m_mapping.size(); i += 2) {
+                for (unsigned int j = m_adjacencyOffsets[m_mapping[i]]; j < m_adjacencyOffsets[m_mapping[i] + 1]; j++) {
+                    unsigned int triangle = m_adjacency[j];
+                    if (!m_alive[triangle]) continue;
+
+                    const float* before[3];
+                    const float* after[3];
+                    bool collapsed = false;
+
+                    for (int k = 0; k < 3; k++) {
+                        unsigned int corner = m_canonical[m_indices[triangle * 3 + k]];
+                        if (corner == t_target) collapsed = true;
+
+                        before[k] = &m_positions[corner * 3];
+                        after[k] = &m_positions[(corner == t_source ? t_target : corner) * 3];
+                    }
+
+                    // triangles along the collapsed edge disappear anyway
+                    if (collapsed) continue;
+
+                    float normalBefore[3], normalAfter[3];
+                    normal(before[0], before[1], before[2], normalBefore);
+                    normal(after[0], after[1], after[2], normalAfter);
+
+                    if (normalBefore[0] * normalAfter[0] + normalBefore[1] * normalAfter[1] + normalBefore[2] * normalAfter[2] <= 0.0f) return false;
+                }
+            }
+
+            // move the triangles over to the wedges of the target
+            for (size_t i = 0; i < m_mapping.size(); i += 2) {
+                for (unsigned int j = m_adjacencyOffsets[m_mapping[i]]; j < m_adjacencyOffsets[m_mapping[i] + 1]; j++) {
+                    unsigned int triangle = m_adjacency[j];
+                    if (!m_alive[triangle]) continue;
+
+                    unsigned int* corners = &m_indices[triangle * 3];
+
+                    for (int k = 0; k < 3; k++) {
+                        if (corners[k] == m_mapping[i]) corners[k] = m_mapping[i + 1];
+                    }
+
+                    if (m_canonical[corners[0]] == m_canonical[corners[1]] || m_canonical[corners[1]] == m_canonical[corners[2]] || m_canonical[corners[2]] == m_canonical[corners[0]]) {
+                        m_alive[triangle] = 0;
+                        m_liveTriangles--;
+                    }
+                }
+            }
+
+            addQuadric(m_quadrics[t_target], m_quadrics[t_source]);
+            return true;
+        }
+
+        /* data */
+        std::vector<unsigned int>& m_indices;
+        size_t m_vertexCount;
+        std::vector<float> m_positions;
+        std::vector<unsigned int> m_canonical, m_wedge;
+        std::vector<Quadric> m_quadrics;
+        std::vector<char> m_alive;
+        size_t m_liveTriangles;
+
+        // rebuilt every pass
+        std::vector<unsigned int> m_adjacencyOffsets, m_adjacency;
+        std::unordered_map<uint64_t, unsigned int> m_edges;
+        std::vector<char> m_border, m_locked;
+        std::vector<Collapse> m_best;
+
+        // scratch space (pairs of source and target wedges)
+        std::vector<unsigned int> m_mapping;
+    };
+}
+
+namespace m3d {
+    namespace priv {
+        namespace simplify {
+            float simplify(std::vector<unsigned int>& t_indices, const float* t_positions, size_t t_vertexCount, size_t t_stride, size_t t_targetIndexCount, float t_maxError) {
+                if (t_vertexCount == 0 || t_indices.size() < 3 || t_targetIndexCount >= t_indices.size()) return 0.0f;
+
+                t_indices.resize(t_indices.size() - t_indices.size() % 3);
+
+                Simplifier simplifier(t_indices, t_positions, t_vertexCount, t_stride);
+                return simplifier.run(t_targetIndexCount / 3, t_maxError);
+            }
+        } /* simplify */
+    } /* priv */
+} /* m3d */
@@ -0,0 +1,97 @@
+#include "m3d/private/skyline.hpp"
+
+namespace m3d {
+    namespace priv {
+        namespace skyline {
+            Packer::Packer(uint32_t t_width, uint32_t t_height) :
+                    m_width(t_width),
+                    m_height(t_height) {
+                clear();
+            }
+
+            bool Packer::insert(uint32_t t_width, uint32_t t_height, uint32_t& t_x, uint32_t& t_y) {
+                size_t best = m_segments.size();
+                uint32_t bestY = m_height, bestWidth = m_width + 1;
+
+                for (size_t i = 0; i < m_segments.size(); i++) {
+                    uint32_t y;
+
+                    if (fits(i, t_width, t_height, y) && (y < bestY || (y == bestY && m_segments[i].width < bestWidth))) {
+                        best = i;
+                        bestY = y;
+                        bestWidth = m_segments[i].width;
+                    }
+                }
+
+                if (best == m_segments.size()) return false;
+
+                t_x = m_segments[best].x;
+                t_y = bestY;
+
+                // the rectangle becomes a new segment, covering the ones it spans (completely or partly)
+                Segment segment = { t_x, bestY + t_height, t_width };
+                m_segments.insert(m_segments.begin() + best, segment);
+
+                uint32_t right = t_x + t_width;
+                size_t i = best + 1;
+
+                while (i < m_segments.size() && m_segments[i].x < right) {
+                    uint32_t end = m_segments[i].x + m_segments[i].width;
+
+                    if (end <= right) {
+                        m_segments.erase(m_segments.begin() + i);
+                    } else {
+                        m_segments[i].width = end - right;
+                        m_segments[i].x = right;
+                        break;
+                    }
+                }
+
+                // neighbours of the same height get merged, so the skyline stays short
+                for (i = 0; i + 1 < m_segments.size();) {
+                    if (m_segments[i].y == m_segments[i + 1].y) {
+                        m_segments[i].width += m_segments[i + 1].width;
+                        m_segments.erase(m_segments.begin() + i + 1);
+                    } else {
+                        i++;
+                    }
+                }
+
+                m_usedArea += t_width * t_height;
+                return true;
+            }
+
+            void Packer::clear() {
+                m_segments.clear();
+                m_segments.push_back({ 0, 0, m_width });
+                m_usedArea = 0;
+            }
+
+            uint32_t Packer::getUsedArea() {
+                return m_usedArea;
+            }
+
+            float Packer::getOccupancy() {
+                return static_cast<float>(m_usedArea) / (m_width * m_height);
+            }
+
+            // private methods
+            bool Packer::fits(size_t t_index, uint32_t t_width, uint32_t t_height, uint32_t& t_y) {
+                if (m_segments[t_index].x + t_width > m_width) return false;
+
+                // the rectangle rests on the highest segment below it
+                uint32_t y = 0, remaining = t_width;
+
+                for (size_t i = t_index; remaining > 0; i++) {
+                    if (m_segments[i].y > y) y = m_segments[i].y;
+                    if (y + t_height > m_height) return false;
+
+                    remaining -= (m_segments[i].width < remaining ? m_segments[i].width : remaining);
+                }
+
+                t_y = y;
+                return true;
+            }
+        } /* skyline */
+    } /* priv */
+} /* m3d */
@@ -0,0 +1,187 @@
+#include <cmath>
+#include <cstring>
+#include "m3d/private/texelFormat.hpp"
+
+namespace {
+    // the intensity modifiers of the ETC1 tables (the other two are the negated ones)
+    const int Modifiers[8][2] = {
+        { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+    };
+
+    struct Subblock {
+        int colors[8][3];   // the pixels of the subblock
+        int positions[8];   // their position in the block (x * 4 + y, the order of the pixel indices)
+    };
+
+    struct Fit {
+        int error;
+        int table;
+        int selectors[8];   // 0: +a, 1: +b, 2: -a, 3: -b
+    };
+
+    inline int clamp(int t_value) {
+        return t_value < 0 ? 0 : (t_value > 255 ? 255 : t_value);
+    }
+
+    // finds the table and the modifier of each pixel with the least error for a base color
+    Fit fitSubblock(const Subblock& t_subblock, const int t_base[3]) {
+        Fit best;
+        best.error = 0x7FFFFFFF;
+
+        for (int table = 0; table < 8; table++) {
+            Fit fit;
+            fit.error = 0;
+            fit.table = table;
+
+            for (int i = 0; i < 8 && fit.error < best.error; i++) {
+                int bestError = 0x7FFFFFFF;
+
+                for (int selector = 0; selector < 4; selector++) {
+                    int modifier = (selector & 2 ? -1 : 1) * Modifiers[table][selector & 1],
+                        error = 0;
+
+                    for (int c = 0; c < 3; c++) {
+                        int delta = clamp(t_base[c] + modifier) - t_subblock.colors[i][c];
+                        error += delta * delta;
+                    }
+
+                    if (error < bestError) {
+                        bestError = error;
+                        fit.selectors[i] = selector;
+                    }
+                }
+
+                fit.error += bestError;
+            }
+
+            if (fit.error < best.error) best = fit;
+        }
+
+        return best;
+    }
+
+    // encodes a 4x4 block (pixels row by row) into the standard ETC1 bit layout
+    uint64_t encodeBlock(const uint32_t t_pixels[16]) {
+        uint64_t bestBlock = 0;
+        int bestError = 0x7FFFFFFF;
+
+        for (int flip = 0; flip < 2; flip++) {
+            // without flip the subblocks are 2x4 side by side, with flip 4x2 on top of each other
+            Subblock subblocks[2];
+            float average[2][3] = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+            int counts[2] = { 0, 0 };
+
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    int index = (flip ? y >= 2 : x >= 2), i = counts[index]++;
+                    uint32_t pixel = t_pixels[y * 4 + x];
+
+                    subblocks[index].colors[i][0] = pixel >> 24;
+                    subblocks[index].colors[i][1] = (pixel >> 16) & 0xFF;
+                    subblocks[index].colors[i][2] = (pixel >> 8) & 0xFF;
+                    subblocks[index].positions[i] = x * 4 + y;
+
+                    for (int c = 0; c < 3; c++) average[index][c] += subblocks[index].colors[i][c] / 8.0f;
+                }
+            }
+
+            for (int differential = 0; differential < 2; differential++) {
+                // individual mode stores two 4-bit colors, differential mode a 5-bit color and a 3-bit signed delta
+                int quantized[2][3], expanded[2][3];
+
+                for (int c = 0; c < 3; c++) {
+                    if (differential) {
+                        quantized[0][c] = lroundf(average[0][c] * 31.0f / 255.0f);
+                        quantized[1][c] = lroundf(average[1][c] * 31.0f / 255.0f);
+
+                        int delta = quantized[1][c] - quantized[0][c];
+                        quantized[1][c] = quantized[0][c] + (delta < -4 ? -4 : (delta > 3 ? 3 : delta));
+
+                        for (int s = 0; s < 2; s++) expanded[s][c] = (quantized[s][c] << 3) | (quantized[s][c] >> 2);
+                    } else {
+                        for (int s = 0; s < 2; s++) {
+                            quantized[s][c] = lroundf(average[s][c] * 15.0f / 255.0f);
+                            expanded[s][c] = quantized[s][c] * 17;
+                        }
+                    }
+                }
+
+                Fit fits[2] = { fitSubblock(subblocks[0], expanded[0]), fitSubblock(subblocks[1], expanded[1]) };
+
+                if (fits[0].error + fits[1].error >= bestError) continue;
+                bestError = fits[0].error + fits[1].error;
+
+                uint32_t high = (fits[0].table << 5) | (fits[1].table << 2) | (differential << 1) | flip, low = 0;
+
+                for (int c = 0; c < 3; c++) {
+                    if (differential) {
+                        high |= (quantized[0][c] << (27 - c * 8)) | (((quantized[1][c] - quantized[0][c]) & 7) << (24 - c * 8));
+                    } else {
+                        high |= (quantized[0][c] << (28 - c * 8)) | (quantized[1][c] << (24 - c * 8));
+                    }
+                }
+
+                for (int s = 0; s < 2; s++) {
+                    for (int i = 0; i < 8; i++) {
+                        int position = subblocks[s].positions[i], selector = fits[s].selectors[i];
+                        low |= ((selector >> 1) << (position + 16)) | ((selector & 1) << position);
+                    }
+                }
+
+                bestBlock = (static_cast<uint64_t>(high) << 32) | low;
+            }
+        }
+
+        return bestBlock;
+    }
+
+    // the 4-bit alpha of a 4x4 block, in the same order as the pixel indices
+    uint64_t encodeAlpha(const uint32_t t_pixels[16]) {
+        uint64_t alpha = 0;
+
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++) {
+                alpha |= static_cast<uint64_t>(((t_pixels[y * 4 + x] & 0xFF) * 15 + 127) / 255) << ((x * 4 + y) * 4);
+            }
+        }
+
+        return alpha;
+    }
+}
+
+namespace m3d {
+    namespace priv {
+        namespace texel {
+            void encodeEtc1(void* t_output, const uint32_t* t_pixels, uint32_t t_width, uint32_t t_height, uint32_t t_textureWidth, uint32_t t_textureHeight, bool t_alpha) {
+                uint8_t* output = static_cast<uint8_t*>(t_output);
+
+                // the tiles row by row, the four blocks of a tile in Z-order
+                for (uint32_t tileY = 0; tileY < t_textureHeight; tileY += 8) {
+                    for (uint32_t tileX = 0; tileX < t_textureWidth; tileX += 8) {
+                        for (int block = 0; block < 4; block++) {
+                            uint32_t blockX = tileX + (block & 1) * 4, blockY = tileY + (block >> 1) * 4, pixels[16];
+
+                            for (uint32_t y = 0; y < 4; y++) {
+                                for (uint32_t x = 0; x < 4; x++) {
+                                    bool inside = blockX + x < t_width && blockY + y < t_height;
+                                    pixels[y * 4 + x] = (inside ? t_pixels[(blockY + y) * t_width + blockX + x] : 0);
+                                }
+                            }
+
+                            // the PICA200 reads the 64-bit blocks as little-endian words
+                            if (t_alpha) {
+                                uint64_t alpha = encodeAlpha(pixels);
+                                memcpy(output, &alpha, sizeof(alpha));
+                                output += sizeof(alpha);
+                            }
+
+                            uint64_t color = encodeBlock(pixels);
+                            memcpy(output, &color, sizeof(color));
+                            output += sizeof(color);
+                        }
+                    }
+                }
+            }
+        } /* texel */
+    } /* priv */
+} /* m3d */
@@ -0,0 +1,157 @@
+#include <cmath>
+#include <cstring>
+#include "m3d/private/vertexCache.hpp"
+
+namespace {
+    // the parameters of the scoring function (see Tom Forsyth, "Linear-Speed Vertex Cache Optimisation")
+    const int CacheSize = 32;
+    const int MaxValence = 32;
+    const float CacheDecayPower = 1.5f;
+    const float LastTriangleScore = 0.75f;
+    const float ValenceBoostScale = 2.0f;
+    const float ValenceBoostPower = 0.5f;
+
+    // the scores of vertices by their position in the cache and the number of triangles still using them
+    struct ScoreTable {
+        float cache[CacheSize + 1], valence[MaxValence + 1];
+
+        ScoreTable() {
+            // index 0 is outside of the cache
+            cache[0] = 0.0f;
+
+            for (int i = 0; i < CacheSize; i++) {
+                // the vertices of the last triangle get a fixed score, so the next triangle doesn't just reuse them
+                cache[i + 1] = (i < 3 ? LastTriangleScore : powf(1.0f - static_cast<float>(i - 3) / (CacheSize - 3), CacheDecayPower));
+            }
+
+            // vertices with few triangles left get boosted, so no lone triangles are left behind
+            valence[0] = 0.0f;
+            for (int i = 1; i <= MaxValence; i++) valence[i] = ValenceBoostScale * powf(static_cast<float>(i), -ValenceBoostPower);
+        }
+
+        float score(int t_cachePosition, unsigned int t_remaining) const {
+            if (t_remaining == 0) return -1.0f;
+            return cache[t_cachePosition + 1] + valence[t_remaining < MaxValence ? t_remaining : MaxValence];
+        }
+    };
+}
+
+namespace m3d {
+    namespace priv {
+        namespace vertexCache {
+            void optimizeTriangles(std::vector<unsigned int>& t_indices, size_t t_vertexCount) {
+                static const ScoreTable table;
+                size_t triangleCount = t_indices.size() / 3;
+
+                if (triangleCount < 2 || t_vertexCount == 0) return;
+
+                // the triangles using each vertex, the ones not drawn yet are at the front
+                std::vector<unsigned int> offsets(t_vertexCount + 1, 0), remaining(t_vertexCount, 0), adjacency(triangleCount * 3);
+
+                for (size_t i = 0; i < triangleCount * 3; i++) remaining[t_indices[i]]++;
+                for (size_t i = 0; i < t_vertexCount; i++) offsets[i + 1] = offsets[i] + remaining[i];
+
+                std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < triangleCount * 3; i++) adjacency[fill[t_indices[i]]++] = i / 3;
+
+                std::vector<int> cachePosition(t_vertexCount, -1);
+                std::vector<float> vertexScore(t_vertexCount), triangleScore(triangleCount, 0.0f);
+                std::vector<char> emitted(triangleCount, 0);
+
+                for (size_t i = 0; i < t_vertexCount; i++) vertexScore[i] = table.score(-1, remaining[i]);
+
+                int best = 0;
+
+                for (size_t i = 0; i < triangleCount; i++) {
+                    for (int j = 0; j < 3; j++) triangleScore[i] += vertexScore[t_indices[i * 3 + j]];
+                    if (triangleScore[i] > triangleScore[best]) best = i;
+                }
+
+                // three additional slots for the vertices pushed out by the last triangle
+                unsigned int cache[CacheSize + 3], newCache[CacheSize + 3];
+                int cacheCount = 0;
+                size_t cursor = 0;
+
+                std::vector<unsigned int> output;
+                output.reserve(triangleCount * 3);
+
+                for (size_t drawn = 0; drawn < triangleCount; drawn++) {
+                    // without candidates in the cache, continue with the next triangle in the original order
+                    if (best < 0) {
+                        while (emitted[cursor]) cursor++;
+                        best = cursor;
+                    }
+
+                    const unsigned int* corners = &t_indices[best * 3];
+                    int newCount = 0;
+
+                    emitted[best] = 1;
+
+                    for (int i = 0; i < 3; i++) {
+                        unsigned int vertex = corners[i];
+                        output.push_back(vertex);
+
+                        // move the triangle behind the ones of the vertex still to be drawn
+                        unsigned int* triangles = &adjacency[offsets[vertex]];
+                        for (unsigned int j = 0; j < remaining[vertex]; j++) {
+                            if (triangles[j] == static_cast<unsigned int>(best)) {
+                                triangles[j] = triangles[remaining[vertex] - 1];
+                                triangles[remaining[vertex] - 1] = best;
+                                break;
+                            }
+                        }
+
+                        remaining[vertex]--;
+                        newCache[newCount++] = vertex;
+                    }
+
+                    // the vertices of the triangle move to the front of the cache (LRU)
+                    for (int i = 0; i < cacheCount; i++) {
+                        unsigned int vertex = cache[i];
+                        if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2]) newCache[newCount++] = vertex;
+                    }
+
+                    memcpy(cache, newCache, sizeof(unsigned int) * newCount);
+                    cacheCount = newCount;
+                    best = -1;
+
+                    // update the scores of all vertices whose position changed, including the ones pushed out
+                    for (int i = 0; i < cacheCount; i++) {
+                        unsigned int vertex = cache[i];
+                        cachePosition[vertex] = (i < CacheSize ? i : -1);
+
+                        float score = table.score(cachePosition[vertex], remaining[vertex]),
+                              delta = score - vertexScore[vertex];
+
+                        vertexScore[vertex] = score;
+
+                        for (unsigned int j = 0; j < remaining[vertex]; j++) {
+                            unsigned int triangle = adjacency[offsets[vertex] + j];
+                            triangleScore[triangle] += delta;
+                        }
+                    }
+
+                    // the next triangle is the best one using a cached vertex
+                    float bestScore = -1.0f;
+
+                    for (int i = 0; i < cacheCount && i < CacheSize; i++) {
+                        unsigned int vertex = cache[i];
+
+                        for (unsigned int j = 0; j < remaining[vertex]; j++) {
+                            unsigned int triangle = adjacency[offsets[vertex] + j];
+
+                            if (triangleScore[triangle] > bestScore) {
+                                bestScore = triangleScore[triangle];
+                                best = triangle;
+                            }
+                        }
+                    }
+
+                    if (cacheCount > CacheSize) cacheCount = CacheSize;
+                }
+
+                t_indices.swap(output);
+            }
+        } /* vertexCache */
+    } /* priv */
+} /* m3d */
@@ -0,0 +1,283 @@
+/*
+ * meshconv - converts .obj-models (including their .mtl-material) into the binary .m3dm-format
+ *
+ * Usage: meshconv [-c] [-s <ratio>] [-e <error>] <input.obj> <output.m3dm>
+ *   -c          use the compact vertex format (16 instead of 32 bytes per vertex)
+ *   -s <ratio>  simplify the mesh to the given share of triangles (e.g. 0.5 and 0.25 for levels of detail)
+ *   -e <error>  the maximum deviation allowed when simplifying, relative to the size of the mesh (default: 0.05)
+ *
+ * The output matches what m3d::Model uploads for the same model: identical vertices get merged, reordered for
+ * the vertex cache and drawn using 16-bit indices (unless there are more than 65536 unique vertices).
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "m3d/private/meshFile.hpp"
+#include "m3d/private/objParser.hpp"
+#include "m3d/private/simplifier.hpp"
+#include "m3d/private/vertexCache.hpp"
+
+namespace {
+    typedef m3d::priv::obj::Vertex Vertex;
+
+    struct CompactVertex {
+        int16_t position[4];
+        int16_t texcoord[2];
+        int8_t normal[4];
+    };
+
+    struct VertexHash {
+        size_t operator()(const Vertex& t_vertex) const {
+            uint32_t words[sizeof(Vertex) / sizeof(uint32_t)];
+            size_t hash = 2166136261u;
+
+            memcpy(words, &t_vertex, sizeof(words));
+
+            for (unsigned int i = 0; i < sizeof(words) / sizeof(uint32_t); i++) {
+                hash = (hash ^ words[i]) * 16777619u;
+            }
+
+            return hash;
+        }
+    };
+
+    struct VertexEqual {
+        bool operator()(const Vertex& t_lhs, const Vertex& t_rhs) const {
+            return memcmp(&t_lhs, &t_rhs, sizeof(Vertex)) == 0;
+        }
+    };
+
+    uint8_t toColor(float t_value) {
+        return static_cast<uint8_t>(fmaxf(0.0f, fminf(255.0f, roundf(t_value * 255.0f))));
+    }
+
+    float scale(float t_min, float t_max) {
+        return (t_max > t_min ? (t_max - t_min) / 65534.0f : 1.0f);
+    }
+
+    int16_t quantize(float t_value, float t_offset, float t_scale) {
+        return static_cast<int16_t>(fmaxf(-32767.0f, fminf(32767.0f, roundf((t_value - t_offset) / t_scale))));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool compact = false, valid = true;
+    float ratio = 1.0f, maxError = 0.05f;
+    int argument = 1;
+
+    for (; argument < argc && argv[argument][0] == '-'; argument++) {
+        if (strcmp(argv[argument], "-c") == 0) {
+            compact = true;
+        } else if (strcmp(argv[argument], "-s") == 0 && argument + 1 < argc) {
+            ratio = strtof(argv[++argument], nullptr);
+            valid = valid && ratio > 0.0f && ratio <= 1.0f;
+        } else if (strcmp(argv[argument], "-e") == 0 && argument + 1 < argc) {
+            maxError = strtof(argv[++argument], nullptr);
+            valid = valid && maxError >= 0.0f;
+        } else {
+            valid = false;
+        }
+    }
+
+    if (!valid || argc - argument != 2) {
+        fprintf(stderr, "Usage: %s [-c] [-s <ratio>] [-e <error>] <input.obj> <output.m3dm>\n", argv[0]);
+        fprintf(stderr, "  -c          use the compact vertex format (16 instead of 32 bytes per vertex)\n");
+        fprintf(stderr, "  -s <ratio>  simplify the mesh to the given share of triangles (e.g. 0.5 and 0.25 for levels of detail)\n");
+        fprintf(stderr, "  -e <error>  the maximum deviation allowed when simplifying, relative to the size of the mesh (default: 0.05)\n");
+        return 1;
+    }
+
+    const char* input = argv[argument];
+    const char* output = argv[argument + 1];
+
+    m3d::priv::obj::Parser parser;
+
+    if (!parser.parseFile(input)) {
+        fprintf(stderr, "error: couldn't load '%s'\n", input);
+        return 1;
+    }
+
+    m3d::priv::meshFile::Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, m3d::priv::meshFile::magic, sizeof(header.magic));
+    header.version = m3d::priv::meshFile::version;
+
+    // weld identical vertices (the parser only merges vertices with the same attribute indices)
+    std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> lookup;
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<uint32_t> remap(parser.getVertices().size());
+
+    for (unsigned int i = 0; i < parser.getVertices().size(); i++) {
+        auto entry = lookup.emplace(parser.getVertices()[i], vertices.size());
+        if (entry.second) vertices.push_back(parser.getVertices()[i]);
+        remap[i] = entry.first->second;
+    }
+
+    indices.reserve(parser.getIndices().size());
+    for (uint32_t index : parser.getIndices()) indices.push_back(remap[index]);
+
+    if (ratio < 1.0f && indices.size() > 0) {
+        size_t triangles = indices.size() / 3;
+
+        float error = m3d::priv::simplify::simplify(indices, vertices[0].position, vertices.size(), sizeof(Vertex), static_cast<size_t>(triangles * ratio) * 3, maxError);
+        m3d::priv::vertexCache::optimizeVertexFetch(vertices, indices);
+
+        printf("%s: simplified %u to %u triangles (error: %g)\n", output, (unsigned int) triangles, (unsigned int) (indices.size() / 3), error);
+    }
+
+    if (parser.hasMaterial()) {
+        const m3d::priv::obj::Material& material = parser.getMaterial();
+
+        for (int i = 0; i < 3; i++) {
+            header.ambient[i] = toColor(material.ambient[i]);
+            header.diffuse[i] = toColor(material.diffuse[i]);
+            header.specular[i] = toColor(material.specular[i]);
+        }
+
+        header.flags |= m3d::priv::meshFile::hasMaterial;
+    }
+
+    // bounding box and bounding sphere (centered on the bounding box)
+    float min[3] = { 0.0f, 0.0f, 0.0f },
+          max[3] = { 0.0f, 0.0f, 0.0f },
+          minUv[2] = { 0.0f, 0.0f },
+          maxUv[2] = { 0.0f, 0.0f },
+          radius = 0.0f;
+
+    if (vertices.size() > 0) {
+        for (int i = 0; i < 3; i++) min[i] = max[i] = vertices[0].position[i];
+        for (int i = 0; i < 2; i++) minUv[i] = maxUv[i] = vertices[0].texcoord[i];
+    }
+
+    for (const auto& vertex : vertices) {
+        for (int i = 0; i < 3; i++) {
+            min[i] = fminf(min[i], vertex.position[i]);
+            max[i] = fmaxf(max[i], vertex.position[i]);
+        }
+
+        for (int i = 0; i < 2; i++) {
+            minUv[i] = fminf(minUv[i], vertex.texcoord[i]);
+            maxUv[i] = fmaxf(maxUv[i], vertex.texcoord[i]);
+        }
+    }
+
+    for (const auto& vertex : vertices) {
+        float distance = 0.0f;
+
+        for (int i = 0; i < 3; i++) {
+            float delta = vertex.position[i] - (min[i] + max[i]) / 2;
+            distance += delta * delta;
+        }
+
+        radius = fmaxf(radius, distance);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        header.boundingMin[i] = min[i];
+        header.boundingMax[i] = max[i];
+    }
+
+    header.boundingRadius = (vertices.size() > 0 ? sqrtf(radius) * 1.001f + 0.0001f : 0.0f);
+
+    // the GPU only supports 16-bit indices, bigger meshes get stored without an index buffer
+    bool indexed = vertices.size() <= 0x10000;
+
+    // the triangles of .obj-files are in no particular order, reorder them for the vertex cache of the GPU
+    if (indexed && indices.size() > 0) {
+        float before = m3d::priv::vertexCache::getAcmr(indices.data(), indices.size(), vertices.size());
+
+        m3d::priv::vertexCache::optimizeTriangles(indices, vertices.size());
+        m3d::priv::vertexCache::optimizeVertexFetch(vertices, indices);
+
+        printf("%s: ACMR %.3f -> %.3f\n", output, before, m3d::priv::vertexCache::getAcmr(indices.data(), indices.size(), vertices.size()));
+    }
+    std::vector<Vertex> ordered;
+
+    if (indexed) {
+        ordered.swap(vertices);
+    } else {
+        ordered.reserve(indices.size());
+        for (uint32_t index : indices) ordered.push_back(vertices[index]);
+    }
+
+    header.format = compact ? m3d::priv::meshFile::CompactFormat : m3d::priv::meshFile::FloatFormat;
+    header.stride = compact ? m3d::priv::meshFile::compactStride : m3d::priv::meshFile::floatStride;
+    header.vertexCount = ordered.size();
+    header.indexCount = indexed ? indices.size() : 0;
+    header.vertexOffset = sizeof(header);
+    header.indexOffset = header.vertexOffset + header.vertexCount * header.stride;
+
+    std::vector<uint8_t> vertexBlob(header.vertexCount * header.stride);
+
+    if (compact) {
+        header.attributes[0] = { m3d::priv::meshFile::Short, 4 };
+        header.attributes[1] = { m3d::priv::meshFile::Short, 2 };
+        header.attributes[2] = { m3d::priv::meshFile::Byte, 4 };
+
+        float quantization[3][4] = {
+            { scale(min[0], max[0]), scale(min[1], max[1]), scale(min[2], max[2]), 0.0f },
+            { (min[0] + max[0]) / 2, (min[1] + max[1]) / 2, (min[2] + max[2]) / 2, 0.0f },
+            { scale(minUv[0], maxUv[0]), scale(minUv[1], maxUv[1]), (minUv[0] + maxUv[0]) / 2, (minUv[1] + maxUv[1]) / 2 }
+        };
+
+        memcpy(header.quantization, quantization, sizeof(quantization));
+
+        for (unsigned int i = 0; i < ordered.size(); i++) {
+            CompactVertex vertex;
+
+            for (int j = 0; j < 3; j++) {
+                vertex.position[j] = quantize(ordered[i].position[j], quantization[1][j], quantization[0][j]);
+                vertex.normal[j] = static_cast<int8_t>(fmaxf(-127.0f, fminf(127.0f, roundf(ordered[i].normal[j] * 127.0f))));
+            }
+
+            vertex.position[3] = 0;
+            vertex.normal[3] = 0;
+            vertex.texcoord[0] = quantize(ordered[i].texcoord[0], quantization[2][2], quantization[2][0]);
+            vertex.texcoord[1] = quantize(ordered[i].texcoord[1], quantization[2][3], quantization[2][1]);
+
+            memcpy(&vertexBlob[i * sizeof(CompactVertex)], &vertex, sizeof(CompactVertex));
+        }
+    } else {
+        header.attributes[0] = { m3d::priv::meshFile::Float, 3 };
+        header.attributes[1] = { m3d::priv::meshFile::Float, 2 };
+        header.attributes[2] = { m3d::priv::meshFile::Float, 3 };
+
+        float quantization[3][4] = {
+            { 1.0f, 1.0f, 1.0f, 0.0f },
+            { 0.0f, 0.0f, 0.0f, 0.0f },
+            { 1.0f, 1.0f, 0.0f, 0.0f }
+        };
+
+        memcpy(header.quantization, quantization, sizeof(quantization));
+        if (ordered.size() > 0) memcpy(vertexBlob.data(), ordered.data(), vertexBlob.size());
+    }
+
+    std::vector<uint16_t> indexBlob(header.indexCount);
+    for (unsigned int i = 0; i < header.indexCount; i++) indexBlob[i] = indices[i];
+
+    FILE* file = fopen(output, "wb");
+
+    if (!file) {
+        fprintf(stderr, "error: couldn't open '%s' for writing\n", output);
+        return 1;
+    }
+
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(vertexBlob.data(), 1, vertexBlob.size(), file) == vertexBlob.size() &&
+                   fwrite(indexBlob.data(), sizeof(uint16_t), indexBlob.size(), file) == indexBlob.size();
+
+    fclose(file);
+
+    if (!success) {
+        fprintf(stderr, "error: couldn't write '%s'\n", output);
+        return 1;
+    }
+
+    printf("%s: %u vertices, %u indices, %u bytes\n", output, header.vertexCount, header.indexCount, (unsigned int) (sizeof(header) + vertexBlob.size() + indexBlob.size() * sizeof(uint16_t)));
+    return 0;
+}
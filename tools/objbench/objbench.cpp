@@ -0,0 +1,218 @@
+/*
+ * objbench - compares the .obj-parser of m3d::Model with the previous loader (OBJ_Loader.h)
+ *
+ * Usage: objbench <file.obj>...
+ *        objbench --generate <directory>
+ *
+ * Every file gets loaded by both loaders, the output shows the resulting number of vertices and indices, the
+ * best time out of several runs and the peak heap usage during loading. --generate writes a synthetic corpus
+ * (grids with and without normals, spheres and a model made of quads) to the given directory.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "OBJ_Loader.h"
+#include "m3d/private/objParser.hpp"
+
+namespace {
+    const int runs = 5;
+
+    size_t currentMemory = 0, peakMemory = 0;
+
+    struct Result {
+        size_t vertices, indices;
+        double milliseconds;
+        size_t peak;
+    };
+
+    template<typename Function>
+    Result measure(Function t_function) {
+        Result result = { 0, 0, 1e30, 0 };
+
+        for (int i = 0; i < runs; i++) {
+            size_t base = currentMemory;
+            peakMemory = currentMemory;
+
+            auto start = std::chrono::steady_clock::now();
+            t_function(result);
+            auto end = std::chrono::steady_clock::now();
+
+            result.milliseconds = fmin(result.milliseconds, std::chrono::duration<double, std::milli>(end - start).count());
+            result.peak = peakMemory - base;
+        }
+
+        return result;
+    }
+
+    bool writeGrid(const std::string& t_path, int t_size, bool t_normals, bool t_quads) {
+        FILE* file = fopen(t_path.c_str(), "w");
+        if (!file) return false;
+
+        fprintf(file, "# %dx%d grid\no grid\n", t_size, t_size);
+
+        for (int y = 0; y <= t_size; y++) {
+            for (int x = 0; x <= t_size; x++) {
+                float height = sinf(x * 0.1f) * cosf(y * 0.1f);
+                fprintf(file, "v %f %f %f\n", x / (float) t_size - 0.5f, height * 0.1f, y / (float) t_size - 0.5f);
+                fprintf(file, "vt %f %f\n", x / (float) t_size, y / (float) t_size);
+                if (t_normals) fprintf(file, "vn %f %f %f\n", 0.0f, 1.0f, 0.0f);
+            }
+        }
+
+        for (int y = 0; y < t_size; y++) {
+            for (int x = 0; x < t_size; x++) {
+                int a = y * (t_size + 1) + x + 1, b = a + 1, c = a + t_size + 1, d = c + 1;
+
+                if (t_normals) {
+                    if (t_quads) {
+                        fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, d, d, d, b, b, b);
+                    } else {
+                        fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, d, d, d);
+                        fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, d, d, d, b, b, b);
+                    }
+                } else {
+                    fprintf(file, "f %d/%d %d/%d %d/%d\n", a, a, c, c, d, d);
+                    fprintf(file, "f %d/%d %d/%d %d/%d\n", a, a, d, d, b, b);
+                }
+            }
+        }
+
+        fclose(file);
+        return true;
+    }
+
+    bool writeSphere(const std::string& t_path, int t_rings, int t_segments) {
+        FILE* file = fopen(t_path.c_str(), "w");
+        if (!file) return false;
+
+        fprintf(file, "# sphere with %d rings and %d segments\no sphere\n", t_rings, t_segments);
+
+        for (int ring = 0; ring <= t_rings; ring++) {
+            for (int segment = 0; segment <= t_segments; segment++) {
+                float theta = ring * 3.14159265f / t_rings, phi = segment * 2.0f * 3.14159265f / t_segments;
+                float x = sinf(theta) * cosf(phi), y = cosf(theta), z = sinf(theta) * sinf(phi);
+
+                fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", x, y, z, segment / (float) t_segments, ring / (float) t_rings, x, y, z);
+            }
+        }
+
+        for (int ring = 0; ring < t_rings; ring++) {
+            for (int segment = 0; segment < t_segments; segment++) {
+                int a = ring * (t_segments + 1) + segment + 1, b = a + 1, c = a + t_segments + 1, d = c + 1;
+
+                fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, d, d, d);
+                fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, d, d, d, b, b, b);
+            }
+        }
+
+        fclose(file);
+        return true;
+    }
+}
+
+// track the heap usage of both loaders
+__attribute__((noinline)) void* operator new(size_t t_size) {
+    size_t* block = static_cast<size_t*>(malloc(t_size + sizeof(size_t) * 2));
+    if (!block) throw std::bad_alloc();
+
+    block[0] = t_size;
+    currentMemory += t_size;
+    if (currentMemory > peakMemory) peakMemory = currentMemory;
+
+    return block + 2;
+}
+
+void* operator new[](size_t t_size) {
+    return operator new(t_size);
+}
+
+void* operator new(size_t t_size, const std::nothrow_t&) noexcept {
+    size_t* block = static_cast<size_t*>(malloc(t_size + sizeof(size_t) * 2));
+    if (!block) return nullptr;
+
+    block[0] = t_size;
+    currentMemory += t_size;
+    if (currentMemory > peakMemory) peakMemory = currentMemory;
+
+    return block + 2;
+}
+
+void* operator new[](size_t t_size, const std::nothrow_t& t_nothrow) noexcept {
+    return operator new(t_size, t_nothrow);
+}
+
+__attribute__((noinline)) void operator delete(void* t_pointer) noexcept {
+    if (!t_pointer) return;
+
+    size_t* block = static_cast<size_t*>(t_pointer) - 2;
+    currentMemory -= block[0];
+    free(block);
+}
+
+void operator delete[](void* t_pointer) noexcept {
+    operator delete(t_pointer);
+}
+
+void operator delete(void* t_pointer, size_t) noexcept {
+    operator delete(t_pointer);
+}
+
+void operator delete[](void* t_pointer, size_t) noexcept {
+    operator delete(t_pointer);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--generate") {
+        std::string directory = std::string(argv[2]) + "/";
+
+        bool success = writeGrid(directory + "grid_64.obj", 64, true, false) &&
+                       writeGrid(directory + "grid_256.obj", 256, true, false) &&
+                       writeGrid(directory + "grid_256_nonormals.obj", 256, false, false) &&
+                       writeGrid(directory + "grid_256_quads.obj", 256, true, true) &&
+                       writeSphere(directory + "sphere_32.obj", 32, 64) &&
+                       writeSphere(directory + "sphere_128.obj", 128, 256);
+
+        if (!success) {
+            fprintf(stderr, "error: couldn't write the corpus to '%s'\n", argv[2]);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <file.obj>...\n", argv[0]);
+        fprintf(stderr, "       %s --generate <directory>\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-32s %-8s %9s %9s %10s %12s\n", "file", "loader", "vertices", "indices", "time (ms)", "peak (KiB)");
+
+    for (int i = 1; i < argc; i++) {
+        std::string path = argv[i];
+        std::string name = path.substr(path.find_last_of('/') + 1);
+
+        Result previous = measure([&](Result& t_result) {
+            objl::Loader loader;
+            loader.LoadFile(path);
+            t_result.vertices = loader.LoadedVertices.size();
+            t_result.indices = loader.LoadedIndices.size();
+        });
+
+        Result current = measure([&](Result& t_result) {
+            m3d::priv::obj::Parser parser;
+            parser.parseFile(path);
+            t_result.vertices = parser.getVertices().size();
+            t_result.indices = parser.getIndices().size();
+        });
+
+        printf("%-32s %-8s %9zu %9zu %10.2f %12zu\n", name.c_str(), "objl", previous.vertices, previous.indices, previous.milliseconds, previous.peak / 1024);
+        printf("%-32s %-8s %9zu %9zu %10.2f %12zu\n", "", "m3d", current.vertices, current.indices, current.milliseconds, current.peak / 1024);
+        printf("%-32s %-8s %8.1fx %9s %10s %11.1fx\n", "", "speedup", previous.milliseconds / current.milliseconds, "", "", (double) previous.peak / current.peak);
+    }
+
+    return 0;
+}
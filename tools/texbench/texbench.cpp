@@ -0,0 +1,268 @@
+/*
+ * texbench - compares the .png-loading of m3d::Texture with the previous loader
+ *
+ * Usage: texbench <file.png>...
+ *        texbench --generate <directory>
+ *
+ * Every file gets loaded into a tiled RGBA8 texture by both loaders. The output shows the best time out of
+ * several runs for the whole load and for the tiling alone (on already decoded rows), the memory the previous
+ * loader allocated per row (and never freed) and whether the tiled output matches a per-pixel reference.
+ * --generate writes a synthetic corpus (different sizes, color types and an interlaced image) to the given
+ * directory.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "m3d/private/pngReader.hpp"
+#include "m3d/private/tiling.hpp"
+
+namespace {
+    const int runs = 5;
+
+    template<typename Function>
+    double measure(Function t_function) {
+        double best = 1e30;
+
+        for (int i = 0; i < runs; i++) {
+            auto start = std::chrono::steady_clock::now();
+            t_function();
+            auto end = std::chrono::steady_clock::now();
+
+            best = fmin(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        return best;
+    }
+
+    uint32_t getNextPow2(uint32_t v) {
+        v--;
+        v |= v >> 1;
+        v |= v >> 2;
+        v |= v >> 4;
+        v |= v >> 8;
+        v |= v >> 16;
+        v++;
+        return v >= 64 ? v : 64;
+    }
+
+    // the previous per-pixel tiling (including its use of the height for the number of tiles per row)
+    void tileLegacy(png_bytep* t_rows, uint32_t t_width, uint32_t t_height, char* t_texels) {
+        for (uint32_t j = 0; j < t_height; j++) {
+            png_bytep row = t_rows[j];
+
+            for (uint32_t i = 0; i < t_width; i++) {
+                png_bytep px = &(row[i * 4]);
+                uint32_t dst = ((((j >> 3) * (getNextPow2(t_height) >> 3) + (i >> 3)) << 6) + ((i & 1) | ((j & 1) << 1) | ((i & 2) << 1) | ((j & 2) << 2) | ((i & 4) << 2) | ((j & 4) << 3))) * 4;
+
+                memcpy(t_texels + dst, px, sizeof(uint32_t));
+            }
+        }
+    }
+
+    void tileReference(png_bytep* t_rows, uint32_t t_width, uint32_t t_height, uint32_t t_textureWidth, uint32_t* t_texels) {
+        for (uint32_t y = 0; y < t_height; y++) {
+            for (uint32_t x = 0; x < t_width; x++) {
+                uint32_t morton = 0;
+
+                for (int bit = 0; bit < 3; bit++) morton |= (((x >> bit) & 1) << (bit * 2)) | (((y >> bit) & 1) << (bit * 2 + 1));
+                memcpy(&t_texels[((y >> 3) * (t_textureWidth >> 3) + (x >> 3)) * 64 + morton], &t_rows[y][x * 4], sizeof(uint32_t));
+            }
+        }
+    }
+
+    // the previous loader: every row gets its own allocation, which never got freed
+    bool loadLegacy(const std::string& t_path, std::vector<png_bytep>& t_rows, uint32_t& t_width, uint32_t& t_height, size_t& t_allocated) {
+        FILE* file = fopen(t_path.c_str(), "rb");
+        if (!file) return false;
+
+        png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        png_infop info = png_create_info_struct(png);
+
+        if (setjmp(png_jmpbuf(png))) {
+            png_destroy_read_struct(&png, &info, NULL);
+            fclose(file);
+            return false;
+        }
+
+        png_set_read_fn(png, (png_voidp) file, [](png_structp ptr, png_bytep data, png_size_t len) {
+            if (fread(data, 1, len, (FILE*) png_get_io_ptr(ptr)) != len) png_error(ptr, "read error");
+        });
+
+        png_read_info(png, info);
+
+        t_width = png_get_image_width(png, info);
+        t_height = png_get_image_height(png, info);
+
+        png_byte color_type = png_get_color_type(png, info);
+        png_byte bit_depth  = png_get_bit_depth(png, info);
+
+        if (bit_depth == 16) png_set_strip_16(png);
+        if (color_type == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(png);
+        if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) png_set_expand_gray_1_2_4_to_8(png);
+        if (png_get_valid(png, info, PNG_INFO_tRNS)) png_set_tRNS_to_alpha(png);
+        if (color_type == PNG_COLOR_TYPE_RGB || color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_PALETTE) png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
+        if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA) png_set_gray_to_rgb(png);
+
+        png_set_bgr(png);
+        png_set_swap_alpha(png);
+        png_read_update_info(png, info);
+
+        t_rows.resize(t_height);
+        t_allocated = sizeof(png_bytep) * t_height;
+
+        for (uint32_t y = 0; y < t_height; y++) {
+            t_rows[y] = (png_byte*) malloc(png_get_rowbytes(png, info));
+            t_allocated += png_get_rowbytes(png, info);
+        }
+
+        png_read_image(png, t_rows.data());
+        png_destroy_read_struct(&png, &info, NULL);
+        fclose(file);
+        return true;
+    }
+
+    void freeRows(std::vector<png_bytep>& t_rows) {
+        for (auto row : t_rows) free(row);
+        t_rows.clear();
+    }
+
+    bool loadCurrent(const std::string& t_path, std::vector<uint32_t>& t_texels, uint32_t t_textureWidth) {
+        FILE* file = fopen(t_path.c_str(), "rb");
+        if (!file) return false;
+
+        m3d::priv::image::PngReader reader;
+        bool success = reader.open(file) && reader.readTiled(t_texels.data(), t_textureWidth);
+
+        fclose(file);
+        return success;
+    }
+
+    bool writePng(const std::string& t_path, uint32_t t_width, uint32_t t_height, int t_colorType, bool t_interlaced) {
+        FILE* file = fopen(t_path.c_str(), "wb");
+        if (!file) return false;
+
+        png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        png_infop info = png_create_info_struct(png);
+
+        if (setjmp(png_jmpbuf(png))) {
+            png_destroy_write_struct(&png, &info);
+            fclose(file);
+            return false;
+        }
+
+        png_init_io(png, file);
+        png_set_IHDR(png, info, t_width, t_height, 8, t_colorType, t_interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+        std::vector<png_color> palette(256);
+
+        if (t_colorType == PNG_COLOR_TYPE_PALETTE) {
+            for (int i = 0; i < 256; i++) palette[i] = { (png_byte) i, (png_byte) (255 - i), (png_byte) (i * 7) };
+            png_set_PLTE(png, info, palette.data(), 256);
+        }
+
+        png_write_info(png, info);
+
+        int channels = (t_colorType == PNG_COLOR_TYPE_RGBA ? 4 : t_colorType == PNG_COLOR_TYPE_RGB ? 3 : t_colorType == PNG_COLOR_TYPE_GRAY_ALPHA ? 2 : 1);
+        std::vector<png_byte> image(t_width * t_height * channels);
+        std::vector<png_bytep> rows(t_height);
+
+        // smooth gradients with some noise, so the images compress like real textures
+        for (uint32_t y = 0; y < t_height; y++) {
+            rows[y] = &image[y * t_width * channels];
+
+            for (uint32_t x = 0; x < t_width * channels; x++) {
+                rows[y][x] = (png_byte) (128 + 100 * sinf(x * 0.05f + (x % channels)) * cosf(y * 0.07f) + (rand() % 16));
+            }
+        }
+
+        png_write_image(png, rows.data());
+        png_write_end(png, NULL);
+        png_destroy_write_struct(&png, &info);
+        fclose(file);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--generate") {
+        std::string directory = std::string(argv[2]) + "/";
+
+        bool success = writePng(directory + "rgba_64x64.png", 64, 64, PNG_COLOR_TYPE_RGBA, false) &&
+                       writePng(directory + "rgba_256x256.png", 256, 256, PNG_COLOR_TYPE_RGBA, false) &&
+                       writePng(directory + "rgba_1024x1024.png", 1024, 1024, PNG_COLOR_TYPE_RGBA, false) &&
+                       writePng(directory + "rgb_512x256.png", 512, 256, PNG_COLOR_TYPE_RGB, false) &&
+                       writePng(directory + "palette_1024x512.png", 1024, 512, PNG_COLOR_TYPE_PALETTE, false) &&
+                       writePng(directory + "gray_alpha_300x200.png", 300, 200, PNG_COLOR_TYPE_GRAY_ALPHA, false) &&
+                       writePng(directory + "rgba_interlaced_512x512.png", 512, 512, PNG_COLOR_TYPE_RGBA, true);
+
+        if (!success) {
+            fprintf(stderr, "error: couldn't write the corpus to '%s'\n", argv[2]);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <file.png>...\n", argv[0]);
+        fprintf(stderr, "       %s --generate <directory>\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-28s %-8s %10s %10s %12s %8s\n", "file", "loader", "load (ms)", "tile (ms)", "leaked (KiB)", "output");
+
+    for (int i = 1; i < argc; i++) {
+        std::string path = argv[i];
+        std::string name = path.substr(path.find_last_of('/') + 1);
+
+        std::vector<png_bytep> rows;
+        uint32_t width, height;
+        size_t leaked = 0;
+
+        if (!loadLegacy(path, rows, width, height, leaked)) {
+            fprintf(stderr, "error: couldn't load '%s'\n", path.c_str());
+            continue;
+        }
+
+        // the previous tiling used the height for the number of tiles per row, so it writes outside of non-square textures
+        uint32_t textureWidth = getNextPow2(width), textureHeight = getNextPow2(height), legacySize = std::max(textureWidth, textureHeight);
+        std::vector<uint32_t> legacy(legacySize * legacySize), current(textureWidth * textureHeight), reference(textureWidth * textureHeight);
+        std::vector<uint32_t> columnOffsets(width);
+
+        tileReference(rows.data(), width, height, textureWidth, reference.data());
+        bool matches = loadCurrent(path, current, textureWidth) && current == reference;
+
+        double previousTile = measure([&]() { tileLegacy(rows.data(), width, height, reinterpret_cast<char*>(legacy.data())); });
+        double currentTile = measure([&]() {
+            m3d::priv::tiling::buildColumnOffsets(columnOffsets.data(), width);
+
+            for (uint32_t y = 0; y < height; y++) {
+                m3d::priv::tiling::writeRow(current.data(), columnOffsets.data(), reinterpret_cast<const uint32_t*>(rows[y]), width, y, textureWidth);
+            }
+        });
+
+        freeRows(rows);
+
+        double previousLoad = measure([&]() {
+            std::vector<png_bytep> legacyRows;
+            uint32_t legacyWidth, legacyHeight;
+            size_t allocated;
+
+            loadLegacy(path, legacyRows, legacyWidth, legacyHeight, allocated);
+            tileLegacy(legacyRows.data(), legacyWidth, legacyHeight, reinterpret_cast<char*>(legacy.data()));
+            freeRows(legacyRows);
+        });
+
+        double currentLoad = measure([&]() { loadCurrent(path, current, textureWidth); });
+
+        printf("%-28s %-8s %10.2f %10.3f %12zu %8s\n", name.c_str(), "previous", previousLoad, previousTile, leaked / 1024, (width == height || textureWidth == textureHeight ? "ok" : "broken"));
+        printf("%-28s %-8s %10.2f %10.3f %12d %8s\n", "", "m3d", currentLoad, currentTile, 0, matches ? "ok" : "MISMATCH");
+        printf("%-28s %-8s %9.1fx %9.1fx\n", "", "speedup", previousLoad / currentLoad, previousTile / currentTile);
+    }
+
+    return 0;
+}
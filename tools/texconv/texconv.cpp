@@ -0,0 +1,343 @@
+/*
+ * texconv - converts .png-images into the binary .m3dt-format
+ *
+ * Usage: texconv [-f <format>] [-m] <input.png> <output.m3dt>
+ *   -f <format>  the format of the texture: rgba8 (default), rgba5551, rgb565, rgba4, la8, etc1 or etc1a4
+ *   -m           generate mipmaps (box-filtered, down to 8x8 pixels)
+ *
+ * The output matches what m3d::Texture creates for the same image (the size rounded to the next power of 2, at
+ * least 64, with a transparent padding), so it can be read straight into the texture. The 16-bit formats halve
+ * the size of the texture, ETC1 divides it by 8 (ETC1A4 by 4), the PSNR of the result gets printed for the
+ * lossy formats. Mipmaps get generated the same way m3d::Texture generates them at runtime, compressed textures can
+ * only get mipmaps here.
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "m3d/private/mipmap.hpp"
+#include "m3d/private/pngReader.hpp"
+#include "m3d/private/texelFormat.hpp"
+#include "m3d/private/textureFile.hpp"
+#include "m3d/private/tiling.hpp"
+
+namespace {
+    struct FormatName {
+        const char* name;
+        m3d::priv::texel::Format format;
+    };
+
+    const FormatName formats[] = {
+        { "rgba8", m3d::priv::texel::RGBA8 },
+        { "rgba5551", m3d::priv::texel::RGBA5551 },
+        { "rgb565", m3d::priv::texel::RGB565 },
+        { "rgba4", m3d::priv::texel::RGBA4 },
+        { "la8", m3d::priv::texel::LA8 },
+        { "etc1", m3d::priv::texel::ETC1 },
+        { "etc1a4", m3d::priv::texel::ETC1A4 }
+    };
+
+    const int Etc1Modifiers[8][2] = {
+        { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+    };
+
+    uint32_t getNextPow2(uint32_t v) {
+        v--;
+        v |= v >> 1;
+        v |= v >> 2;
+        v |= v >> 4;
+        v |= v >> 8;
+        v |= v >> 16;
+        v++;
+        return v >= 64 ? v : 64;
+    }
+
+    int clamp(int t_value) {
+        return t_value < 0 ? 0 : (t_value > 255 ? 255 : t_value);
+    }
+
+    uint32_t expand(int t_value, int t_bits) {
+        return (t_value << (8 - t_bits)) | (t_value >> (2 * t_bits - 8));
+    }
+
+    // converts a 16-bit texel back into a 32-bit pixel
+    uint32_t decodeTexel(uint16_t t_texel, m3d::priv::texel::Format t_format) {
+        uint32_t r, g, b, a;
+
+        switch (t_format) {
+            case m3d::priv::texel::RGBA5551:
+                r = expand(t_texel >> 11, 5);
+                g = expand((t_texel >> 6) & 0x1F, 5);
+                b = expand((t_texel >> 1) & 0x1F, 5);
+                a = (t_texel & 1) * 255;
+                break;
+            case m3d::priv::texel::RGB565:
+                r = expand(t_texel >> 11, 5);
+                g = expand((t_texel >> 5) & 0x3F, 6);
+                b = expand(t_texel & 0x1F, 5);
+                a = 255;
+                break;
+            case m3d::priv::texel::RGBA4:
+                r = (t_texel >> 12) * 17;
+                g = ((t_texel >> 8) & 0xF) * 17;
+                b = ((t_texel >> 4) & 0xF) * 17;
+                a = (t_texel & 0xF) * 17;
+                break;
+            default:
+                r = g = b = t_texel >> 8;
+                a = t_texel & 0xFF;
+                break;
+        }
+
+        return (r << 24) | (g << 16) | (b << 8) | a;
+    }
+
+    // decodes an ETC1 block (and its alpha) into 16 pixels, row by row
+    void decodeEtc1Block(uint64_t t_block, uint64_t t_alpha, uint32_t t_pixels[16]) {
+        uint32_t high = t_block >> 32, low = static_cast<uint32_t>(t_block);
+        bool flip = high & 1, differential = high & 2;
+        int colors[2][3];
+
+        for (int c = 0; c < 3; c++) {
+            if (differential) {
+                int base = (high >> (27 - c * 8)) & 0x1F,
+                    delta = (high >> (24 - c * 8)) & 7;
+
+                colors[0][c] = expand(base, 5);
+                colors[1][c] = expand((base + (delta >= 4 ? delta - 8 : delta)) & 0x1F, 5);
+            } else {
+                colors[0][c] = ((high >> (28 - c * 8)) & 0xF) * 17;
+                colors[1][c] = ((high >> (24 - c * 8)) & 0xF) * 17;
+            }
+        }
+
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++) {
+                int position = x * 4 + y,
+                    subblock = (flip ? y >= 2 : x >= 2),
+                    table = (high >> (subblock ? 2 : 5)) & 7,
+                    selector = (((low >> (position + 16)) & 1) << 1) | ((low >> position) & 1),
+                    modifier = (selector & 2 ? -1 : 1) * Etc1Modifiers[table][selector & 1];
+
+                uint32_t alpha = ((t_alpha >> (position * 4)) & 0xF) * 17;
+                t_pixels[y * 4 + x] = (clamp(colors[subblock][0] + modifier) << 24) | (clamp(colors[subblock][1] + modifier) << 16) | (clamp(colors[subblock][2] + modifier) << 8) | alpha;
+            }
+        }
+    }
+
+    // converts the texture back into pixels, to measure its quality
+    std::vector<uint32_t> decodeTexture(const std::vector<uint8_t>& t_data, m3d::priv::texel::Format t_format, uint32_t t_textureWidth, uint32_t t_textureHeight) {
+        std::vector<uint32_t> pixels(t_textureWidth * t_textureHeight);
+
+        if (m3d::priv::texel::isCompressed(t_format)) {
+            const uint8_t* block = t_data.data();
+
+            for (uint32_t tileY = 0; tileY < t_textureHeight; tileY += 8) {
+                for (uint32_t tileX = 0; tileX < t_textureWidth; tileX += 8) {
+                    for (int i = 0; i < 4; i++) {
+                        uint64_t alpha = ~0ull, color;
+                        uint32_t decoded[16];
+
+                        if (t_format == m3d::priv::texel::ETC1A4) {
+                            memcpy(&alpha, block, sizeof(alpha));
+                            block += sizeof(alpha);
+                        }
+
+                        memcpy(&color, block, sizeof(color));
+                        block += sizeof(color);
+                        decodeEtc1Block(color, alpha, decoded);
+
+                        for (int y = 0; y < 4; y++) {
+                            for (int x = 0; x < 4; x++) pixels[(tileY + (i >> 1) * 4 + y) * t_textureWidth + tileX + (i & 1) * 4 + x] = decoded[y * 4 + x];
+                        }
+                    }
+                }
+            }
+        } else {
+            for (uint32_t y = 0; y < t_textureHeight; y++) {
+                for (uint32_t x = 0; x < t_textureWidth; x++) {
+                    uint32_t offset = m3d::priv::tiling::getRowOffset(y, t_textureWidth) + m3d::priv::tiling::getColumnOffset(x);
+
+                    if (t_format == m3d::priv::texel::RGBA8) {
+                        memcpy(&pixels[y * t_textureWidth + x], &t_data[offset * 4], sizeof(uint32_t));
+                    } else {
+                        uint16_t texel;
+                        memcpy(&texel, &t_data[offset * 2], sizeof(texel));
+                        pixels[y * t_textureWidth + x] = decodeTexel(texel, t_format);
+                    }
+                }
+            }
+        }
+
+        return pixels;
+    }
+
+    // the peak signal-to-noise ratio of the image (the channels the format stores)
+    double getPsnr(const std::vector<uint32_t>& t_image, const std::vector<uint32_t>& t_decoded, uint32_t t_width, uint32_t t_height, uint32_t t_textureWidth, m3d::priv::texel::Format t_format) {
+        bool color = t_format != m3d::priv::texel::LA8,
+             alpha = t_format != m3d::priv::texel::RGB565 && t_format != m3d::priv::texel::ETC1;
+        double error = 0.0;
+        size_t samples = 0;
+
+        for (uint32_t y = 0; y < t_height; y++) {
+            for (uint32_t x = 0; x < t_width; x++) {
+                uint32_t original = t_image[y * t_width + x], decoded = t_decoded[y * t_textureWidth + x];
+
+                if (!color) {
+                    // compare against the luminance for greyscale
+                    original = (m3d::priv::texel::toLa8(original) >> 8) * 0x01010100 | (original & 0xFF);
+                }
+
+                for (int shift = (alpha ? 0 : 8); shift < 32; shift += 8) {
+                    double delta = static_cast<int>((original >> shift) & 0xFF) - static_cast<int>((decoded >> shift) & 0xFF);
+                    error += delta * delta;
+                    samples++;
+                }
+            }
+        }
+
+        return error > 0.0 ? 10.0 * log10(255.0 * 255.0 * samples / error) : INFINITY;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    m3d::priv::texel::Format format = m3d::priv::texel::RGBA8;
+    const char* formatName = "rgba8";
+    bool mipmaps = false, valid = true;
+    int argument = 1;
+
+    for (; argument < argc && argv[argument][0] == '-'; argument++) {
+        if (strcmp(argv[argument], "-f") == 0 && argument + 1 < argc) {
+            formatName = argv[++argument];
+            valid = false;
+
+            for (const auto& entry : formats) {
+                if (strcmp(entry.name, formatName) == 0) {
+                    format = entry.format;
+                    valid = true;
+                }
+            }
+
+            if (!valid) break;
+        } else if (strcmp(argv[argument], "-m") == 0) {
+            mipmaps = true;
+        } else {
+            valid = false;
+        }
+    }
+
+    if (!valid || argc - argument != 2) {
+        fprintf(stderr, "Usage: %s [-f <format>] [-m] <input.png> <output.m3dt>\n", argv[0]);
+        fprintf(stderr, "  -f <format>  the format of the texture: rgba8 (default), rgba5551, rgb565, rgba4, la8, etc1 or etc1a4\n");
+        fprintf(stderr, "  -m           generate mipmaps (box-filtered, down to 8x8 pixels)\n");
+        return 1;
+    }
+
+    const char* input = argv[argument];
+    const char* output = argv[argument + 1];
+
+    FILE* file = fopen(input, "rb");
+    m3d::priv::image::PngReader reader;
+
+    if (!file || !reader.open(file)) {
+        fprintf(stderr, "error: couldn't load '%s'\n", input);
+        if (file) fclose(file);
+        return 1;
+    }
+
+    uint32_t width = reader.getWidth(), height = reader.getHeight(),
+             textureWidth = getNextPow2(width), textureHeight = getNextPow2(height);
+
+    if (textureWidth > 1024 || textureHeight > 1024) {
+        fprintf(stderr, "error: '%s' is bigger than 1024x1024 pixels\n", input);
+        fclose(file);
+        return 1;
+    }
+
+    std::vector<uint32_t> image(width * height);
+    bool success = reader.read(image.data());
+    fclose(file);
+
+    if (!success) {
+        fprintf(stderr, "error: couldn't load '%s'\n", input);
+        return 1;
+    }
+
+    m3d::priv::textureFile::Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, m3d::priv::textureFile::magic, sizeof(header.magic));
+    header.version = m3d::priv::textureFile::version;
+    header.format = format;
+    header.width = width;
+    header.height = height;
+    header.textureWidth = textureWidth;
+    header.textureHeight = textureHeight;
+    header.dataOffset = sizeof(header);
+    header.levels = (mipmaps ? m3d::priv::mipmap::getLevelCount(textureWidth, textureHeight) : 1);
+    header.dataSize = m3d::priv::mipmap::getTotalSize(textureWidth, textureHeight, header.levels, m3d::priv::texel::getBitsPerTexel(format));
+
+    std::vector<uint8_t> data(header.dataSize, 0);
+
+    if (m3d::priv::texel::isCompressed(format)) {
+        bool alpha = format == m3d::priv::texel::ETC1A4;
+        m3d::priv::texel::encodeEtc1(data.data(), image.data(), width, height, textureWidth, textureHeight, alpha);
+
+        // the mipmaps get filtered from the padded image, like the tiled ones of the other formats
+        std::vector<uint32_t> level(textureWidth * textureHeight, 0);
+        uint8_t* output = data.data() + textureWidth * textureHeight * m3d::priv::texel::getBitsPerTexel(format) / 8;
+
+        for (uint32_t y = 0; y < height; y++) memcpy(&level[y * textureWidth], &image[y * width], width * sizeof(uint32_t));
+
+        for (uint32_t i = 1; i < header.levels; i++) {
+            uint32_t levelWidth = textureWidth >> i, levelHeight = textureHeight >> i;
+
+            m3d::priv::mipmap::downsample(level.data(), level.data(), levelWidth * 2, levelHeight * 2);
+            m3d::priv::texel::encodeEtc1(output, level.data(), levelWidth, levelHeight, levelWidth, levelHeight, alpha);
+            output += levelWidth * levelHeight * m3d::priv::texel::getBitsPerTexel(format) / 8;
+        }
+    } else {
+        std::vector<uint32_t> columnOffsets(width);
+        std::vector<uint16_t> row(width);
+
+        m3d::priv::tiling::buildColumnOffsets(columnOffsets.data(), width);
+
+        for (uint32_t y = 0; y < height; y++) {
+            if (format == m3d::priv::texel::RGBA8) {
+                m3d::priv::tiling::writeRow(reinterpret_cast<uint32_t*>(data.data()), columnOffsets.data(), &image[y * width], width, y, textureWidth);
+            } else {
+                m3d::priv::texel::convertRow(row.data(), &image[y * width], width, format);
+                m3d::priv::tiling::writeRow(reinterpret_cast<uint16_t*>(data.data()), columnOffsets.data(), row.data(), width, y, textureWidth);
+            }
+        }
+
+        m3d::priv::mipmap::generateTiled(data.data(), textureWidth, textureHeight, format, header.levels);
+    }
+
+    file = fopen(output, "wb");
+
+    if (!file) {
+        fprintf(stderr, "error: couldn't open '%s' for writing\n", output);
+        return 1;
+    }
+
+    success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(data.data(), 1, data.size(), file) == data.size();
+
+    fclose(file);
+
+    if (!success) {
+        fprintf(stderr, "error: couldn't write '%s'\n", output);
+        return 1;
+    }
+
+    printf("%s: %ux%u (texture %ux%u), %s, %u levels, %u bytes (rgba8: %u bytes)", output, width, height, textureWidth, textureHeight, formatName, header.levels, (unsigned int) (sizeof(header) + data.size()), m3d::priv::mipmap::getTotalSize(textureWidth, textureHeight, header.levels, 32));
+
+    if (format != m3d::priv::texel::RGBA8) {
+        printf(", PSNR %.2f dB", getPsnr(image, decodeTexture(data, format, textureWidth, textureHeight), width, height, textureWidth, format));
+    }
+
+    printf("\n");
+    return 0;
+}